@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+    AudioTrace.cpp
+
+  ==============================================================================
+*/
+
+#include "AudioTrace.h"
+
+static const char* getEventName(AudioTrace::Type type)
+{
+    switch (type)
+    {
+    case AudioTrace::Type::Callback:            return "Callback";
+    case AudioTrace::Type::CallbackOverrun:     return "Callback Overrun";
+    case AudioTrace::Type::OversizeBlock:       return "Oversize Block";
+    case AudioTrace::Type::OrderChanged:        return "Order Changed";
+    case AudioTrace::Type::BypassChanged:       return "Bypass Changed";
+    case AudioTrace::Type::CoefficientsChanged: return "Coefficients Changed";
+    case AudioTrace::Type::StateRestored:       return "State Restored";
+    case AudioTrace::Type::SnapshotRecalled:    return "Snapshot Recalled";
+    case AudioTrace::Type::END_OF_LIST:         break;
+    }
+    jassertfalse;
+    return "";
+}
+
+// What the value means for each type, nullptr when it has none
+static const char* getValueName(AudioTrace::Type type)
+{
+    switch (type)
+    {
+    case AudioTrace::Type::Callback:            return "samples";
+    case AudioTrace::Type::CallbackOverrun:     return "load";
+    case AudioTrace::Type::OversizeBlock:       return "samples";
+    case AudioTrace::Type::OrderChanged:        return "slots";
+    case AudioTrace::Type::BypassChanged:       return "bypassed";
+    case AudioTrace::Type::CoefficientsChanged: return "set";
+    case AudioTrace::Type::StateRestored:
+    case AudioTrace::Type::SnapshotRecalled:
+    case AudioTrace::Type::END_OF_LIST:         break;
+    }
+    return nullptr;
+}
+
+AudioTrace::AudioTrace()
+    : juce::Thread("Audio Trace")
+{
+    auto path = juce::SystemStats::getEnvironmentVariable("MODULARFX_TRACE", {});
+    if (path.isEmpty())
+        return;
+
+    auto directory = juce::File::getCurrentWorkingDirectory().getChildFile(path);
+    directory.createDirectory();
+
+    auto file = directory.getNonexistentChildFile("ModularFX_trace", ".json", false);
+    stream = file.createOutputStream();
+    if (stream == nullptr)
+    {
+        DBG("Couldn't open trace file " << file.getFullPathName());
+        return;
+    }
+
+    // The closing bracket is optional in this format, so a file cut short by a crash still opens
+    stream->writeText("[\n", false, false, nullptr);
+    originTicks = juce::Time::getHighResolutionTicks();
+    enabled = true;
+
+    startThread(juce::Thread::Priority::background);
+}
+
+AudioTrace::~AudioTrace()
+{
+    if (enabled == false)
+        return;
+
+    stopThread(1000);
+    flush();
+}
+
+void AudioTrace::run()
+{
+    while (threadShouldExit() == false)
+    {
+        wait(FlushIntervalMs);
+        flush();
+    }
+}
+
+void AudioTrace::flush()
+{
+    auto toMicroseconds = [](juce::int64 ticks)
+        {
+            return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6;
+        };
+
+    juce::MemoryOutputStream json;
+
+    const auto write = writeIndex.load(std::memory_order_acquire);
+    auto read = readIndex.load(std::memory_order_relaxed);
+
+    for (; read != write; ++read)
+    {
+        const auto& event = events[read % Capacity];
+        const auto timestamp = toMicroseconds(event.ticks - originTicks);
+
+        json << "{\"name\":\"" << getEventName(event.type) << "\",\"pid\":1,\"tid\":1,\"ts\":" << juce::String(timestamp, 1);
+
+        if (event.durationTicks > 0)
+            json << ",\"ph\":\"X\",\"dur\":" << juce::String(toMicroseconds(event.durationTicks), 1);
+        else
+            json << ",\"ph\":\"i\",\"s\":\"t\"";
+
+        if (auto* valueName = getValueName(event.type))
+            json << ",\"args\":{\"" << valueName << "\":" << juce::String(event.value) << "}";
+
+        json << "},\n";
+    }
+
+    // The slots are free for the audio thread once the events are copied out
+    readIndex.store(read, std::memory_order_release);
+
+    if (auto dropped = numDropped.exchange(0, std::memory_order_relaxed); dropped > 0)
+    {
+        const auto now = toMicroseconds(juce::Time::getHighResolutionTicks() - originTicks);
+        json << "{\"name\":\"Dropped\",\"pid\":1,\"tid\":1,\"ph\":\"i\",\"s\":\"t\",\"ts\":" << juce::String(now, 1)
+             << ",\"args\":{\"events\":" << dropped << "}},\n";
+    }
+
+    if (json.getDataSize() == 0)
+        return;
+
+    stream->write(json.getData(), json.getDataSize());
+    stream->flush();
+}
@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    AudioTrace.h
+
+    A record of what the audio thread did, for lining dropouts up with the
+    plugin's activity on machines without a debugger. Switched on by setting
+    MODULARFX_TRACE to a directory, each instance then writes its own file
+    there in the Chrome trace format, which Perfetto and chrome://tracing open.
+
+    The audio thread writes timestamped events into a fixed ring, and never
+    waits: when the ring is full the event is dropped and counted instead.
+    A background thread empties the ring into the file a few times a second.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct AudioTrace : private juce::Thread
+{
+    enum class Type
+    {
+        Callback,               // value: samples in the block, has a duration
+        CallbackOverrun,        // value: time taken over the time the samples last
+        OversizeBlock,          // value: samples in the block
+        OrderChanged,           // value: slots in the new chain
+        BypassChanged,          // value: bit per module instance, set when bypassed
+        CoefficientsChanged,    // value: 0 for the general filter's bands, 1 for an impulse response
+        StateRestored,
+        SnapshotRecalled,
+        END_OF_LIST
+    };
+
+    static constexpr int Capacity = 8192;
+    static constexpr int FlushIntervalMs = 200;
+
+    AudioTrace();
+    ~AudioTrace() override;
+
+    bool isEnabled() const { return enabled; }
+
+    // Audio thread only, both do nothing unless the trace is enabled
+    void record(Type type, float value = 0.f) noexcept
+    {
+        if (enabled)
+            push({ type, juce::Time::getHighResolutionTicks(), 0, value });
+    }
+
+    void recordSpan(Type type, float value, juce::int64 startTicks, juce::int64 endTicks) noexcept
+    {
+        if (enabled)
+            push({ type, startTicks, endTicks - startTicks, value });
+    }
+
+private:
+    struct Event
+    {
+        Type type = Type::Callback;
+        juce::int64 ticks = 0, durationTicks = 0;
+        float value = 0.f;
+    };
+
+    void push(const Event& event) noexcept
+    {
+        const auto write = writeIndex.load(std::memory_order_relaxed);
+        if (write - readIndex.load(std::memory_order_acquire) >= static_cast<juce::uint32>(Capacity))
+        {
+            numDropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        events[write % Capacity] = event;
+        writeIndex.store(write + 1, std::memory_order_release);
+    }
+
+    bool enabled = false;
+    std::unique_ptr<juce::FileOutputStream> stream;
+    juce::int64 originTicks = 0;
+
+    std::array<Event, Capacity> events {};
+
+    // Count up forever and wrap, the difference is what's waiting
+    std::atomic<juce::uint32> writeIndex { 0 }, readIndex { 0 };
+    std::atomic<int> numDropped { 0 };
+
+    void run() override;
+    void flush();
+};
@@ -0,0 +1,230 @@
+/*
+  ==============================================================================
+
+    ConvolutionWorker.cpp
+
+  ==============================================================================
+*/
+
+#include "ConvolutionWorker.h"
+
+ConvolutionWorker::ConvolutionWorker(int chains)
+    : juce::Thread("Convolution Worker"), numChains(chains)
+{
+    // The tails have a deadline, a block after they are queued
+    startThread(juce::Thread::Priority::high);
+    loader.startThread(juce::Thread::Priority::low);
+}
+
+ConvolutionWorker::~ConvolutionWorker()
+{
+    loader.stopThread(4000);
+    stopThread(1000);
+}
+
+void ConvolutionWorker::setSampleRate(double newSampleRate)
+{
+    {
+        const juce::ScopedLock sl(lock);
+        if (newSampleRate == sampleRate)
+            return;
+
+        sampleRate = newSampleRate;
+        for (auto& request : requests)
+            request.pending = request.pending || request.file != juce::File();
+    }
+
+    loader.notify();
+}
+
+void ConvolutionWorker::requestLoad(int instance, const juce::File& file)
+{
+    jassert(juce::isPositiveAndBelow(instance, MaxInstances));
+
+    {
+        const juce::ScopedLock sl(lock);
+        auto& request = requests[static_cast<size_t>(instance)];
+        request.file = file;
+        request.pending = true;
+    }
+
+    loader.notify();
+}
+
+juce::File ConvolutionWorker::getFile(int instance) const
+{
+    jassert(juce::isPositiveAndBelow(instance, MaxInstances));
+
+    const juce::ScopedLock sl(lock);
+    return requests[static_cast<size_t>(instance)].file;
+}
+
+bool ConvolutionWorker::hasPendingLoads() const
+{
+    const juce::ScopedLock sl(lock);
+
+    // Requests wait for a rate before they load
+    auto pending = sampleRate > 0.0 && std::any_of(requests.begin(), requests.end(), [](const auto& r) { return r.pending; });
+    return pending || loading || loaded.empty() == false;
+}
+
+bool ConvolutionWorker::pullSetup(int instance, ConvolutionSetup*& setup)
+{
+    auto& fifo = toAudio[static_cast<size_t>(instance)];
+    auto pulled = false;
+
+    ConvolutionSetup* next = nullptr;
+    while (fifo.pull(next))
+    {
+        if (pulled)
+            retire(setup);
+
+        setup = next;
+        pulled = true;
+    }
+
+    return pulled;
+}
+
+void ConvolutionWorker::retire(ConvolutionSetup* setup)
+{
+    if (setup == nullptr)
+        return;
+
+    auto pushed = retired.push(setup);
+    jassert(pushed); // Kept until the worker stops, rather than freed here
+    juce::ignoreUnused(pushed);
+
+    notify();
+}
+
+//==============================================================================
+void ConvolutionWorker::Loader::run()
+{
+    while (threadShouldExit() == false)
+    {
+        int instance = -1;
+        juce::File file;
+        double rate = 0.0;
+
+        {
+            const juce::ScopedLock sl(worker.lock);
+            for (int i = 0; i < MaxInstances; ++i)
+            {
+                auto& request = worker.requests[static_cast<size_t>(i)];
+                if (request.pending && worker.sampleRate > 0.0)
+                {
+                    instance = i;
+                    file = request.file;
+                    rate = worker.sampleRate;
+                    request.pending = false;
+                    worker.loading = true;
+                    break;
+                }
+            }
+        }
+
+        if (instance < 0)
+        {
+            wait(-1);
+            continue;
+        }
+
+        // A file that can't be read unloads the instance, like an empty one
+        auto setup = file.existsAsFile() ? ConvolutionSetup::load(file, rate, worker.numChains) : nullptr;
+        if (setup == nullptr && file != juce::File())
+            DBG("Couldn't load impulse response " << file.getFullPathName());
+
+        const juce::ScopedLock sl(worker.lock);
+        worker.loading = false;
+
+        // Superseded while it loaded, the next pass loads the newer request
+        if (worker.requests[static_cast<size_t>(instance)].pending == false)
+        {
+            worker.loaded.emplace_back(instance, std::move(setup));
+            worker.notify();
+        }
+    }
+}
+
+//==============================================================================
+void ConvolutionWorker::run()
+{
+    while (threadShouldExit() == false)
+    {
+        auto stillLoaded = handOverLoaded();
+        freeRetired();
+
+        /*
+        Sleeps until a tail is queued, a setup is loaded or retired, or the
+        thread is stopped. A notify that comes in while this pass runs leaves
+        the event set, so the wait returns straight away rather than missing it.
+        */
+        if (processQueuedTails() == false)
+            wait(stillLoaded ? HandOverRetryMs : -1);
+    }
+}
+
+bool ConvolutionWorker::handOverLoaded()
+{
+    const juce::ScopedLock sl(lock);
+
+    for (auto it = loaded.begin(); it != loaded.end();)
+    {
+        auto& [instance, setup] = *it;
+
+        if (setup != nullptr)
+            setup->setTailWorker(this);
+
+        // A full Fifo is tried again next time round
+        if (toAudio[static_cast<size_t>(instance)].push(setup.get()) == false)
+        {
+            ++it;
+            continue;
+        }
+
+        if (setup != nullptr)
+            live.push_back(std::move(setup));
+
+        it = loaded.erase(it);
+    }
+
+    return loaded.empty() == false;
+}
+
+void ConvolutionWorker::freeRetired()
+{
+    ConvolutionSetup* setup = nullptr;
+    while (retired.pull(setup))
+    {
+        auto found = std::find_if(live.begin(), live.end(), [setup](const auto& s) { return s.get() == setup; });
+        jassert(found != live.end());
+
+        if (found != live.end())
+            live.erase(found);
+    }
+}
+
+bool ConvolutionWorker::processQueuedTails()
+{
+    auto processed = false;
+
+    for (auto& setup : live)
+    {
+        if (setup->hasTail() == false)
+            continue;
+
+        for (int chain = 0; chain < setup->getNumChains(); ++chain)
+        {
+            auto& tail = setup->getTail(chain);
+            if (tail.stage.load() != ConvolutionSetup::Tail::Queued)
+                continue;
+
+            setup->processTail(tail);
+            tail.stage = ConvolutionSetup::Tail::Done;
+            processed = true;
+        }
+    }
+
+    return processed;
+}
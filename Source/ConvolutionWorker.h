@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    ConvolutionWorker.h
+
+    The Convolution module's background threads. A loader reads and resamples
+    impulse responses into ConvolutionSetups, the worker hands them to the
+    audio thread through a Fifo and works out the tails the convolvers queue.
+
+    The worker owns every setup. The audio thread only ever holds raw pointers
+    and gives a setup back through retire() once no channel uses it, so setups
+    are never built or freed on the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <Fifo.h>
+#include "PartitionedConvolver.h"
+
+struct ConvolutionWorker : private juce::Thread
+{
+    static constexpr int MaxInstances = 2;
+
+    // numChains is how many channels each setup keeps tail state for
+    explicit ConvolutionWorker(int numChains);
+    ~ConvolutionWorker() override;
+
+    /*
+    Message thread. A new rate loads every instance's response again, the audio
+    thread drops setups made for another rate. An empty file unloads the instance.
+    */
+    void setSampleRate(double newSampleRate);
+    void requestLoad(int instance, const juce::File& file);
+    juce::File getFile(int instance) const;
+
+    // True until every requested response is loaded and handed to the audio thread
+    bool hasPendingLoads() const;
+
+    /*
+    Audio thread. Returns true with the newest setup for the instance when one
+    has arrived, nullptr when it was unloaded. Setups it skipped are retired.
+    */
+    bool pullSetup(int instance, ConvolutionSetup*& setup);
+    void retire(ConvolutionSetup* setup);
+
+private:
+    struct Loader : juce::Thread
+    {
+        explicit Loader(ConvolutionWorker& w) : juce::Thread("Convolution Loader"), worker(w) {}
+        void run() override;
+
+        ConvolutionWorker& worker;
+    };
+
+    struct Request
+    {
+        juce::File file;
+        bool pending = false;
+    };
+
+    const int numChains;
+
+    juce::CriticalSection lock;
+    double sampleRate = 0.0;
+    std::array<Request, MaxInstances> requests;
+    bool loading = false;
+
+    // Built by the loader, waiting for the worker to hand them over
+    std::vector<std::pair<int, std::unique_ptr<ConvolutionSetup>>> loaded;
+
+    // Only touched by the worker thread
+    std::vector<std::unique_ptr<ConvolutionSetup>> live;
+
+    std::array<SimpleMBComp::Fifo<ConvolutionSetup*>, MaxInstances> toAudio;
+    SimpleMBComp::Fifo<ConvolutionSetup*> retired;
+
+    Loader loader { *this };
+
+    // While a setup waits on a full Fifo, how often handing it over is tried again
+    static constexpr int HandOverRetryMs = 10;
+
+    void run() override;
+
+    // Returns true when setups are still waiting for room in the Fifo
+    bool handOverLoaded();
+    void freeRetired();
+    bool processQueuedTails();
+};
@@ -0,0 +1,246 @@
+/*
+  ==============================================================================
+
+    FixedRateConverter.cpp
+
+  ==============================================================================
+*/
+
+#include "FixedRateConverter.h"
+
+#include <numeric>
+
+// Zeroth order modified Bessel function of the first kind, for the Kaiser window
+static double besselI0(double x)
+{
+    auto sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50 && term > sum * 1.0e-12; ++k)
+    {
+        auto half = x / (2.0 * k);
+        term *= half * half;
+        sum += term;
+    }
+
+    return sum;
+}
+
+bool PolyphaseResampler::prepare(int inputRate, int outputRate, int maximumInputBlockSize)
+{
+    jassert(inputRate > 0 && outputRate > 0);
+
+    auto divisor = std::gcd(inputRate, outputRate);
+    upFactor = outputRate / divisor;
+    downFactor = inputRate / divisor;
+
+    if (upFactor > MaxPhases)
+        return false;
+
+    // Converting down narrows the passband, widen the filter with it to keep the transition as steep
+    tapsPerPhase = BaseTapsPerPhase * juce::jmax(1, (downFactor + upFactor - 1) / upFactor);
+
+    /*
+    The prototype lowpass runs at upFactor times the input rate. Its cutoff sits
+    a little below the lower Nyquist, so the transition band ends before it.
+    */
+    const auto length = upFactor * tapsPerPhase;
+    const auto cutoff = 0.9 * juce::jmin(1.0, static_cast<double>(upFactor) / downFactor);
+    const auto beta = 8.0;
+    const auto centre = (length - 1) * 0.5;
+
+    std::vector<double> prototype(static_cast<size_t>(length));
+    for (int i = 0; i < length; ++i)
+    {
+        // In input samples, where the sinc's zero crossings are
+        auto t = (i - centre) / upFactor;
+        auto x = juce::MathConstants<double>::pi * cutoff * t;
+        auto sinc = std::abs(x) < 1.0e-9 ? 1.0 : std::sin(x) / x;
+
+        auto ratio = 2.0 * i / (length - 1) - 1.0;
+        auto window = besselI0(beta * std::sqrt(juce::jmax(0.0, 1.0 - ratio * ratio))) / besselI0(beta);
+
+        prototype[static_cast<size_t>(i)] = cutoff * sinc * window;
+    }
+
+    coefficients.assign(static_cast<size_t>(length), 0.f);
+    for (int phase = 0; phase < upFactor; ++phase)
+    {
+        auto* row = coefficients.data() + phase * tapsPerPhase;
+
+        // Every phase passes DC at unity, otherwise the gain ripples at the ratio's beat frequency
+        auto sum = 0.0;
+        for (int k = 0; k < tapsPerPhase; ++k)
+            sum += prototype[static_cast<size_t>(phase + upFactor * (tapsPerPhase - 1 - k))];
+
+        for (int k = 0; k < tapsPerPhase; ++k)
+            row[k] = static_cast<float>(prototype[static_cast<size_t>(phase + upFactor * (tapsPerPhase - 1 - k))] / sum);
+    }
+
+    history.assign(static_cast<size_t>(tapsPerPhase - 1 + maximumInputBlockSize), 0.f);
+
+    reset();
+    return true;
+}
+
+void PolyphaseResampler::reset()
+{
+    std::fill(history.begin(), history.end(), 0.f);
+    position = static_cast<juce::int64>(tapsPerPhase - 1) * upFactor;
+}
+
+int PolyphaseResampler::getMaxOutputSamples(int numInputSamples) const
+{
+    return static_cast<int>(static_cast<juce::int64>(numInputSamples) * upFactor / downFactor) + 2;
+}
+
+double PolyphaseResampler::getLatencyInInputSamples() const
+{
+    return (upFactor * tapsPerPhase - 1) / (2.0 * upFactor);
+}
+
+int PolyphaseResampler::process(const float* input, int numInputSamples, float* output)
+{
+    const auto historySize = tapsPerPhase - 1;
+    jassert(numInputSamples <= static_cast<int>(history.size()) - historySize);
+
+    std::copy(input, input + numInputSamples, history.begin() + historySize);
+    const auto available = static_cast<juce::int64>(historySize + numInputSamples);
+
+    int numOutputSamples = 0;
+    for (;;)
+    {
+        auto newest = position / upFactor;
+        if (newest >= available)
+            break;
+
+        const auto* row = coefficients.data() + (position % upFactor) * tapsPerPhase;
+        const auto* x = history.data() + (newest - historySize);
+
+        auto sum = 0.f;
+        for (int k = 0; k < tapsPerPhase; ++k)
+            sum += row[k] * x[k];
+
+        output[numOutputSamples++] = sum;
+        position += downFactor;
+    }
+
+    // Keep the newest samples as the next block's history
+    position -= static_cast<juce::int64>(numInputSamples) * upFactor;
+    std::copy(history.begin() + numInputSamples, history.begin() + numInputSamples + historySize, history.begin());
+
+    return numOutputSamples;
+}
+
+//==============================================================================
+void FixedRateConverter::prepare(double newHostRate, double internalRate, int numChannels, int maximumBlockSize)
+{
+    hostRate = newHostRate;
+    processingRate = newHostRate;
+    maximumProcessingBlockSize = maximumBlockSize;
+    latencySamples = 0;
+    active = false;
+
+    const auto hostHz = juce::roundToInt(newHostRate);
+    const auto internalHz = juce::roundToInt(internalRate);
+    if (internalHz <= 0 || internalHz == hostHz || numChannels <= 0)
+        return;
+
+    down.resize(static_cast<size_t>(numChannels));
+    up.resize(static_cast<size_t>(numChannels));
+
+    for (auto& resampler : down)
+    {
+        if (resampler.prepare(hostHz, internalHz, maximumBlockSize) == false)
+            return;
+    }
+
+    const auto maximumInternal = down.front().getMaxOutputSamples(maximumBlockSize);
+    for (auto& resampler : up)
+    {
+        if (resampler.prepare(internalHz, hostHz, maximumInternal) == false)
+            return;
+    }
+
+    processingBuffer.setSize(numChannels, maximumInternal);
+    pending.setSize(numChannels, NumPrimingSamples + maximumBlockSize + up.front().getMaxOutputSamples(maximumInternal));
+
+    active = true;
+    processingRate = static_cast<double>(internalHz);
+    maximumProcessingBlockSize = maximumInternal;
+
+    // The way back delays by its own group delay at the internal rate, scaled to host samples
+    const auto latency = down.front().getLatencyInInputSamples()
+                       + up.front().getLatencyInInputSamples() * hostRate / processingRate
+                       + NumPrimingSamples;
+    latencySamples = juce::roundToInt(latency);
+
+    reset();
+}
+
+void FixedRateConverter::reset()
+{
+    for (auto& resampler : down)
+        resampler.reset();
+
+    for (auto& resampler : up)
+        resampler.reset();
+
+    processingBuffer.clear();
+    pending.clear();
+    numPending = NumPrimingSamples;
+}
+
+juce::dsp::AudioBlock<float> FixedRateConverter::toProcessingRate(const juce::dsp::AudioBlock<float>& hostBlock)
+{
+    if (active == false)
+        return hostBlock;
+
+    const auto numChannels = juce::jmin(static_cast<int>(hostBlock.getNumChannels()), processingBuffer.getNumChannels());
+    const auto numSamples = static_cast<int>(hostBlock.getNumSamples());
+
+    int numConverted = 0;
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        numConverted = down[static_cast<size_t>(ch)].process(hostBlock.getChannelPointer(static_cast<size_t>(ch)),
+                                                             numSamples,
+                                                             processingBuffer.getWritePointer(ch));
+    }
+
+    return juce::dsp::AudioBlock<float>(processingBuffer).getSubsetChannelBlock(0, static_cast<size_t>(numChannels))
+                                                         .getSubBlock(0, static_cast<size_t>(numConverted));
+}
+
+void FixedRateConverter::fromProcessingRate(const juce::dsp::AudioBlock<float>& processed, const juce::dsp::AudioBlock<float>& hostBlock)
+{
+    if (active == false)
+        return;
+
+    const auto numChannels = juce::jmin(static_cast<int>(processed.getNumChannels()), pending.getNumChannels());
+    const auto numSamples = static_cast<int>(hostBlock.getNumSamples());
+
+    int numConverted = 0;
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        numConverted = up[static_cast<size_t>(ch)].process(processed.getChannelPointer(static_cast<size_t>(ch)),
+                                                           static_cast<int>(processed.getNumSamples()),
+                                                           pending.getWritePointer(ch, numPending));
+    }
+
+    numPending += numConverted;
+    jassert(numPending <= pending.getNumSamples());
+
+    // The priming samples should cover any shortfall, a gap here would be a click
+    jassert(numPending >= numSamples);
+    const auto numReady = juce::jmin(numSamples, numPending);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* dest = hostBlock.getChannelPointer(static_cast<size_t>(ch));
+        auto* source = pending.getWritePointer(ch);
+
+        std::copy(source, source + numReady, dest);
+        std::fill(dest + numReady, dest + numSamples, 0.f);
+        std::copy(source + numReady, source + numPending, source);
+    }
+
+    numPending -= numReady;
+}
@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    FixedRateConverter.h
+
+    Runs the chain at a fixed internal sample rate whatever rate the host
+    plays at, so the modules sound the same in every session. Each block is
+    converted down to the internal rate, processed there and converted back.
+
+    The conversion is a polyphase windowed-sinc filter for the exact rational
+    ratio between the two rates. The filter's group delay, in both directions,
+    is reported to the host as latency. Every buffer is sized in prepare(), the
+    audio thread never allocates.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Mono streaming converter between two integer sample rates
+struct PolyphaseResampler
+{
+    // Taps per phase at the lower of the two rates, about 80 dB of stopband from the Kaiser window
+    static constexpr int BaseTapsPerPhase = 64;
+
+    // 44.1 kHz to 48 kHz needs 160, rates with fewer common factors aren't supported
+    static constexpr int MaxPhases = 1024;
+
+    // Returns false when the ratio between the rates needs more than MaxPhases phases
+    bool prepare(int inputRate, int outputRate, int maximumInputBlockSize);
+    void reset();
+
+    int getMaxOutputSamples(int numInputSamples) const;
+    double getLatencyInInputSamples() const;
+
+    // Returns how many samples were written to output, which varies from call to call
+    int process(const float* input, int numInputSamples, float* output);
+
+private:
+    int upFactor = 1, downFactor = 1;
+    int tapsPerPhase = BaseTapsPerPhase;
+
+    // upFactor rows of tapsPerPhase, each row reversed so it runs forwards over the input
+    std::vector<float> coefficients;
+
+    // The last tapsPerPhase - 1 input samples, followed by the block being converted
+    std::vector<float> history;
+
+    // The next output's position, in 1 / upFactor input samples from the start of history
+    juce::int64 position = 0;
+};
+
+struct FixedRateConverter
+{
+    // Padding on the way out, so the varying output counts never leave a block short
+    static constexpr int NumPrimingSamples = 4;
+
+    /*
+    internalRate <= 0, or one equal to the host rate, leaves the converter
+    inactive and the chain runs at the host rate, as does a ratio the
+    resampler can't handle.
+    */
+    void prepare(double hostRate, double internalRate, int numChannels, int maximumBlockSize);
+    void reset();
+
+    bool isActive() const { return active; }
+
+    // The rate the chain runs at, and the most samples it gets in one block
+    double getProcessingRate() const { return processingRate; }
+    int getMaximumProcessingBlockSize() const { return maximumProcessingBlockSize; }
+
+    // Processing rate / host rate, for converting sample offsets
+    double getRateRatio() const { return processingRate / hostRate; }
+
+    // Round trip, in host samples
+    int getLatencySamples() const { return latencySamples; }
+
+    // Returns the block to run the chain on: hostBlock itself when inactive
+    juce::dsp::AudioBlock<float> toProcessingRate(const juce::dsp::AudioBlock<float>& hostBlock);
+
+    // Converts the processed block back, filling hostBlock completely
+    void fromProcessingRate(const juce::dsp::AudioBlock<float>& processed, const juce::dsp::AudioBlock<float>& hostBlock);
+
+private:
+    bool active = false;
+    double hostRate = 44100.0, processingRate = 44100.0;
+    int maximumProcessingBlockSize = 0;
+    int latencySamples = 0;
+
+    std::vector<PolyphaseResampler> down, up;
+    juce::AudioBuffer<float> processingBuffer;
+
+    // Converted back to the host rate, waiting to be handed out
+    juce::AudioBuffer<float> pending;
+    int numPending = 0;
+};
@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    LatencyCompensationDelay.h
+
+    Integer delay used to keep the dry signal aligned with a processing
+    chain that reports latency. Memory is allocated in prepare() only; blocks
+    go in and out of the ring with straight copies, no per-sample work.
+
+    The delay can be changed up to the maximum given to prepare(). The ring
+    keeps running, so reading continues from the history at the new delay.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct LatencyCompensationDelay
+{
+    void prepare(int numChannels, int maximumBlockSize, int newDelaySamples, int newMaximumDelaySamples = -1)
+    {
+        jassert(newDelaySamples >= 0);
+        delaySamples = newDelaySamples;
+        maximumDelaySamples = juce::jmax(newDelaySamples, newMaximumDelaySamples);
+
+        // Power of two so the read and write positions wrap with a mask
+        auto size = juce::nextPowerOfTwo(juce::jmax(1, maximumDelaySamples + maximumBlockSize));
+        ring.setSize(numChannels, size);
+        mask = size - 1;
+
+        reset();
+    }
+
+    void reset()
+    {
+        ring.clear();
+        writePosition = 0;
+    }
+
+    int getDelaySamples() const { return delaySamples; }
+
+    void setDelaySamples(int newDelaySamples)
+    {
+        jassert(juce::isPositiveAndNotGreaterThan(newDelaySamples, maximumDelaySamples));
+        delaySamples = juce::jlimit(0, maximumDelaySamples, newDelaySamples);
+    }
+
+    // Every block of the signal has to be pushed, even when it isn't read back
+    void push(const juce::dsp::AudioBlock<float>& block)
+    {
+        if (maximumDelaySamples == 0)
+            return;
+
+        const auto numSamples = static_cast<int>(block.getNumSamples());
+        jassert(numSamples + maximumDelaySamples <= ring.getNumSamples());
+
+        const auto numChannels = juce::jmin(static_cast<int>(block.getNumChannels()), ring.getNumChannels());
+        for (int ch = 0; ch < numChannels; ++ch)
+            copyIntoRing(ch, block.getChannelPointer(static_cast<size_t>(ch)), numSamples);
+
+        writePosition = (writePosition + numSamples) & mask;
+    }
+
+    /*
+    Reads the last pushed block, delayed by delaySamples.
+    With no delay dest is left untouched, so copy the block into it first.
+    */
+    void read(const juce::dsp::AudioBlock<float>& dest) const
+    {
+        const auto numSamples = static_cast<int>(dest.getNumSamples());
+        const auto numChannels = juce::jmin(static_cast<int>(dest.getNumChannels()), ring.getNumChannels());
+
+        if (delaySamples == 0)
+            return;
+
+        const auto readPosition = (writePosition - numSamples - delaySamples) & mask;
+        for (int ch = 0; ch < numChannels; ++ch)
+            copyFromRing(ch, readPosition, dest.getChannelPointer(static_cast<size_t>(ch)), numSamples);
+    }
+
+private:
+    juce::AudioBuffer<float> ring;
+    int mask = 0;
+    int writePosition = 0;
+    int delaySamples = 0, maximumDelaySamples = 0;
+
+    void copyIntoRing(int channel, const float* src, int numSamples)
+    {
+        auto firstPart = juce::jmin(numSamples, ring.getNumSamples() - writePosition);
+        auto* dst = ring.getWritePointer(channel);
+        juce::FloatVectorOperations::copy(dst + writePosition, src, firstPart);
+        juce::FloatVectorOperations::copy(dst, src + firstPart, numSamples - firstPart);
+    }
+
+    void copyFromRing(int channel, int readPosition, float* dst, int numSamples) const
+    {
+        auto firstPart = juce::jmin(numSamples, ring.getNumSamples() - readPosition);
+        auto* src = ring.getReadPointer(channel);
+        juce::FloatVectorOperations::copy(dst, src + readPosition, firstPart);
+        juce::FloatVectorOperations::copy(dst + firstPart, src, numSamples - firstPart);
+    }
+};
@@ -0,0 +1,229 @@
+/*
+  ==============================================================================
+
+    LinearPhaseConvolver.cpp
+
+  ==============================================================================
+*/
+
+#include "LinearPhaseConvolver.h"
+
+#include <complex>
+
+LinearPhaseKernel::LinearPhaseKernel()
+{
+    makeFlat();
+}
+
+void LinearPhaseKernel::design(const ParametricEq::Coefficients* bands, int numBands)
+{
+    // Sampled twice as finely as the taps, so truncating the response barely aliases it
+    constexpr int designOrder = 13;
+    constexpr int designSize = 1 << designOrder;
+    static_assert(designSize >= 2 * NumTaps);
+
+    std::vector<float> buffer(static_cast<size_t>(2 * designSize), 0.f);
+    for (int k = 0; k <= designSize / 2; ++k)
+    {
+        const auto w = juce::MathConstants<double>::twoPi * k / designSize;
+        const auto z1 = std::polar(1.0, -w), z2 = std::polar(1.0, -2.0 * w);
+
+        auto magnitude = 1.0;
+        for (int band = 0; band < numBands; ++band)
+        {
+            const auto& c = bands[band];
+            const auto numerator = static_cast<double>(c.b0) + static_cast<double>(c.b1) * z1 + static_cast<double>(c.b2) * z2;
+            const auto denominator = 1.0 + static_cast<double>(c.a1) * z1 + static_cast<double>(c.a2) * z2;
+            magnitude *= std::abs(numerator / denominator);
+        }
+
+        // Zero phase, the impulse comes out centred on sample 0
+        buffer[static_cast<size_t>(2 * k)] = static_cast<float>(magnitude);
+    }
+
+    juce::dsp::FFT(designOrder).performRealOnlyInverseTransform(buffer.data());
+
+    std::vector<float> taps(static_cast<size_t>(NumPartitions * PartitionSize), 0.f);
+    const auto centre = (NumTaps - 1) / 2;
+    for (int n = 0; n < NumTaps; ++n)
+    {
+        const auto phase = juce::MathConstants<double>::twoPi * n / (NumTaps - 1);
+        const auto window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+        const auto source = (n - centre + designSize) % designSize;
+        taps[static_cast<size_t>(n)] = static_cast<float>(buffer[static_cast<size_t>(source)] * window);
+    }
+
+    setTaps(taps);
+}
+
+void LinearPhaseKernel::makeFlat()
+{
+    std::vector<float> taps(static_cast<size_t>(NumPartitions * PartitionSize), 0.f);
+    taps[static_cast<size_t>((NumTaps - 1) / 2)] = 1.f;
+    setTaps(taps);
+}
+
+void LinearPhaseKernel::setTaps(const std::vector<float>& taps)
+{
+    juce::dsp::FFT fft(FftOrder);
+    std::vector<float> buffer(static_cast<size_t>(2 * FftSize));
+    spectra.resize(static_cast<size_t>(NumPartitions * NumBins * 2));
+
+    // Each partition zero padded to the transform size, for overlap-save
+    for (int p = 0; p < NumPartitions; ++p)
+    {
+        std::fill(buffer.begin(), buffer.end(), 0.f);
+        std::copy_n(taps.begin() + p * PartitionSize, PartitionSize, buffer.begin());
+        fft.performRealOnlyForwardTransform(buffer.data(), true);
+        std::copy_n(buffer.begin(), NumBins * 2, spectra.begin() + p * NumBins * 2);
+    }
+}
+
+//==============================================================================
+void LinearPhaseKernelExchange::publish()
+{
+    // Takes back whichever kernel was waiting, read or not
+    writeIndex = middle.exchange(writeIndex | NewBit) & IndexMask;
+}
+
+void LinearPhaseKernelExchange::acquire()
+{
+    if ((middle.load() & NewBit) == 0)
+        return;
+
+    readIndex = middle.exchange(readIndex) & IndexMask;
+    ++version;
+}
+
+//==============================================================================
+void LinearPhaseConvolver::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.numChannels == 1);
+    juce::ignoreUnused(spec);
+
+    if (kernels == nullptr)
+        return;
+
+    constexpr auto partition = static_cast<size_t>(LinearPhaseKernel::PartitionSize);
+    constexpr auto spectrum = static_cast<size_t>(LinearPhaseKernel::NumBins * 2);
+
+    fft = std::make_unique<juce::dsp::FFT>(LinearPhaseKernel::FftOrder);
+    input.assign(2 * partition, 0.f);
+    output.assign(partition, 0.f);
+    delayLine.assign(spectrum * LinearPhaseKernel::NumPartitions, 0.f);
+    fftBuffer.assign(2 * LinearPhaseKernel::FftSize, 0.f);
+    fadeBuffer.assign(partition, 0.f);
+
+    for (auto& kernel : ownKernels)
+        kernel.assign(spectrum * LinearPhaseKernel::NumPartitions, 0.f);
+
+    reset();
+}
+
+void LinearPhaseConvolver::reset()
+{
+    std::fill(input.begin(), input.end(), 0.f);
+    std::fill(output.begin(), output.end(), 0.f);
+    std::fill(delayLine.begin(), delayLine.end(), 0.f);
+    position = 0;
+    delayLineHead = 0;
+
+    // The next partition picks up a kernel without fading from the old one
+    kernelVersion = NoKernel;
+}
+
+void LinearPhaseConvolver::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    if (kernels == nullptr || fft == nullptr)
+    {
+        jassertfalse; // Not prepared for linear phase
+        return;
+    }
+
+    auto& block = context.getOutputBlock();
+    jassert(block.getNumChannels() == 1);
+
+    auto* data = block.getChannelPointer(0);
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+    constexpr auto partition = LinearPhaseKernel::PartitionSize;
+
+    for (int done = 0; done < numSamples;)
+    {
+        const auto count = juce::jmin(numSamples - done, partition - position);
+
+        std::copy_n(data + done, count, input.begin() + partition + position);
+        std::copy_n(output.begin() + position, count, data + done);
+
+        position += count;
+        done += count;
+
+        if (position == partition)
+        {
+            processPartition(context.isBypassed);
+            position = 0;
+        }
+    }
+}
+
+void LinearPhaseConvolver::processPartition(bool bypassed)
+{
+    constexpr auto partition = LinearPhaseKernel::PartitionSize;
+    constexpr auto spectrum = LinearPhaseKernel::NumBins * 2;
+
+    std::fill(fftBuffer.begin(), fftBuffer.end(), 0.f);
+    std::copy(input.begin(), input.end(), fftBuffer.begin());
+    fft->performRealOnlyForwardTransform(fftBuffer.data(), true);
+
+    delayLineHead = (delayLineHead + 1) % LinearPhaseKernel::NumPartitions;
+    std::copy_n(fftBuffer.begin(), spectrum, delayLine.begin() + delayLineHead * spectrum);
+
+    // The partition just filled becomes the first half of the next window
+    std::copy(input.begin() + partition, input.end(), input.begin());
+
+    const auto targetVersion = bypassed ? FlatKernel : kernels->getVersion();
+    auto fading = false;
+    if (targetVersion != kernelVersion)
+    {
+        const auto& target = bypassed ? kernels->getFlat() : kernels->getLatest();
+
+        fading = kernelVersion != NoKernel;
+        activeKernel = 1 - activeKernel;
+        kernelVersion = targetVersion;
+        std::copy(target.spectra.begin(), target.spectra.end(), ownKernels[static_cast<size_t>(activeKernel)].begin());
+    }
+
+    convolve(ownKernels[static_cast<size_t>(activeKernel)], output.data());
+
+    if (fading)
+    {
+        convolve(ownKernels[static_cast<size_t>(1 - activeKernel)], fadeBuffer.data());
+        SimdKernels::crossfade(output.data(), fadeBuffer.data(), partition, 0.f, 1.f / static_cast<float>(partition));
+    }
+}
+
+void LinearPhaseConvolver::convolve(const std::vector<float>& kernel, float* dest)
+{
+    constexpr auto numPartitions = LinearPhaseKernel::NumPartitions;
+    constexpr auto spectrum = LinearPhaseKernel::NumBins * 2;
+
+    std::fill(fftBuffer.begin(), fftBuffer.end(), 0.f);
+    auto* sum = fftBuffer.data();
+
+    // The newest input against the first partition of the kernel, older input against later ones
+    for (int p = 0; p < numPartitions; ++p)
+    {
+        const auto* x = delayLine.data() + ((delayLineHead - p + numPartitions) % numPartitions) * spectrum;
+        const auto* h = kernel.data() + p * spectrum;
+
+        for (int k = 0; k < spectrum; k += 2)
+        {
+            sum[k] += x[k] * h[k] - x[k + 1] * h[k + 1];
+            sum[k + 1] += x[k] * h[k + 1] + x[k + 1] * h[k];
+        }
+    }
+
+    fft->performRealOnlyInverseTransform(fftBuffer.data());
+
+    // Overlap-save: the first half wraps around, the second half is this partition's output
+    std::copy_n(fftBuffer.begin() + LinearPhaseKernel::PartitionSize, LinearPhaseKernel::PartitionSize, dest);
+}
@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    LinearPhaseConvolver.h
+
+    The general filter's linear phase mode. The EQ's magnitude response is
+    turned into a symmetric FIR on the message thread, split into partitions
+    and transformed once. The audio thread applies it by uniformly partitioned
+    overlap-save convolution: each partition of input is transformed once,
+    kept in a frequency-domain delay line and multiplied by every partition of
+    the kernel.
+
+    Kernels reach the audio thread through a triple buffer, each convolver
+    copies the newest into the spare of its own two and crossfades to it over
+    one partition. Bypass fades to a flat kernel, so the latency never changes
+    while playing. Every buffer is sized in prepare().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParametricEq.h"
+
+struct LinearPhaseKernel
+{
+    static constexpr int PartitionSize = 256;
+    static constexpr int NumPartitions = 16;
+    static constexpr int FftOrder = 9; // Two partitions
+    static constexpr int FftSize = 1 << FftOrder;
+    static constexpr int NumBins = FftSize / 2 + 1;
+
+    // Odd, so the centre tap and the delay fall on whole samples
+    static constexpr int NumTaps = PartitionSize * NumPartitions - 1;
+
+    // The FIR's group delay, plus the partition the convolver buffers
+    static constexpr int LatencySamples = PartitionSize + (NumTaps - 1) / 2;
+
+    LinearPhaseKernel();
+
+    // Message thread: the magnitude of the bands in series, with a Blackman window on the taps
+    void design(const ParametricEq::Coefficients* bands, int numBands);
+
+    // A delay of the same length, what bypass fades to
+    void makeFlat();
+
+    // NumPartitions spectra of NumBins bins, interleaved real and imaginary as juce::dsp::FFT leaves them
+    std::vector<float> spectra;
+
+private:
+    void setTaps(const std::vector<float>& taps);
+};
+
+// One writer on the message thread, one reader on the audio thread. Every kernel starts flat
+struct LinearPhaseKernelExchange
+{
+    // Message thread: fill the kernel beginWrite() returns, then publish() it
+    LinearPhaseKernel& beginWrite() { return kernels[static_cast<size_t>(writeIndex)]; }
+    void publish();
+
+    // Audio thread, once per block. The kernel getLatest() returns stays put until the next call
+    void acquire();
+    const LinearPhaseKernel& getLatest() const { return kernels[static_cast<size_t>(readIndex)]; }
+    int getVersion() const { return version; }
+
+    const LinearPhaseKernel& getFlat() const { return flat; }
+
+private:
+    static constexpr int NewBit = 4, IndexMask = 3;
+
+    std::array<LinearPhaseKernel, 3> kernels;
+    LinearPhaseKernel flat;
+
+    int writeIndex = 0, readIndex = 1;
+    std::atomic<int> middle { 2 };
+    int version = 0;
+};
+
+struct LinearPhaseConvolver
+{
+    // Set before prepare(), which only allocates for a convolver with a source
+    void setKernels(const LinearPhaseKernelExchange* source) { kernels = source; }
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    // A bypassed context fades to the flat kernel rather than skipping, the output stays delayed
+    void process(const juce::dsp::ProcessContextReplacing<float>& context);
+
+private:
+    static constexpr int NoKernel = -2, FlatKernel = -1;
+
+    const LinearPhaseKernelExchange* kernels = nullptr;
+    std::unique_ptr<juce::dsp::FFT> fft;
+
+    // The previous partition of input followed by the one being filled
+    std::vector<float> input;
+
+    // Handed out while the next partition comes in
+    std::vector<float> output;
+    int position = 0;
+
+    // NumPartitions spectra of past input, the newest at delayLineHead
+    std::vector<float> delayLine;
+    int delayLineHead = 0;
+
+    std::vector<float> fftBuffer, fadeBuffer;
+
+    std::array<std::vector<float>, 2> ownKernels;
+    int activeKernel = 0;
+    int kernelVersion = NoKernel;
+
+    void processPartition(bool bypassed);
+    void convolve(const std::vector<float>& kernel, float* dest);
+};
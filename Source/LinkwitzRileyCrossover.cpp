@@ -0,0 +1,233 @@
+/*
+  ==============================================================================
+
+    LinkwitzRileyCrossover.cpp
+
+  ==============================================================================
+*/
+
+#include "LinkwitzRileyCrossover.h"
+
+namespace
+{
+    enum class Response
+    {
+        Lowpass,
+        Highpass,
+        Allpass
+    };
+
+    constexpr double ButterworthQ = 0.70710678118654752;
+
+    // Bilinear transform designs with Butterworth Q, two in series make the Linkwitz-Riley slopes
+    void setLane(SimdKernels::BiquadLanes& filters, int lane, Response response, double frequency, double sampleRate)
+    {
+        const auto w = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const auto cosW = std::cos(w);
+        const auto alpha = std::sin(w) / (2.0 * ButterworthQ);
+        const auto a0 = 1.0 + alpha;
+
+        double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+        switch (response)
+        {
+        case Response::Lowpass:
+            b0 = b2 = (1.0 - cosW) * 0.5;
+            b1 = 1.0 - cosW;
+            break;
+        case Response::Highpass:
+            b0 = b2 = (1.0 + cosW) * 0.5;
+            b1 = -(1.0 + cosW);
+            break;
+        case Response::Allpass:
+            b0 = 1.0 - alpha;
+            b1 = -2.0 * cosW;
+            b2 = 1.0 + alpha;
+            break;
+        }
+
+        const auto k = static_cast<size_t>(lane);
+        filters.b0[k] = static_cast<float>(b0 / a0);
+        filters.b1[k] = static_cast<float>(b1 / a0);
+        filters.b2[k] = static_cast<float>(b2 / a0);
+        filters.a1[k] = static_cast<float>(-2.0 * cosW / a0);
+        filters.a2[k] = static_cast<float>((1.0 - alpha) / a0);
+    }
+
+    void clearState(SimdKernels::BiquadLanes& filters)
+    {
+        std::fill(std::begin(filters.z1), std::end(filters.z1), 0.f);
+        std::fill(std::begin(filters.z2), std::end(filters.z2), 0.f);
+    }
+}
+
+void LinkwitzRileyCrossover::prepare(double newSampleRate, int maximumBlockSize)
+{
+    sampleRate = newSampleRate;
+
+    for (auto& band : bands)
+        band.setSize(NumChannels, maximumBlockSize);
+
+    lanes.assign(static_cast<size_t>(maximumBlockSize * SimdKernels::NumBiquadLanes), 0.f);
+
+    for (auto& frequency : frequencies)
+    {
+        frequency.reset(sampleRate, 0.05);
+        frequency.setCurrentAndTargetValue(frequency.getTargetValue() > 0.f ? frequency.getTargetValue() : 1000.f);
+    }
+
+    updateCoefficients(0);
+    reset();
+}
+
+void LinkwitzRileyCrossover::reset()
+{
+    for (auto& split : splits)
+    {
+        clearState(split.first);
+        clearState(split.second);
+        clearState(split.allpass);
+    }
+}
+
+void LinkwitzRileyCrossover::setBands(int newNumBands, const std::array<float, MaxSplits>& newFrequencies)
+{
+    newNumBands = juce::jlimit(1, MaxBands, newNumBands);
+
+    // A third of an octave apart, and clear of Nyquist so the bilinear warping stays mild
+    const auto minimumRatio = std::pow(2.f, 1.f / 3.f);
+    auto highest = static_cast<float>(sampleRate * 0.45);
+    auto lowest = 20.f;
+
+    for (size_t i = 0; i < frequencies.size(); ++i)
+    {
+        auto frequency = juce::jlimit(lowest, highest, newFrequencies[i]);
+        frequencies[i].setTargetValue(frequency);
+        lowest = frequency * minimumRatio;
+    }
+
+    if (newNumBands != numBands)
+    {
+        numBands = newNumBands;
+
+        for (auto& frequency : frequencies)
+            frequency.setCurrentAndTargetValue(frequency.getTargetValue());
+
+        updateCoefficients(0);
+        reset();
+    }
+}
+
+void LinkwitzRileyCrossover::updateCoefficients(int numSamples)
+{
+    for (size_t i = 0; i < splits.size(); ++i)
+    {
+        auto& split = splits[i];
+        auto frequency = static_cast<double>(frequencies[i].skip(numSamples));
+
+        for (int channel = 0; channel < NumChannels; ++channel)
+        {
+            for (auto* section : { &split.first, &split.second })
+            {
+                setLane(*section, channel, Response::Lowpass, frequency, sampleRate);
+                setLane(*section, channel + NumChannels, Response::Highpass, frequency, sampleRate);
+            }
+        }
+
+        for (int lane = 0; lane < SimdKernels::NumBiquadLanes; ++lane)
+            setLane(split.allpass, lane, Response::Allpass, frequency, sampleRate);
+    }
+}
+
+void LinkwitzRileyCrossover::process(const juce::dsp::AudioBlock<float>& input)
+{
+    const auto numSamples = static_cast<int>(input.getNumSamples());
+    jassert(numSamples * SimdKernels::NumBiquadLanes <= static_cast<int>(lanes.size()));
+    jassert(input.getNumChannels() >= NumChannels);
+
+    updateCoefficients(numSamples);
+
+    auto& remainder = bands[static_cast<size_t>(numBands - 1)];
+    for (int ch = 0; ch < NumChannels; ++ch)
+        remainder.copyFrom(ch, 0, input.getChannelPointer(static_cast<size_t>(ch)), numSamples);
+
+    for (int i = 0; i < numBands - 1; ++i)
+    {
+        if (i > 0)
+            applyAllpass(i, numSamples);
+
+        split(i, numSamples);
+    }
+}
+
+juce::dsp::AudioBlock<float> LinkwitzRileyCrossover::getBand(int band, size_t startSample, size_t numSamples)
+{
+    jassert(juce::isPositiveAndBelow(band, numBands));
+    return juce::dsp::AudioBlock<float>(bands[static_cast<size_t>(band)]).getSubBlock(startSample, numSamples);
+}
+
+void LinkwitzRileyCrossover::applyAllpass(int index, int numSamples)
+{
+    constexpr auto numLanes = SimdKernels::NumBiquadLanes;
+
+    // Every band already split off sees this split's phase shift too, two bands per pass
+    const auto numLowerBands = juce::jmin(index, numLanes / NumChannels);
+    jassert(numLowerBands == index);
+
+    std::fill(lanes.begin(), lanes.begin() + numSamples * numLanes, 0.f);
+    for (int band = 0; band < numLowerBands; ++band)
+    {
+        for (int ch = 0; ch < NumChannels; ++ch)
+        {
+            const auto* source = bands[static_cast<size_t>(band)].getReadPointer(ch);
+            const auto lane = band * NumChannels + ch;
+            for (int i = 0; i < numSamples; ++i)
+                lanes[static_cast<size_t>(i * numLanes + lane)] = source[i];
+        }
+    }
+
+    SimdKernels::get().biquadLanes(lanes.data(), numSamples, splits[static_cast<size_t>(index)].allpass);
+
+    for (int band = 0; band < numLowerBands; ++band)
+    {
+        for (int ch = 0; ch < NumChannels; ++ch)
+        {
+            auto* dest = bands[static_cast<size_t>(band)].getWritePointer(ch);
+            const auto lane = band * NumChannels + ch;
+            for (int i = 0; i < numSamples; ++i)
+                dest[i] = lanes[static_cast<size_t>(i * numLanes + lane)];
+        }
+    }
+}
+
+void LinkwitzRileyCrossover::split(int index, int numSamples)
+{
+    constexpr auto numLanes = SimdKernels::NumBiquadLanes;
+    auto& remainder = bands[static_cast<size_t>(numBands - 1)];
+    auto& low = bands[static_cast<size_t>(index)];
+
+    // The same input goes to the lowpass and highpass lanes
+    for (int ch = 0; ch < NumChannels; ++ch)
+    {
+        const auto* source = remainder.getReadPointer(ch);
+        for (int i = 0; i < numSamples; ++i)
+        {
+            lanes[static_cast<size_t>(i * numLanes + ch)] = source[i];
+            lanes[static_cast<size_t>(i * numLanes + ch + NumChannels)] = source[i];
+        }
+    }
+
+    auto& filters = splits[static_cast<size_t>(index)];
+    SimdKernels::get().biquadLanes(lanes.data(), numSamples, filters.first);
+    SimdKernels::get().biquadLanes(lanes.data(), numSamples, filters.second);
+
+    for (int ch = 0; ch < NumChannels; ++ch)
+    {
+        auto* lowDest = low.getWritePointer(ch);
+        auto* highDest = remainder.getWritePointer(ch);
+        for (int i = 0; i < numSamples; ++i)
+        {
+            lowDest[i] = lanes[static_cast<size_t>(i * numLanes + ch)];
+            highDest[i] = lanes[static_cast<size_t>(i * numLanes + ch + NumChannels)];
+        }
+    }
+}
@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    LinkwitzRileyCrossover.h
+
+    Splits a stereo signal into up to four bands with 4th order Linkwitz-Riley
+    crossovers. Each split is a pair of Butterworth sections, lowpass on two
+    lanes and highpass on the other two, run together through the biquadLanes
+    kernel.
+
+    The low band of each split is passed through the allpass that the later
+    splits apply to the bands above it, so the bands stay in phase and sum
+    back to a flat response. Memory is allocated in prepare() only.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SimdKernels.h"
+
+struct LinkwitzRileyCrossover
+{
+    static constexpr int MaxBands = 4;
+    static constexpr int MaxSplits = MaxBands - 1;
+
+    void prepare(double sampleRate, int maximumBlockSize);
+    void reset();
+
+    /*
+    Frequencies are kept in order and at least a third of an octave apart.
+    Changing the number of bands resets the filters, moving a frequency glides.
+    */
+    void setBands(int numBands, const std::array<float, MaxSplits>& frequencies);
+    int getNumBands() const { return numBands; }
+
+    // Splits the first two channels of input, the bands are then read with getBand()
+    void process(const juce::dsp::AudioBlock<float>& input);
+
+    juce::dsp::AudioBlock<float> getBand(int band, size_t startSample, size_t numSamples);
+
+private:
+    static constexpr int NumChannels = 2;
+
+    double sampleRate = 44100.0;
+    int numBands = 1;
+
+    std::array<juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative>, MaxSplits> frequencies;
+
+    struct Split
+    {
+        // Lanes 0 and 1 are the lowpass for left and right, 2 and 3 the highpass
+        SimdKernels::BiquadLanes first, second;
+
+        // For the bands below this split, two bands of left and right
+        SimdKernels::BiquadLanes allpass;
+    };
+
+    std::array<Split, MaxSplits> splits;
+
+    // The last active band's buffer holds what is still to be split
+    std::array<juce::AudioBuffer<float>, MaxBands> bands;
+    std::vector<float> lanes;
+
+    void updateCoefficients(int numSamples);
+    void applyAllpass(int split, int numSamples);
+    void split(int split, int numSamples);
+};
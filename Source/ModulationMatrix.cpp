@@ -0,0 +1,330 @@
+/*
+  ==============================================================================
+
+    ModulationMatrix.cpp
+
+  ==============================================================================
+*/
+
+#include "ModulationMatrix.h"
+
+static juce::String getLfoRateName(int lfo) { return "LFO " + juce::String(lfo + 1) + " Rate (Hz)"; }
+static juce::String getLfoShapeName(int lfo) { return "LFO " + juce::String(lfo + 1) + " Shape"; }
+static juce::String getEnvelopeAttackName(int env) { return "Envelope " + juce::String(env + 1) + " Attack (ms)"; }
+static juce::String getEnvelopeReleaseName(int env) { return "Envelope " + juce::String(env + 1) + " Release (ms)"; }
+static const juce::String sidechainAttackName = "Sidechain Attack (ms)";
+static const juce::String sidechainReleaseName = "Sidechain Release (ms)";
+static juce::String getRouteSourceName(int route) { return "Mod " + juce::String(route + 1) + " Source"; }
+static juce::String getRouteTargetName(int route) { return "Mod " + juce::String(route + 1) + " Target"; }
+static juce::String getRouteDepthName(int route) { return "Mod " + juce::String(route + 1) + " Depth (%)"; }
+
+static juce::StringArray getLfoShapeChoices()
+{
+    return juce::StringArray
+    {
+        "Sine",
+        "Triangle",
+        "Saw",
+        "Square"
+    };
+}
+
+static juce::StringArray getSourceChoices()
+{
+    juce::StringArray choices { "None" };
+    for (int i = 0; i < ModulationMatrix::NumLfos; ++i)
+        choices.add("LFO " + juce::String(i + 1));
+    for (int i = 0; i < ModulationMatrix::NumEnvelopes; ++i)
+        choices.add("Envelope " + juce::String(i + 1));
+    choices.add("Sidechain");
+    return choices;
+}
+
+template<typename ParamType>
+static ParamType* getCachedParam(juce::AudioProcessorValueTreeState& apvts, const juce::String& name)
+{
+    auto* param = dynamic_cast<ParamType*>(apvts.getParameter(name));
+    jassert(param != nullptr); // addParameters() wasn't called for this layout
+    return param;
+}
+
+//==============================================================================
+void ModulationMatrix::addParameters(juce::AudioProcessorValueTreeState::ParameterLayout& layout,
+                                     const juce::StringArray& targetNames,
+                                     int versionHint)
+{
+    jassert(targetNames.size() <= MaxTargets);
+
+    for (int i = 0; i < NumLfos; ++i)
+    {
+        auto name = getLfoRateName(i);
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID{ name, versionHint },
+            name,
+            juce::NormalisableRange<float>(0.01f, 20.f, 0.01f, .3f),
+            1.f,
+            "Hz"
+        ));
+
+        name = getLfoShapeName(i);
+        layout.add(std::make_unique<juce::AudioParameterChoice>(
+            juce::ParameterID{ name, versionHint },
+            name,
+            getLfoShapeChoices(),
+            0 // Default to Sine
+        ));
+    }
+
+    for (int i = 0; i < NumEnvelopes; ++i)
+    {
+        auto name = getEnvelopeAttackName(i);
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID{ name, versionHint },
+            name,
+            juce::NormalisableRange<float>(1.f, 500.f, 0.1f, .4f),
+            10.f,
+            "ms"
+        ));
+
+        name = getEnvelopeReleaseName(i);
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID{ name, versionHint },
+            name,
+            juce::NormalisableRange<float>(1.f, 2000.f, 0.1f, .4f),
+            150.f,
+            "ms"
+        ));
+    }
+
+    // Ducking wants a quick attack and a release long enough not to pump
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ sidechainAttackName, versionHint },
+        sidechainAttackName,
+        juce::NormalisableRange<float>(0.1f, 500.f, 0.1f, .4f),
+        5.f,
+        "ms"
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ sidechainReleaseName, versionHint },
+        sidechainReleaseName,
+        juce::NormalisableRange<float>(1.f, 2000.f, 0.1f, .4f),
+        200.f,
+        "ms"
+    ));
+
+    auto targetChoices = juce::StringArray { "None" };
+    targetChoices.addArray(targetNames);
+
+    for (int i = 0; i < NumRoutes; ++i)
+    {
+        auto name = getRouteSourceName(i);
+        layout.add(std::make_unique<juce::AudioParameterChoice>(
+            juce::ParameterID{ name, versionHint },
+            name,
+            getSourceChoices(),
+            0
+        ));
+
+        name = getRouteTargetName(i);
+        layout.add(std::make_unique<juce::AudioParameterChoice>(
+            juce::ParameterID{ name, versionHint },
+            name,
+            targetChoices,
+            0
+        ));
+
+        name = getRouteDepthName(i);
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID{ name, versionHint },
+            name,
+            juce::NormalisableRange<float>(-100.f, 100.f, 0.1f, 1.f),
+            0.f,
+            "%"
+        ));
+    }
+}
+
+void ModulationMatrix::attachParameters(juce::AudioProcessorValueTreeState& apvts)
+{
+    for (int i = 0; i < NumLfos; ++i)
+    {
+        lfoRates[static_cast<size_t>(i)] = getCachedParam<juce::AudioParameterFloat>(apvts, getLfoRateName(i));
+        lfoShapes[static_cast<size_t>(i)] = getCachedParam<juce::AudioParameterChoice>(apvts, getLfoShapeName(i));
+    }
+
+    for (int i = 0; i < NumEnvelopes; ++i)
+    {
+        envelopeAttacks[static_cast<size_t>(i)] = getCachedParam<juce::AudioParameterFloat>(apvts, getEnvelopeAttackName(i));
+        envelopeReleases[static_cast<size_t>(i)] = getCachedParam<juce::AudioParameterFloat>(apvts, getEnvelopeReleaseName(i));
+    }
+
+    sidechainAttack = getCachedParam<juce::AudioParameterFloat>(apvts, sidechainAttackName);
+    sidechainRelease = getCachedParam<juce::AudioParameterFloat>(apvts, sidechainReleaseName);
+
+    for (int i = 0; i < NumRoutes; ++i)
+    {
+        routeSources[static_cast<size_t>(i)] = getCachedParam<juce::AudioParameterChoice>(apvts, getRouteSourceName(i));
+        routeTargets[static_cast<size_t>(i)] = getCachedParam<juce::AudioParameterChoice>(apvts, getRouteTargetName(i));
+        routeDepths[static_cast<size_t>(i)] = getCachedParam<juce::AudioParameterFloat>(apvts, getRouteDepthName(i));
+    }
+}
+
+void ModulationMatrix::prepare(double newSampleRate, double newSidechainSampleRate)
+{
+    sampleRate = newSampleRate;
+    sidechainSampleRate = newSidechainSampleRate;
+    reset();
+}
+
+void ModulationMatrix::reset()
+{
+    lfoPhases.fill(0.f);
+    envelopeLevels.fill(0.f);
+    sidechainLevel = 0.f;
+    sourceValues.fill(0.f);
+}
+
+void ModulationMatrix::setSidechain(const float* const* channels, int numChannels, int numSamples)
+{
+    jassert(numChannels <= MaxSidechainChannels);
+
+    numSidechainChannels = juce::jmin(numChannels, MaxSidechainChannels);
+    for (int ch = 0; ch < numSidechainChannels; ++ch)
+        sidechainChannels[static_cast<size_t>(ch)] = channels[ch];
+
+    numSidechainSamples = numSamples;
+    sidechainPosition = 0;
+}
+
+void ModulationMatrix::advanceLfos(int numSamples)
+{
+    // The value is taken at the start of the sub-block, then the phase moves on
+    for (size_t i = 0; i < lfoPhases.size(); ++i)
+    {
+        auto phase = lfoPhases[i];
+        float value = 0.f;
+
+        switch (static_cast<LfoShape>(lfoShapes[i]->getIndex()))
+        {
+        case LfoShape::Sine:
+            value = std::sin(juce::MathConstants<float>::twoPi * phase);
+            break;
+        case LfoShape::Triangle:
+            value = 1.f - 4.f * std::abs(phase - 0.5f);
+            break;
+        case LfoShape::Saw:
+            value = 2.f * phase - 1.f;
+            break;
+        case LfoShape::Square:
+            value = phase < 0.5f ? 1.f : -1.f;
+            break;
+        case LfoShape::END_OF_LIST:
+            jassertfalse;
+            break;
+        }
+
+        sourceValues[i] = value;
+
+        phase += lfoRates[i]->get() * static_cast<float>(numSamples / sampleRate);
+        lfoPhases[i] = phase - std::floor(phase);
+    }
+}
+
+void ModulationMatrix::advanceEnvelopes(const juce::dsp::AudioBlock<float>& input)
+{
+    const auto numSamples = static_cast<int>(input.getNumSamples());
+
+    float peak = 0.f;
+    for (size_t ch = 0; ch < input.getNumChannels(); ++ch)
+    {
+        auto range = juce::FloatVectorOperations::findMinAndMax(input.getChannelPointer(ch), numSamples);
+        peak = juce::jmax(peak, -range.getStart(), range.getEnd());
+    }
+    peak = juce::jmin(peak, 1.f);
+
+    for (size_t i = 0; i < envelopeLevels.size(); ++i)
+    {
+        auto& level = envelopeLevels[i];
+        auto timeMs = peak > level ? envelopeAttacks[i]->get() : envelopeReleases[i]->get();
+        auto coefficient = static_cast<float>(std::exp(-numSamples / (timeMs * 0.001 * sampleRate)));
+
+        level = peak + coefficient * (level - peak);
+        sourceValues[static_cast<size_t>(NumLfos) + i] = level;
+    }
+}
+
+void ModulationMatrix::advanceSidechain(int end)
+{
+    constexpr auto decimation = SimdKernels::PeakDecimation;
+    constexpr auto maxChunk = MaxSidechainPeaks * decimation;
+
+    end = juce::jmin(end, numSidechainSamples);
+
+    // One coefficient per peak, worked out once for the sub-block
+    const auto samplesPerMs = 0.001 * sidechainSampleRate;
+    const auto attack = static_cast<float>(std::exp(-decimation / (sidechainAttack->get() * samplesPerMs)));
+    const auto release = static_cast<float>(std::exp(-decimation / (sidechainRelease->get() * samplesPerMs)));
+
+    while (sidechainPosition < end)
+    {
+        const auto numSamples = juce::jmin(end - sidechainPosition, maxChunk);
+        const auto numPeaks = (numSamples + decimation - 1) / decimation;
+
+        std::fill_n(sidechainPeaks.begin(), numPeaks, 0.f);
+        for (int ch = 0; ch < numSidechainChannels; ++ch)
+            SimdKernels::get().decimatedPeaks(sidechainChannels[static_cast<size_t>(ch)] + sidechainPosition, numSamples, sidechainPeaks.data());
+
+        for (int i = 0; i < numPeaks; ++i)
+        {
+            auto peak = juce::jmin(sidechainPeaks[static_cast<size_t>(i)], 1.f);
+            auto coefficient = peak > sidechainLevel ? attack : release;
+
+            // A short last peak only moves the level for the samples it covers
+            const auto length = juce::jmin(decimation, numSamples - i * decimation);
+            if (length < decimation)
+                coefficient = std::pow(coefficient, static_cast<float>(length) / decimation);
+
+            sidechainLevel = peak + coefficient * (sidechainLevel - peak);
+        }
+
+        sidechainPosition += numSamples;
+    }
+
+    sourceValues[static_cast<size_t>(SidechainSource)] = sidechainLevel;
+}
+
+bool ModulationMatrix::process(const juce::dsp::AudioBlock<float>& input, int sidechainEnd, float* targetOffsets, int numTargets)
+{
+    jassert(numTargets <= MaxTargets);
+    juce::FloatVectorOperations::clear(targetOffsets, numTargets);
+
+    advanceLfos(static_cast<int>(input.getNumSamples()));
+    advanceEnvelopes(input);
+    advanceSidechain(sidechainEnd);
+
+    bool anyRouteActive = false;
+    for (auto& row : depths)
+        row.fill(0.f);
+
+    for (size_t r = 0; r < routeSources.size(); ++r)
+    {
+        auto source = routeSources[r]->getIndex() - 1;
+        auto target = routeTargets[r]->getIndex() - 1;
+        auto depth = routeDepths[r]->get() * 0.01f;
+
+        if (source < 0 || juce::isPositiveAndBelow(target, numTargets) == false || depth == 0.f)
+            continue;
+
+        depths[static_cast<size_t>(source)][static_cast<size_t>(target)] += depth;
+        anyRouteActive = true;
+    }
+
+    if (anyRouteActive == false)
+        return false;
+
+    for (size_t s = 0; s < depths.size(); ++s)
+        juce::FloatVectorOperations::addWithMultiply(targetOffsets, depths[s].data(), sourceValues[s], numTargets);
+
+    return true;
+}
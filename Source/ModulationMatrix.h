@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    ModulationMatrix.h
+
+    Built-in LFOs and envelope followers that can be routed to any smoothed
+    parameter. Everything runs at control rate: the modulators advance once per
+    processing sub-block and the routes are applied as one pass over a dense
+    source x target depth table.
+
+    The sidechain follower listens to the optional sidechain bus rather than
+    the chain input. It detects on peaks decimated by SimdKernels, taken across
+    the sidechain's channels once per sub-block, and every channel and band
+    reads the one level.
+
+    Offsets are produced in the normalised (0 to 1) domain of the target, so a
+    depth of 100% sweeps a parameter across its whole range regardless of units.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SimdKernels.h"
+
+struct ModulationMatrix
+{
+    static constexpr int NumLfos = 4;
+    static constexpr int NumEnvelopes = 2;
+    static constexpr int SidechainSource = NumLfos + NumEnvelopes; // Last, sessions store the index
+    static constexpr int NumSources = SidechainSource + 1;
+    static constexpr int MaxSidechainChannels = 2;
+    static constexpr int NumRoutes = 8;
+    static constexpr int MaxTargets = 64;
+
+    enum class LfoShape
+    {
+        Sine,
+        Triangle,
+        Saw,
+        Square,
+        END_OF_LIST
+    };
+
+    /*
+    Target choices are "None" followed by targetNames, in the order the offsets
+    are written by process(). Keep that order stable, sessions store the index.
+    */
+    static void addParameters(juce::AudioProcessorValueTreeState::ParameterLayout& layout,
+                              const juce::StringArray& targetNames,
+                              int versionHint);
+
+    void attachParameters(juce::AudioProcessorValueTreeState& apvts);
+
+    // The sidechain stays at the host's rate when the chain runs at a fixed one
+    void prepare(double sampleRate, double sidechainSampleRate);
+    void reset();
+
+    /*
+    Once per host block, before its sub-blocks. The channels are read as the
+    sub-blocks get to them. With none, the sidechain follower releases.
+    */
+    void setSidechain(const float* const* channels, int numChannels, int numSamples);
+
+    /*
+    Advances the modulators over one sub-block of the input signal and writes
+    the summed normalised offset for each target into targetOffsets.
+    sidechainEnd is the sample of the host block the sub-block ends at.
+    Returns false, and leaves the offsets cleared, when no route is active.
+    */
+    bool process(const juce::dsp::AudioBlock<float>& input, int sidechainEnd, float* targetOffsets, int numTargets);
+
+private:
+    std::array<juce::AudioParameterFloat*, NumLfos> lfoRates {};
+    std::array<juce::AudioParameterChoice*, NumLfos> lfoShapes {};
+    std::array<juce::AudioParameterFloat*, NumEnvelopes> envelopeAttacks {}, envelopeReleases {};
+    juce::AudioParameterFloat* sidechainAttack = nullptr;
+    juce::AudioParameterFloat* sidechainRelease = nullptr;
+    std::array<juce::AudioParameterChoice*, NumRoutes> routeSources {}, routeTargets {};
+    std::array<juce::AudioParameterFloat*, NumRoutes> routeDepths {};
+
+    double sampleRate = 44100.0;
+    double sidechainSampleRate = 44100.0;
+
+    std::array<float, NumLfos> lfoPhases {};
+    std::array<float, NumEnvelopes> envelopeLevels {};
+    float sidechainLevel = 0.f;
+
+    std::array<const float*, MaxSidechainChannels> sidechainChannels {};
+    int numSidechainChannels = 0, numSidechainSamples = 0, sidechainPosition = 0;
+
+    // Enough for a sub-block of 64 samples at four times the internal rate
+    static constexpr int MaxSidechainPeaks = 16;
+    std::array<float, MaxSidechainPeaks> sidechainPeaks {};
+    std::array<float, NumSources> sourceValues {};
+
+    // One row of per-target depths for every source, rebuilt each sub-block from the routes
+    std::array<std::array<float, MaxTargets>, NumSources> depths {};
+
+    void advanceLfos(int numSamples);
+    void advanceEnvelopes(const juce::dsp::AudioBlock<float>& input);
+    void advanceSidechain(int end);
+};
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    ParameterEventList.h
+
+    Timestamped parameter changes for one processing block, kept in a fixed
+    array so filling and consuming it never allocates. The processor splits
+    its sub-blocks at the change offsets, so automation lands on the sample it
+    was written for rather than on the next sub-block boundary.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+template<size_t Capacity>
+struct ParameterEventList
+{
+    struct Event
+    {
+        int sampleOffset = 0;
+        size_t target = 0;      // Index into the processor's smoothed parameters
+        float value = 0.f;      // Plain value, in the parameter's own units
+    };
+
+    void clear()
+    {
+        numEvents = 0;
+        nextEvent = 0;
+    }
+
+    bool isEmpty() const { return numEvents == nextEvent; }
+
+    /*
+    Keeps the list sorted by offset, events at the same offset stay in the order
+    they were added. A change less than mergeWithin samples after the latest one
+    waiting for the same target replaces that one's value instead. Returns false,
+    and drops the event, when the list is full.
+    */
+    bool add(int sampleOffset, size_t target, float value, int mergeWithin = 0)
+    {
+        sampleOffset = juce::jmax(0, sampleOffset);
+
+        for (auto i = numEvents; i > nextEvent; --i)
+        {
+            auto& latest = events[i - 1];
+            if (latest.target != target)
+                continue;
+
+            if (sampleOffset >= latest.sampleOffset && sampleOffset - latest.sampleOffset < mergeWithin)
+            {
+                latest.value = value;
+                return true;
+            }
+            break;
+        }
+
+        if (numEvents == Capacity)
+            return false;
+
+        auto index = numEvents;
+        while (index > nextEvent && events[index - 1].sampleOffset > sampleOffset)
+        {
+            events[index] = events[index - 1];
+            --index;
+        }
+
+        events[index] = { sampleOffset, target, value };
+        ++numEvents;
+        return true;
+    }
+
+    /*
+    Passes every event before applyBefore to apply(), then returns the offset of
+    the next event still waiting, or end if that is sooner.
+    */
+    template<typename Fn>
+    int consume(int applyBefore, int end, Fn&& apply)
+    {
+        while (nextEvent < numEvents && events[nextEvent].sampleOffset < applyBefore)
+            apply(events[nextEvent++]);
+
+        return nextEvent < numEvents ? juce::jmin(end, events[nextEvent].sampleOffset) : end;
+    }
+
+    // For a block processed in pieces, the events still waiting then count from the next piece's start
+    void advance(int numSamples)
+    {
+        for (auto i = nextEvent; i < numEvents; ++i)
+            events[i].sampleOffset = juce::jmax(0, events[i].sampleOffset - numSamples);
+    }
+
+private:
+    std::array<Event, Capacity> events {};
+    size_t numEvents = 0;
+    size_t nextEvent = 0;
+};
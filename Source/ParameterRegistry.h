@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    ParameterRegistry.h
+
+    Every parameter a module instance owns, listed once. The processor expands
+    this list into the ModuleParam enum and the tables indexed by it, so the
+    audio thread and the GUI reach a parameter, its smoother and its range by
+    array index rather than by looking up its name.
+
+    X(enum name, owning DSP_Option, kind, stable ID, display name)
+
+    The stable ID is what hosts, sessions and preset banks store, it must never
+    change. The display name is only shown to the user and can be reworded.
+    Rows are in parameter layout order, new parameters go at the end of their
+    module.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+enum class ModuleParamKind
+{
+    Float,      // Continuous and smoothed
+    Static,     // Continuous, read on the message thread and never smoothed or modulated
+    Choice,
+    Switch,
+    Bypass      // One per module, shown as the power button on its tab
+};
+
+#define MODULAR_FX_MODULE_PARAMETERS(X) \
+    X(PhaserRate,            Phase,         Float,  "Phaser Rate (Hz)",               "Phaser Rate (Hz)") \
+    X(PhaserDepth,           Phase,         Float,  "Phaser Depth (%)",               "Phaser Depth (%)") \
+    X(PhaserCenterFreq,      Phase,         Float,  "Phaser Center Frequency (Hz)",   "Phaser Center Frequency (Hz)") \
+    X(PhaserFeedback,        Phase,         Float,  "Phaser Feedback (%)",            "Phaser Feedback (%)") \
+    X(PhaserMix,             Phase,         Float,  "Phaser Mix (%)",                 "Phaser Mix (%)") \
+    X(PhaserBypass,          Phase,         Bypass, "Phaser Bypass",                  "Phaser Bypass") \
+    X(ChorusRate,            Chorus,        Float,  "Chorus Rate (Hz)",               "Chorus Rate (Hz)") \
+    X(ChorusDepth,           Chorus,        Float,  "Chorus Depth (%)",               "Chorus Depth (%)") \
+    X(ChorusCenterDelay,     Chorus,        Float,  "Chorus Center Delay (Ms)",       "Chorus Center Delay (ms)") \
+    X(ChorusFeedback,        Chorus,        Float,  "Chorus Feedback (%)",            "Chorus Feedback (%)") \
+    X(ChorusMix,             Chorus,        Float,  "Chorus Mix (%)",                 "Chorus Mix (%)") \
+    X(ChorusBypass,          Chorus,        Bypass, "Chorus Bypass",                  "Chorus Bypass") \
+    X(OverdriveSaturation,   Overdrive,     Float,  "Overdrive Saturation",           "Overdrive Saturation") \
+    X(OverdriveBypass,       Overdrive,     Bypass, "Overdrive Bypass",               "Overdrive Bypass") \
+    X(LadderFilterMode,      LadderFilter,  Choice, "Ladder Filter Mode",             "Ladder Filter Mode") \
+    X(LadderFilterCutoff,    LadderFilter,  Float,  "Ladder Filter Cutoff (Hz)",      "Ladder Filter Cutoff (Hz)") \
+    X(LadderFilterResonance, LadderFilter,  Float,  "Ladder Filter Resonance",        "Ladder Filter Resonance") \
+    X(LadderFilterDrive,     LadderFilter,  Float,  "Ladder Filter Drive",            "Ladder Filter Drive") \
+    X(LadderFilterBypass,    LadderFilter,  Bypass, "Ladder Filter Bypass",           "Ladder Filter Bypass") \
+    X(GeneralFilterMode,     GeneralFilter, Choice, "General Filter Mode",            "General Filter Mode") \
+    X(GeneralFilterFreq,     GeneralFilter, Float,  "General Filter Frequency (Hz)",  "General Filter Frequency (Hz)") \
+    X(GeneralFilterQuality,  GeneralFilter, Float,  "General Filter Quality",         "General Filter Quality") \
+    X(GeneralFilterGain,     GeneralFilter, Float,  "General Filter Gain (dB)",       "General Filter Gain (dB)") \
+    X(GeneralFilterBypass,   GeneralFilter, Bypass, "General Filter Bypass",          "General Filter Bypass") \
+    X(GeneralFilterBands,    GeneralFilter, Choice, "General Filter Bands",           "General Filter Bands") \
+    X(GeneralFilterBand2Mode, GeneralFilter, Choice, "General Filter Band 2 Mode",     "General Filter Band 2 Mode") \
+    X(GeneralFilterBand2Freq, GeneralFilter, Static, "General Filter Band 2 Frequency (Hz)", "General Filter Band 2 Frequency (Hz)") \
+    X(GeneralFilterBand2Quality, GeneralFilter, Static, "General Filter Band 2 Quality",  "General Filter Band 2 Quality") \
+    X(GeneralFilterBand2Gain, GeneralFilter, Static, "General Filter Band 2 Gain (dB)", "General Filter Band 2 Gain (dB)") \
+    X(GeneralFilterBand3Mode, GeneralFilter, Choice, "General Filter Band 3 Mode",     "General Filter Band 3 Mode") \
+    X(GeneralFilterBand3Freq, GeneralFilter, Static, "General Filter Band 3 Frequency (Hz)", "General Filter Band 3 Frequency (Hz)") \
+    X(GeneralFilterBand3Quality, GeneralFilter, Static, "General Filter Band 3 Quality",  "General Filter Band 3 Quality") \
+    X(GeneralFilterBand3Gain, GeneralFilter, Static, "General Filter Band 3 Gain (dB)", "General Filter Band 3 Gain (dB)") \
+    X(GeneralFilterBand4Mode, GeneralFilter, Choice, "General Filter Band 4 Mode",     "General Filter Band 4 Mode") \
+    X(GeneralFilterBand4Freq, GeneralFilter, Static, "General Filter Band 4 Frequency (Hz)", "General Filter Band 4 Frequency (Hz)") \
+    X(GeneralFilterBand4Quality, GeneralFilter, Static, "General Filter Band 4 Quality",  "General Filter Band 4 Quality") \
+    X(GeneralFilterBand4Gain, GeneralFilter, Static, "General Filter Band 4 Gain (dB)", "General Filter Band 4 Gain (dB)") \
+    X(GeneralFilterBand5Mode, GeneralFilter, Choice, "General Filter Band 5 Mode",     "General Filter Band 5 Mode") \
+    X(GeneralFilterBand5Freq, GeneralFilter, Static, "General Filter Band 5 Frequency (Hz)", "General Filter Band 5 Frequency (Hz)") \
+    X(GeneralFilterBand5Quality, GeneralFilter, Static, "General Filter Band 5 Quality",  "General Filter Band 5 Quality") \
+    X(GeneralFilterBand5Gain, GeneralFilter, Static, "General Filter Band 5 Gain (dB)", "General Filter Band 5 Gain (dB)") \
+    X(GeneralFilterBand6Mode, GeneralFilter, Choice, "General Filter Band 6 Mode",     "General Filter Band 6 Mode") \
+    X(GeneralFilterBand6Freq, GeneralFilter, Static, "General Filter Band 6 Frequency (Hz)", "General Filter Band 6 Frequency (Hz)") \
+    X(GeneralFilterBand6Quality, GeneralFilter, Static, "General Filter Band 6 Quality",  "General Filter Band 6 Quality") \
+    X(GeneralFilterBand6Gain, GeneralFilter, Static, "General Filter Band 6 Gain (dB)", "General Filter Band 6 Gain (dB)") \
+    X(GeneralFilterBand7Mode, GeneralFilter, Choice, "General Filter Band 7 Mode",     "General Filter Band 7 Mode") \
+    X(GeneralFilterBand7Freq, GeneralFilter, Static, "General Filter Band 7 Frequency (Hz)", "General Filter Band 7 Frequency (Hz)") \
+    X(GeneralFilterBand7Quality, GeneralFilter, Static, "General Filter Band 7 Quality",  "General Filter Band 7 Quality") \
+    X(GeneralFilterBand7Gain, GeneralFilter, Static, "General Filter Band 7 Gain (dB)", "General Filter Band 7 Gain (dB)") \
+    X(GeneralFilterBand8Mode, GeneralFilter, Choice, "General Filter Band 8 Mode",     "General Filter Band 8 Mode") \
+    X(GeneralFilterBand8Freq, GeneralFilter, Static, "General Filter Band 8 Frequency (Hz)", "General Filter Band 8 Frequency (Hz)") \
+    X(GeneralFilterBand8Quality, GeneralFilter, Static, "General Filter Band 8 Quality",  "General Filter Band 8 Quality") \
+    X(GeneralFilterBand8Gain, GeneralFilter, Static, "General Filter Band 8 Gain (dB)", "General Filter Band 8 Gain (dB)") \
+    X(GeneralFilterLinearPhase, GeneralFilter, Switch, "General Filter Linear Phase", "General Filter Linear Phase") \
+    X(DelayTime,             Delay,         Float,  "Delay Time (ms)",                "Delay Time (ms)") \
+    X(DelaySync,             Delay,         Switch, "Delay Sync",                     "Delay Sync") \
+    X(DelayNote,             Delay,         Choice, "Delay Note",                     "Delay Note") \
+    X(DelayFeedback,         Delay,         Float,  "Delay Feedback (%)",             "Delay Feedback (%)") \
+    X(DelayLowCut,           Delay,         Float,  "Delay Low Cut (Hz)",             "Delay Low Cut (Hz)") \
+    X(DelayHighCut,          Delay,         Float,  "Delay High Cut (Hz)",            "Delay High Cut (Hz)") \
+    X(DelayPingPong,         Delay,         Switch, "Delay Ping Pong",                "Delay Ping Pong") \
+    X(DelayMix,              Delay,         Float,  "Delay Mix (%)",                  "Delay Mix (%)") \
+    X(DelayBypass,           Delay,         Bypass, "Delay Bypass",                   "Delay Bypass") \
+    X(ConvolutionMix,        Convolution,   Float,  "Convolution Mix (%)",            "Convolution Mix (%)") \
+    X(ConvolutionGain,       Convolution,   Float,  "Convolution Gain (dB)",          "Convolution Gain (dB)") \
+    X(ConvolutionBypass,     Convolution,   Bypass, "Convolution Bypass",             "Convolution Bypass")
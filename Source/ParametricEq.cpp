@@ -0,0 +1,170 @@
+/*
+  ==============================================================================
+
+    ParametricEq.cpp
+
+  ==============================================================================
+*/
+
+#include "ParametricEq.h"
+
+// The bilinear designs from the Audio EQ Cookbook, the same responses JUCE's IIR::Coefficients give
+ParametricEq::Coefficients ParametricEq::design(const Band& band, double sampleRate)
+{
+    jassert(sampleRate > 0.0);
+
+    const auto frequency = juce::jlimit(1.0, sampleRate * 0.499, static_cast<double>(band.frequency));
+    const auto w = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    const auto cosW = std::cos(w);
+    const auto alpha = std::sin(w) / (2.0 * juce::jmax(0.01, static_cast<double>(band.quality)));
+    const auto A = std::pow(10.0, band.gainDecibels / 40.0);
+
+    double b0 = 1.0, b1 = 0.0, b2 = 0.0, a0 = 1.0, a1 = 0.0, a2 = 0.0;
+    switch (band.mode)
+    {
+    case GeneralFilterMode::Peak:
+        b0 = 1.0 + alpha * A;
+        b1 = -2.0 * cosW;
+        b2 = 1.0 - alpha * A;
+        a0 = 1.0 + alpha / A;
+        a1 = -2.0 * cosW;
+        a2 = 1.0 - alpha / A;
+        break;
+    case GeneralFilterMode::Bandpass:
+        b0 = alpha;
+        b1 = 0.0;
+        b2 = -alpha;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cosW;
+        a2 = 1.0 - alpha;
+        break;
+    case GeneralFilterMode::Notch:
+        b0 = 1.0;
+        b1 = -2.0 * cosW;
+        b2 = 1.0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cosW;
+        a2 = 1.0 - alpha;
+        break;
+    case GeneralFilterMode::Allpass:
+        b0 = 1.0 - alpha;
+        b1 = -2.0 * cosW;
+        b2 = 1.0 + alpha;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cosW;
+        a2 = 1.0 - alpha;
+        break;
+    case GeneralFilterMode::LowShelf:
+    {
+        const auto shelf = 2.0 * std::sqrt(A) * alpha;
+        b0 = A * ((A + 1.0) - (A - 1.0) * cosW + shelf);
+        b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cosW);
+        b2 = A * ((A + 1.0) - (A - 1.0) * cosW - shelf);
+        a0 = (A + 1.0) + (A - 1.0) * cosW + shelf;
+        a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cosW);
+        a2 = (A + 1.0) + (A - 1.0) * cosW - shelf;
+        break;
+    }
+    case GeneralFilterMode::HighShelf:
+    {
+        const auto shelf = 2.0 * std::sqrt(A) * alpha;
+        b0 = A * ((A + 1.0) + (A - 1.0) * cosW + shelf);
+        b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cosW);
+        b2 = A * ((A + 1.0) + (A - 1.0) * cosW - shelf);
+        a0 = (A + 1.0) - (A - 1.0) * cosW + shelf;
+        a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cosW);
+        a2 = (A + 1.0) - (A - 1.0) * cosW - shelf;
+        break;
+    }
+    case GeneralFilterMode::END_OF_LIST:
+        jassertfalse; // This should never happen
+        return {};
+    }
+
+    Coefficients result;
+    result.b0 = static_cast<float>(b0 / a0);
+    result.b1 = static_cast<float>(b1 / a0);
+    result.b2 = static_cast<float>(b2 / a0);
+    result.a1 = static_cast<float>(a1 / a0);
+    result.a2 = static_cast<float>(a2 / a0);
+    return result;
+}
+
+ParametricEq::ParametricEq()
+{
+    for (int band = 0; band < MaxBands; ++band)
+        writeLane(band, bands[static_cast<size_t>(band)]);
+}
+
+void ParametricEq::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.numChannels == 1); // The banks hold one channel's state
+    juce::ignoreUnused(spec);
+
+    reset();
+}
+
+void ParametricEq::reset()
+{
+    for (auto& bank : banks)
+    {
+        std::fill(std::begin(bank.z1), std::end(bank.z1), 0.f);
+        std::fill(std::begin(bank.z2), std::end(bank.z2), 0.f);
+    }
+}
+
+void ParametricEq::setNumBands(int newNumBands)
+{
+    newNumBands = juce::jlimit(1, MaxBands, newNumBands);
+
+    // A pass-through lane keeps cleared state at zero, so bands coming back need nothing else
+    for (int band = numBands; band < newNumBands; ++band)
+        writeLane(band, bands[static_cast<size_t>(band)]);
+
+    for (int band = newNumBands; band < numBands; ++band)
+    {
+        writeLane(band, {});
+
+        auto& bank = banks[static_cast<size_t>(band / SimdKernels::NumBiquadLanes)];
+        const auto lane = static_cast<size_t>(band % SimdKernels::NumBiquadLanes);
+        bank.z1[lane] = bank.z2[lane] = 0.f;
+    }
+
+    numBands = newNumBands;
+}
+
+void ParametricEq::setCoefficients(int band, const Coefficients& coefficients)
+{
+    jassert(juce::isPositiveAndBelow(band, MaxBands));
+    bands[static_cast<size_t>(band)] = coefficients;
+
+    if (band < numBands)
+        writeLane(band, coefficients);
+}
+
+void ParametricEq::writeLane(int band, const Coefficients& coefficients)
+{
+    auto& bank = banks[static_cast<size_t>(band / SimdKernels::NumBiquadLanes)];
+    const auto lane = static_cast<size_t>(band % SimdKernels::NumBiquadLanes);
+
+    bank.b0[lane] = coefficients.b0;
+    bank.b1[lane] = coefficients.b1;
+    bank.b2[lane] = coefficients.b2;
+    bank.a1[lane] = coefficients.a1;
+    bank.a2[lane] = coefficients.a2;
+}
+
+void ParametricEq::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    if (context.isBypassed)
+        return;
+
+    auto& block = context.getOutputBlock();
+    jassert(block.getNumChannels() == 1);
+
+    auto* data = block.getChannelPointer(0);
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+
+    for (int bank = 0; bank * SimdKernels::NumBiquadLanes < numBands; ++bank)
+        SimdKernels::get().biquadCascade(data, numSamples, banks[static_cast<size_t>(bank)]);
+}
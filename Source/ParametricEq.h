@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    ParametricEq.h
+
+    The general filter: up to eight biquads in series on one channel. The bands
+    are packed four to a BiquadLanes bank and run through the biquadCascade
+    kernel, so a bank costs about as much as a single band. Bands past the
+    active count hold a pass-through and the second bank is skipped while
+    four or fewer bands are in use.
+
+    design() computes a band's coefficients without allocating, on any thread.
+    The processor designs every band but the first on the message thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SimdKernels.h"
+
+// The choice index is what sessions store, new modes go at the end
+enum class GeneralFilterMode
+{
+    Peak,
+    Bandpass,
+    Notch,
+    Allpass,
+    LowShelf,
+    HighShelf,
+    END_OF_LIST
+};
+
+struct ParametricEq
+{
+    static constexpr int MaxBands = 8;
+
+    struct Band
+    {
+        GeneralFilterMode mode = GeneralFilterMode::Peak;
+        float frequency = 750.f;
+        float quality = 0.72f;
+        float gainDecibels = 0.f; // Peak and shelves only
+    };
+
+    // Normalised by a0, a1 and a2 with the sign they have in the denominator
+    struct Coefficients
+    {
+        float b0 = 1.f, b1 = 0.f, b2 = 0.f;
+        float a1 = 0.f, a2 = 0.f;
+    };
+
+    static Coefficients design(const Band& band, double sampleRate);
+
+    ParametricEq();
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    // Bands that stop being used are cleared, so they start from silence when they come back
+    void setNumBands(int numBands);
+    int getNumBands() const { return numBands; }
+
+    void setCoefficients(int band, const Coefficients& coefficients);
+
+    void process(const juce::dsp::ProcessContextReplacing<float>& context);
+
+private:
+    static constexpr int NumBanks = MaxBands / SimdKernels::NumBiquadLanes;
+
+    int numBands = 1;
+    std::array<Coefficients, MaxBands> bands;
+    std::array<SimdKernels::BiquadLanes, NumBanks> banks;
+
+    void writeLane(int band, const Coefficients& coefficients);
+};
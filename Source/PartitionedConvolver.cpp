@@ -0,0 +1,455 @@
+/*
+  ==============================================================================
+
+    PartitionedConvolver.cpp
+
+  ==============================================================================
+*/
+
+#include "PartitionedConvolver.h"
+#include "FixedRateConverter.h"
+#include "SimdKernels.h"
+
+namespace
+{
+    constexpr int HeadSize = ConvolutionSetup::HeadSize;
+    constexpr int BodyFftSize = 1 << ConvolutionSetup::BodyFftOrder;
+    constexpr int BodySpectrumSize = (BodyFftSize / 2 + 1) * 2;
+
+    constexpr int TailPartitionSize = ConvolutionSetup::TailPartitionSize;
+    constexpr int TailFftSize = 1 << ConvolutionSetup::TailFftOrder;
+    constexpr int TailSpectrumSize = (TailFftSize / 2 + 1) * 2;
+
+    static_assert(BodyFftSize == 2 * HeadSize && TailFftSize == 2 * TailPartitionSize);
+    static_assert(TailPartitionSize % HeadSize == 0, "Tail partitions have to end on head partitions");
+
+    // Interleaved real and imaginary, as juce::dsp::FFT leaves them
+    void multiplyAdd(float* sum, const float* x, const float* h, int spectrumSize)
+    {
+        for (int k = 0; k < spectrumSize; k += 2)
+        {
+            sum[k] += x[k] * h[k] - x[k + 1] * h[k + 1];
+            sum[k + 1] += x[k] * h[k + 1] + x[k + 1] * h[k];
+        }
+    }
+
+    // Transforms the taps from start on in partitions, each zero padded to twice its size for overlap-save
+    std::vector<float> makeSpectra(const juce::dsp::FFT& fft, const float* taps, int numTaps, int start, int partitionSize, int numPartitions)
+    {
+        const auto fftSize = fft.getSize();
+        const auto spectrumSize = (fftSize / 2 + 1) * 2;
+
+        std::vector<float> spectra(static_cast<size_t>(numPartitions * spectrumSize), 0.f);
+        std::vector<float> buffer(static_cast<size_t>(2 * fftSize));
+
+        for (int p = 0; p < numPartitions; ++p)
+        {
+            std::fill(buffer.begin(), buffer.end(), 0.f);
+
+            const auto first = start + p * partitionSize;
+            const auto count = juce::jlimit(0, partitionSize, numTaps - first);
+            std::copy_n(taps + first, count, buffer.begin());
+
+            fft.performRealOnlyForwardTransform(buffer.data(), true);
+            std::copy_n(buffer.begin(), spectrumSize, spectra.begin() + p * spectrumSize);
+        }
+
+        return spectra;
+    }
+
+    /*
+    The polyphase converter when the rates are whole numbers it can handle, with
+    its delay trimmed off and its filter flushed out. Interpolated otherwise.
+    */
+    std::vector<float> resample(const float* input, int numInput, double inputRate, double outputRate)
+    {
+        const auto ratio = outputRate / inputRate;
+        const auto numOutput = static_cast<int>(std::ceil(numInput * ratio));
+        std::vector<float> output(static_cast<size_t>(numOutput), 0.f);
+
+        constexpr int chunk = 4096;
+        PolyphaseResampler resampler;
+        const auto wholeRates = inputRate == std::round(inputRate) && outputRate == std::round(outputRate);
+
+        if (wholeRates && resampler.prepare(juce::roundToInt(inputRate), juce::roundToInt(outputRate), chunk))
+        {
+            const auto skip = juce::roundToInt(resampler.getLatencyInInputSamples() * ratio);
+            const auto numFlush = static_cast<int>(std::ceil(resampler.getLatencyInInputSamples())) + 1;
+
+            std::vector<float> in(static_cast<size_t>(chunk), 0.f);
+            std::vector<float> out(static_cast<size_t>(resampler.getMaxOutputSamples(chunk)));
+
+            auto produced = 0;
+            for (int done = 0; done < numInput + numFlush && produced < skip + numOutput;)
+            {
+                const auto count = juce::jmin(chunk, numInput + numFlush - done);
+                const auto numReal = juce::jlimit(0, count, numInput - done);
+                std::copy_n(input + done, numReal, in.begin());
+                std::fill(in.begin() + numReal, in.begin() + count, 0.f);
+
+                const auto numOut = resampler.process(in.data(), count, out.data());
+                for (int i = 0; i < numOut; ++i, ++produced)
+                {
+                    if (juce::isPositiveAndBelow(produced - skip, numOutput))
+                        output[static_cast<size_t>(produced - skip)] = out[static_cast<size_t>(i)];
+                }
+
+                done += count;
+            }
+
+            return output;
+        }
+
+        // Zeros after the end, so the last few outputs have something to interpolate towards
+        std::vector<float> padded(input, input + numInput);
+        padded.resize(static_cast<size_t>(numInput + 8), 0.f);
+
+        juce::LagrangeInterpolator interpolator;
+        interpolator.process(inputRate / outputRate, padded.data(), output.data(), numOutput, static_cast<int>(padded.size()), 0);
+        return output;
+    }
+}
+
+//==============================================================================
+std::unique_ptr<ConvolutionSetup> ConvolutionSetup::load(const juce::File& file, double sampleRate, int numChains)
+{
+    jassert(sampleRate > 0.0 && numChains > 0);
+
+    // Mapped rather than streamed, a long response is paged in as it's read
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader(wav.createMemoryMappedReader(file));
+    if (reader == nullptr || reader->mapEntireFile() == false || reader->sampleRate <= 0.0 || reader->lengthInSamples <= 0)
+        return nullptr;
+
+    const auto numChannels = juce::jlimit(1, 2, static_cast<int>(reader->numChannels));
+    const auto maxLength = static_cast<juce::int64>(MaxLengthSeconds * reader->sampleRate);
+    const auto fileLength = static_cast<int>(juce::jmin(reader->lengthInSamples, maxLength));
+
+    juce::AudioBuffer<float> fileBuffer(numChannels, fileLength);
+    reader->read(&fileBuffer, 0, fileLength, 0, true, numChannels > 1);
+
+    std::vector<std::vector<float>> taps;
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto* data = fileBuffer.getReadPointer(ch);
+        if (reader->sampleRate == sampleRate)
+            taps.emplace_back(data, data + fileLength);
+        else
+            taps.push_back(resample(data, fileLength, reader->sampleRate, sampleRate));
+    }
+
+    return create(std::move(taps), sampleRate, numChains);
+}
+
+std::unique_ptr<ConvolutionSetup> ConvolutionSetup::create(std::vector<std::vector<float>> taps, double sampleRate, int numChains)
+{
+    if (taps.empty() || taps.front().empty())
+        return nullptr;
+
+    auto setup = std::make_unique<ConvolutionSetup>();
+    setup->sampleRate = sampleRate;
+    setup->numChains = numChains;
+
+    // Unit energy on the louder side, so responses of any length come out at a similar level
+    auto energy = 0.0;
+    for (const auto& channel : taps)
+    {
+        auto sum = 0.0;
+        for (auto tap : channel)
+            sum += static_cast<double>(tap) * tap;
+        energy = juce::jmax(energy, sum);
+    }
+
+    const auto scale = energy > 0.0 ? static_cast<float>(1.0 / std::sqrt(energy)) : 0.f;
+    for (auto& channel : taps)
+        juce::FloatVectorOperations::multiply(channel.data(), scale, static_cast<int>(channel.size()));
+
+    setup->length = static_cast<int>(taps.front().size());
+    setup->numTailPartitions = juce::jmax(0, (setup->length - TailStart + TailPartitionSize - 1) / TailPartitionSize);
+
+    const juce::dsp::FFT bodyFft(BodyFftOrder);
+    for (const auto& channel : taps)
+    {
+        const auto numTaps = static_cast<int>(channel.size());
+
+        Response response;
+        response.head.assign(static_cast<size_t>(HeadSize), 0.f);
+        for (int i = 0; i < juce::jmin(HeadSize, numTaps); ++i)
+            response.head[static_cast<size_t>(HeadSize - 1 - i)] = channel[static_cast<size_t>(i)];
+
+        response.body = makeSpectra(bodyFft, channel.data(), numTaps, HeadSize, HeadSize, NumBodyPartitions);
+        response.tail = makeSpectra(setup->tailFft, channel.data(), numTaps, TailStart, TailPartitionSize, setup->numTailPartitions);
+        setup->responses.push_back(std::move(response));
+    }
+
+    // Every channel's tail state up front, the audio thread only hands them over
+    if (setup->hasTail())
+    {
+        setup->tails = std::make_unique<Tail[]>(static_cast<size_t>(numChains));
+        for (int chain = 0; chain < numChains; ++chain)
+        {
+            auto& tail = setup->tails[static_cast<size_t>(chain)];
+            tail.input.assign(static_cast<size_t>(2 * TailPartitionSize), 0.f);
+            tail.delayLine.assign(static_cast<size_t>(setup->numTailPartitions * TailSpectrumSize), 0.f);
+            tail.fftBuffer.assign(static_cast<size_t>(2 * TailFftSize), 0.f);
+            tail.output.assign(static_cast<size_t>(TailPartitionSize), 0.f);
+            tail.responseChannel = chain % static_cast<int>(taps.size());
+        }
+    }
+
+    return setup;
+}
+
+const ConvolutionSetup::Response& ConvolutionSetup::getResponse(int chain) const
+{
+    jassert(juce::isPositiveAndBelow(chain, numChains));
+    return responses[static_cast<size_t>(chain) % responses.size()];
+}
+
+ConvolutionSetup::Tail& ConvolutionSetup::getTail(int chain)
+{
+    jassert(hasTail() && juce::isPositiveAndBelow(chain, numChains));
+    return tails[static_cast<size_t>(chain)];
+}
+
+void ConvolutionSetup::processTail(Tail& tail) const
+{
+    const auto& response = responses[static_cast<size_t>(tail.responseChannel)];
+    auto* buffer = tail.fftBuffer.data();
+
+    std::fill(tail.fftBuffer.begin(), tail.fftBuffer.end(), 0.f);
+    std::copy(tail.input.begin(), tail.input.end(), buffer);
+    tailFft.performRealOnlyForwardTransform(buffer, true);
+
+    tail.delayLineHead = (tail.delayLineHead + 1) % numTailPartitions;
+    std::copy_n(buffer, TailSpectrumSize, tail.delayLine.begin() + tail.delayLineHead * TailSpectrumSize);
+
+    // The block just handed over becomes the first half of the next window
+    std::copy(tail.input.begin() + TailPartitionSize, tail.input.end(), tail.input.begin());
+
+    std::fill(tail.fftBuffer.begin(), tail.fftBuffer.end(), 0.f);
+    for (int p = 0; p < numTailPartitions; ++p)
+    {
+        const auto* x = tail.delayLine.data() + ((tail.delayLineHead - p + numTailPartitions) % numTailPartitions) * TailSpectrumSize;
+        multiplyAdd(buffer, x, response.tail.data() + p * TailSpectrumSize, TailSpectrumSize);
+    }
+
+    tailFft.performRealOnlyInverseTransform(buffer);
+    std::copy_n(buffer + TailPartitionSize, TailPartitionSize, tail.output.begin());
+}
+
+void ConvolutionSetup::clearTail(Tail& tail) const
+{
+    jassert(tail.stage.load() != Tail::Queued);
+
+    std::fill(tail.input.begin(), tail.input.end(), 0.f);
+    std::fill(tail.delayLine.begin(), tail.delayLine.end(), 0.f);
+    std::fill(tail.output.begin(), tail.output.end(), 0.f);
+    tail.delayLineHead = 0;
+    tail.stage = Tail::Idle;
+}
+
+//==============================================================================
+void PartitionedConvolver::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.numChannels == 1);
+    juce::ignoreUnused(spec);
+
+    bodyFft = std::make_unique<juce::dsp::FFT>(ConvolutionSetup::BodyFftOrder);
+    window.assign(static_cast<size_t>(2 * HeadSize), 0.f);
+    bodyDelayLine.assign(static_cast<size_t>(ConvolutionSetup::NumBodyPartitions * BodySpectrumSize), 0.f);
+    fftBuffer.assign(static_cast<size_t>(2 * BodyFftSize), 0.f);
+    bodyOutput.assign(static_cast<size_t>(HeadSize), 0.f);
+    tailInput.assign(static_cast<size_t>(TailPartitionSize), 0.f);
+    tailOutput.assign(static_cast<size_t>(TailPartitionSize), 0.f);
+
+    mix = targetMix;
+    gain = targetGain;
+
+    reset();
+}
+
+void PartitionedConvolver::reset()
+{
+    // The worker still owns a tail it was handed, it's cleared once it gives it back
+    if (tail != nullptr)
+    {
+        waitForTail();
+        setup->clearTail(*tail);
+    }
+
+    clearState();
+}
+
+void PartitionedConvolver::clearState()
+{
+    std::fill(window.begin(), window.end(), 0.f);
+    std::fill(bodyDelayLine.begin(), bodyDelayLine.end(), 0.f);
+    std::fill(bodyOutput.begin(), bodyOutput.end(), 0.f);
+    std::fill(tailInput.begin(), tailInput.end(), 0.f);
+    std::fill(tailOutput.begin(), tailOutput.end(), 0.f);
+
+    bodyDelayLineHead = 0;
+    bodyPosition = 0;
+    tailPosition = 0;
+}
+
+void PartitionedConvolver::setSetup(ConvolutionSetup* newSetup, int chain)
+{
+    if (newSetup == setup)
+    {
+        reset();
+        return;
+    }
+
+    setup = newSetup;
+    response = setup != nullptr ? &setup->getResponse(chain) : nullptr;
+    tail = setup != nullptr && setup->hasTail() ? &setup->getTail(chain) : nullptr;
+
+    // A new setup's tails start out cleared
+    clearState();
+}
+
+void PartitionedConvolver::setMix(float newMix)
+{
+    targetMix = juce::jlimit(0.f, 1.f, newMix);
+}
+
+void PartitionedConvolver::setGainDecibels(float newGainDecibels)
+{
+    targetGain = juce::Decibels::decibelsToGain(newGainDecibels);
+}
+
+void PartitionedConvolver::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    auto& block = context.getOutputBlock();
+    jassert(block.getNumChannels() == 1);
+
+    if (context.isBypassed || response == nullptr || bodyFft == nullptr)
+    {
+        mix = targetMix;
+        gain = targetGain;
+        return;
+    }
+
+    auto* data = block.getChannelPointer(0);
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+    if (numSamples == 0)
+        return;
+
+    const auto mixStep = (targetMix - mix) / static_cast<float>(numSamples);
+    const auto gainStep = (targetGain - gain) / static_cast<float>(numSamples);
+    const auto* head = response->head.data();
+
+    for (int done = 0; done < numSamples;)
+    {
+        const auto count = juce::jmin(numSamples - done, HeadSize - bodyPosition);
+        auto* out = data + done;
+        const auto* dry = window.data() + HeadSize + bodyPosition;
+
+        std::copy_n(out, count, window.begin() + HeadSize + bodyPosition);
+        if (tail != nullptr)
+            std::copy_n(out, count, tailInput.begin() + tailPosition);
+
+        // The head runs over the newest HeadSize samples, the body and tail were worked out earlier
+        for (int i = 0; i < count; ++i)
+        {
+            const auto* x = window.data() + bodyPosition + i + 1;
+            auto sum = 0.f;
+            for (int j = 0; j < HeadSize; ++j)
+                sum += head[j] * x[j];
+
+            gain += gainStep;
+            out[i] = gain * (sum + bodyOutput[static_cast<size_t>(bodyPosition + i)] + tailOutput[static_cast<size_t>(tailPosition + i)]);
+        }
+
+        SimdKernels::crossfade(out, dry, count, mix, mixStep);
+        mix += mixStep * static_cast<float>(count);
+
+        bodyPosition += count;
+        tailPosition += count;
+        done += count;
+
+        if (bodyPosition == HeadSize)
+        {
+            processBodyPartition();
+            bodyPosition = 0;
+        }
+
+        if (tailPosition == TailPartitionSize)
+        {
+            handOverTail();
+            tailPosition = 0;
+        }
+    }
+
+    mix = targetMix;
+    gain = targetGain;
+}
+
+void PartitionedConvolver::processBodyPartition()
+{
+    constexpr auto numPartitions = ConvolutionSetup::NumBodyPartitions;
+
+    std::fill(fftBuffer.begin(), fftBuffer.end(), 0.f);
+    std::copy(window.begin(), window.end(), fftBuffer.begin());
+    bodyFft->performRealOnlyForwardTransform(fftBuffer.data(), true);
+
+    bodyDelayLineHead = (bodyDelayLineHead + 1) % numPartitions;
+    std::copy_n(fftBuffer.begin(), BodySpectrumSize, bodyDelayLine.begin() + bodyDelayLineHead * BodySpectrumSize);
+
+    std::copy(window.begin() + HeadSize, window.end(), window.begin());
+
+    // The body starts one partition in, so this input's result belongs to the next partition
+    std::fill(fftBuffer.begin(), fftBuffer.end(), 0.f);
+    for (int p = 0; p < numPartitions; ++p)
+    {
+        const auto* x = bodyDelayLine.data() + ((bodyDelayLineHead - p + numPartitions) % numPartitions) * BodySpectrumSize;
+        multiplyAdd(fftBuffer.data(), x, response->body.data() + p * BodySpectrumSize, BodySpectrumSize);
+    }
+
+    bodyFft->performRealOnlyInverseTransform(fftBuffer.data());
+    std::copy_n(fftBuffer.begin() + HeadSize, HeadSize, bodyOutput.begin());
+}
+
+void ConvolutionSetup::notifyTailQueued() const
+{
+    // Signalling the event only holds its mutex for as long as the worker does, never across any work
+    if (tailWorker != nullptr)
+        tailWorker->notify();
+}
+
+//==============================================================================
+void PartitionedConvolver::handOverTail()
+{
+    if (tail == nullptr)
+        return;
+
+    // The block handed over last time is due now, it had a whole partition to come back
+    waitForTail();
+
+    if (tail->stage.load() == ConvolutionSetup::Tail::Done)
+        std::copy(tail->output.begin(), tail->output.end(), tailOutput.begin());
+    else
+        std::fill(tailOutput.begin(), tailOutput.end(), 0.f);
+
+    std::copy(tailInput.begin(), tailInput.end(), tail->input.begin() + TailPartitionSize);
+
+    if (nonRealtime)
+    {
+        setup->processTail(*tail);
+        tail->stage = ConvolutionSetup::Tail::Done;
+    }
+    else
+    {
+        tail->stage = ConvolutionSetup::Tail::Queued;
+        setup->notifyTailQueued();
+    }
+}
+
+void PartitionedConvolver::waitForTail() const
+{
+    // Only when the worker has fallen behind, it never takes a lock or waits on this thread
+    while (tail->stage.load() == ConvolutionSetup::Tail::Queued)
+        juce::Thread::yield();
+}
@@ -0,0 +1,169 @@
+/*
+  ==============================================================================
+
+    PartitionedConvolver.h
+
+    The Convolution module: an impulse response from a WAV file, applied with
+    no latency by non-uniformly partitioned convolution in three segments.
+
+    Head: the first HeadSize taps, as a direct FIR on the audio thread.
+    Body: the taps up to TailStart in partitions of HeadSize, by overlap-save
+    FFT on the audio thread. Its one partition of delay is what the head covers.
+    Tail: the rest in partitions of TailPartitionSize, by FFT on the
+    ConvolutionWorker's thread. The tail starts two of its partitions in, so
+    each block has a whole partition's time to come back before it's needed.
+
+    A ConvolutionSetup is built off the audio thread, with the response
+    resampled to the processing rate, transformed, and the tail state for
+    every channel allocated. The audio thread swaps one in whole.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct ConvolutionSetup
+{
+    static constexpr int HeadSize = 128;
+    static constexpr int BodyFftOrder = 8; // Two head partitions
+    static constexpr int NumBodyPartitions = 15;
+
+    static constexpr int TailPartitionSize = 1024;
+    static constexpr int TailFftOrder = 11;
+
+    static constexpr int TailStart = HeadSize * (NumBodyPartitions + 1);
+    static_assert(TailStart == 2 * TailPartitionSize, "The tail needs one partition of slack");
+
+    // Longer responses are cut off
+    static constexpr double MaxLengthSeconds = 10.0;
+
+    /*
+    Reads the file through a memory-mapped reader and resamples it to sampleRate.
+    numChains is how many channels get tail state. Returns nullptr when the file
+    can't be read. Never call this on the audio thread.
+    */
+    static std::unique_ptr<ConvolutionSetup> load(const juce::File& file, double sampleRate, int numChains);
+
+    // From a response already at sampleRate, one or two channels of equal length
+    static std::unique_ptr<ConvolutionSetup> create(std::vector<std::vector<float>> taps, double sampleRate, int numChains);
+
+    // One channel of the response, read-only once built
+    struct Response
+    {
+        std::vector<float> head;    // Reversed, so it runs forwards over the input
+        std::vector<float> body;    // NumBodyPartitions spectra
+        std::vector<float> tail;    // numTailPartitions spectra
+    };
+
+    // One channel's tail, owned by whichever thread the stage hands it to
+    struct Tail
+    {
+        enum Stage
+        {
+            Idle,
+            Queued,     // The worker's until it sets Done
+            Done
+        };
+
+        // The previous block of input followed by the one handed over
+        std::vector<float> input;
+
+        // Spectra of past input, the newest at delayLineHead
+        std::vector<float> delayLine;
+        int delayLineHead = 0;
+        std::vector<float> fftBuffer;
+
+        // For two blocks after the input it was worked out from
+        std::vector<float> output;
+
+        int responseChannel = 0;
+        std::atomic<int> stage { Idle };
+    };
+
+    double getSampleRate() const { return sampleRate; }
+    double getLengthSeconds() const { return length / sampleRate; }
+    bool hasTail() const { return numTailPartitions > 0; }
+
+    const Response& getResponse(int chain) const;
+    Tail& getTail(int chain);
+    int getNumChains() const { return numChains; }
+
+    // On the worker, or inline on the audio thread when rendering offline
+    void processTail(Tail& tail) const;
+
+    // Clears a tail the worker isn't holding
+    void clearTail(Tail& tail) const;
+
+    // The thread woken when a tail is queued, set before the setup reaches the audio thread
+    void setTailWorker(juce::Thread* newTailWorker) { tailWorker = newTailWorker; }
+    void notifyTailQueued() const;
+
+private:
+    double sampleRate = 44100.0;
+    int length = 0;
+    int numTailPartitions = 0;
+    int numChains = 0;
+
+    std::vector<Response> responses;
+    std::unique_ptr<Tail[]> tails;
+    juce::dsp::FFT tailFft { TailFftOrder };
+
+    juce::Thread* tailWorker = nullptr;
+};
+
+struct PartitionedConvolver
+{
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    /*
+    Audio thread. chain picks this channel's tail state and the side of a stereo
+    response. The previous setup isn't touched, it may already be gone.
+    */
+    void setSetup(ConvolutionSetup* newSetup, int chain);
+    double getLengthSeconds() const { return setup != nullptr ? setup->getLengthSeconds() : 0.0; }
+
+    void setMix(float newMix);               // 0 to 1
+    void setGainDecibels(float newGainDecibels);
+
+    // Offline the tail is worked out inline, rather than waiting on the worker
+    void setNonRealtime(bool shouldBeNonRealtime) { nonRealtime = shouldBeNonRealtime; }
+
+    // Passes the input through while no response is loaded
+    void process(const juce::dsp::ProcessContextReplacing<float>& context);
+
+private:
+    ConvolutionSetup* setup = nullptr;
+    const ConvolutionSetup::Response* response = nullptr;
+    ConvolutionSetup::Tail* tail = nullptr;
+
+    std::unique_ptr<juce::dsp::FFT> bodyFft;
+
+    // The previous head partition of input followed by the one being filled
+    std::vector<float> window;
+
+    std::vector<float> bodyDelayLine;
+    int bodyDelayLineHead = 0;
+    std::vector<float> fftBuffer;
+
+    // The body's share of the partition being filled, worked out from the ones before it
+    std::vector<float> bodyOutput;
+    int bodyPosition = 0;
+
+    // Collected for the tail, and the tail's share of this partition
+    std::vector<float> tailInput, tailOutput;
+    int tailPosition = 0;
+
+    // Each block ramps from where the last one ended
+    float mix = 1.f, gain = 1.f;
+    float targetMix = 1.f, targetGain = 1.f;
+    bool nonRealtime = false;
+
+    void clearState();
+
+    void processBodyPartition();
+    void handOverTail();
+    void waitForTail() const;
+};
@@ -25,6 +25,10 @@ static juce::String getNameFromDSPOption(JUCE_MultiFX_ProcessorAudioProcessor::D
         return "LADDERFILTER";
     case JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option::GeneralFilter:
         return "GENFILTER";
+    case JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option::Delay:
+        return "DELAY";
+    case JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option::Convolution:
+        return "CONVOLUTION";
     case JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option::END_OF_LIST:
         jassertfalse;
     }
@@ -44,10 +48,41 @@ static JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option getDSPOptionFromName(con
         return JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option::LadderFilter;
     else if (name == "GENFILTER")
         return JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option::GeneralFilter;
+    else if (name == "DELAY")
+        return JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option::Delay;
+    else if (name == "CONVOLUTION")
+        return JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option::Convolution;
 
     return JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option::END_OF_LIST;
 }
 
+// Instances after the first are numbered, and slots on a band after the first say which: "PHASE 2 (B3)"
+static juce::String getTabNameFromChainSlot(JUCE_MultiFX_ProcessorAudioProcessor::ChainSlot slot)
+{
+    auto name = getNameFromDSPOption(slot.option);
+    if (slot.instance != 0)
+        name << " " << (slot.instance + 1);
+
+    return slot.band == 0 ? name : name + " (B" + juce::String(slot.band + 1) + ")";
+}
+
+static JUCE_MultiFX_ProcessorAudioProcessor::ChainSlot getChainSlotFromTabName(const juce::String& tabName)
+{
+    auto name = tabName;
+    auto band = 0;
+    if (name.endsWithChar(')') && name.contains(" (B"))
+    {
+        band = name.fromLastOccurrenceOf(" (B", false, false).dropLastCharacters(1).getIntValue() - 1;
+        name = name.upToLastOccurrenceOf(" (B", false, false);
+    }
+
+    auto number = name.fromLastOccurrenceOf(" ", false, false);
+    if (name.containsChar(' ') && number.containsOnly("0123456789"))
+        return { getDSPOptionFromName(name.upToLastOccurrenceOf(" ", false, false)), number.getIntValue() - 1, band };
+
+    return { getDSPOptionFromName(name), 0, band };
+}
+
 //==============================================================================
 HorizontalConstrainer::HorizontalConstrainer(std::function<juce::Rectangle<int>()> confinerBoundsGetter, 
     std::function<juce::Rectangle<int>()> confineeBoundsGetter)
@@ -88,8 +123,8 @@ void HorizontalConstrainer::checkBounds(juce::Rectangle<int>& bounds,
 
 //==============================================================================
 ExtendedTabBarButton::ExtendedTabBarButton(const juce::String& name, juce::TabbedButtonBar& owner, 
-    JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option dspOption)
-    : juce::TabBarButton(name, owner), option(dspOption)
+    JUCE_MultiFX_ProcessorAudioProcessor::ChainSlot chainSlot)
+    : juce::TabBarButton(name, owner), slot(chainSlot)
 {
     constrainer = std::make_unique<HorizontalConstrainer>(
         [&owner]() { return owner.getLocalBounds(); },
@@ -301,23 +336,30 @@ void ExtendedTabbedButtonBar::itemDropped(const SourceDetails& dragSourceDetails
         resized();
     }
 
+	auto newOrder = getOrder();
+
+    listeners.call([newOrder](Listener& l) {
+		l.tabOrderChanged(newOrder);
+        });
+
+}
+
+JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order ExtendedTabbedButtonBar::getOrder()
+{
 	auto tabs = getTabs();
-	JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order newOrder;
+	JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order order;
 
-	jassert(tabs.size() == newOrder.size());
     for (int i = 0; i < tabs.size(); ++i)
     {
-		auto tab = tabs[static_cast<int>(i)];
-        if (auto etbb = dynamic_cast<ExtendedTabBarButton*>(tab))
+        if (auto etbb = dynamic_cast<ExtendedTabBarButton*>(tabs[i]))
         {
-			newOrder[i] = etbb->getOption();
+            auto added = order.add(etbb->getSlot());
+			jassert(added); // Every tab should hold a different module instance
+            juce::ignoreUnused(added);
         }
     }
 
-    listeners.call([newOrder](Listener& l) {
-		l.tabOrderChanged(newOrder);
-        });
-
+    return order;
 }
 
 void ExtendedTabbedButtonBar::mouseDown(const juce::MouseEvent& e)
@@ -372,8 +414,8 @@ void PowerButtonWithParam::changeAttachment(juce::AudioParameterBool* p)
 
 juce::TabBarButton* ExtendedTabbedButtonBar::createTabButton(const juce::String& tabName, int tabIndex)
 {
-	auto dspOption = getDSPOptionFromName(tabName);
-	auto etbb = std::make_unique<ExtendedTabBarButton>(tabName, *this, dspOption);
+	auto chainSlot = getChainSlotFromTabName(tabName);
+	auto etbb = std::make_unique<ExtendedTabBarButton>(tabName, *this, chainSlot);
 	etbb->addMouseListener(this, false);
 	return etbb.release();
 }
@@ -397,16 +439,49 @@ void ExtendedTabbedButtonBar::currentTabChanged(int newCurrentTabIndex, const ju
 }
 
 //==============================================================================
-DSP_Gui::DSP_Gui(JUCE_MultiFX_ProcessorAudioProcessor& proc)
-    : processor(proc)
+DSP_Page::DSP_Page(const std::vector< juce::RangedAudioParameter* >& params)
 {
-}
+    for (auto* p : params)
+    {
+        // The bypass is not in the list, it lives on the tab's power button
+        if (dynamic_cast<juce::AudioParameterBool*>(p) != nullptr)
+        {
+            buttons.push_back(std::make_unique<juce::ToggleButton>(p->getName(100)));
+            buttonAttachments.push_back(std::make_unique<juce::ButtonParameterAttachment>(*p, *buttons.back()));
+            buttonAttachments.back()->sendInitialUpdate();
+        }
+        else
+        {
+            sliders.push_back(std::make_unique<RotarySliderWithLabels>(p, p->label, p->getName(100)));
+            auto& slider = *sliders.back();
+            SimpleMBComp::addLabelPairs(slider.labels, *p, p->label);
+            slider.setSliderStyle(juce::Slider::SliderStyle::LinearVertical);
+            sliderAttachments.push_back(std::make_unique<juce::SliderParameterAttachment>(*p, slider));
+            sliderAttachments.back()->sendInitialUpdate();
+        }
+    }
 
+    for (auto& slider : sliders)
+    {
+		addAndMakeVisible(slider.get());
+    }
+    for (auto& cb : comboBoxes)
+    {
+		addAndMakeVisible(cb.get());
+    }
+    for (auto& btn : buttons)
+    {
+        addAndMakeVisible(btn.get());
+    }
+}
 
+void DSP_Page::resized()  
+{
+    layoutControls(getLocalBounds());
+}
 
-void DSP_Gui::resized()  
+void DSP_Page::layoutControls(juce::Rectangle<int> bounds)
 {
-	auto bounds = getLocalBounds();
     if (buttons.empty() == false)
     {
 		auto buttonArea = bounds.removeFromTop(30);
@@ -429,118 +504,292 @@ void DSP_Gui::resized()
 
     if (sliders.empty() == false)
     {
-        auto w = bounds.getWidth() / sliders.size();
-        for (auto& slider : sliders)
+        // Modules with many controls, like the general filter's bands, wrap onto more rows
+        const auto numSliders = static_cast<int>(sliders.size());
+        const auto numRows = (numSliders + MaxSlidersPerRow - 1) / MaxSlidersPerRow;
+        const auto perRow = (numSliders + numRows - 1) / numRows;
+        const auto rowHeight = bounds.getHeight() / numRows;
+
+        auto row = bounds.removeFromTop(rowHeight);
+        auto w = bounds.getWidth() / perRow;
+        for (int i = 0; i < numSliders; ++i)
         {
-            slider->setBounds(bounds.removeFromLeft(static_cast<int>(w)));
+            if (i > 0 && i % perRow == 0)
+                row = bounds.removeFromTop(rowHeight);
+
+            sliders[static_cast<size_t>(i)]->setBounds(row.removeFromLeft(w));
         }
     }
 }
 
+void DSP_Page::setControlsEnabled(bool enabled)
+{
+    for (auto& slider : sliders)
+		slider->setEnabled(enabled);
+    for (auto& cb : comboBoxes)
+		cb->setEnabled(enabled);
+    for (auto& btn : buttons)
+		btn->setEnabled(enabled);
+}
+
+//==============================================================================
+ConvolutionPage::ConvolutionPage(JUCE_MultiFX_ProcessorAudioProcessor& p, int inst)
+    : DSP_Page(p.getParamsForOption(JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option::Convolution, inst)),
+      processor(p),
+      instance(inst)
+{
+    loadButton.onClick = [this]() { chooseFile(); };
+    clearButton.onClick = [this]()
+        {
+            processor.loadImpulseResponse(instance, juce::File());
+            refreshFileLabel();
+        };
+
+    fileLabel.setJustificationType(juce::Justification::centredLeft);
+
+    addAndMakeVisible(loadButton);
+    addAndMakeVisible(clearButton);
+    addAndMakeVisible(fileLabel);
+
+    refreshFileLabel();
+}
+
+void ConvolutionPage::resized()
+{
+    auto bounds = getLocalBounds();
+
+    auto fileArea = bounds.removeFromTop(30);
+    loadButton.setBounds(fileArea.removeFromLeft(100).reduced(2));
+    clearButton.setBounds(fileArea.removeFromLeft(100).reduced(2));
+    fileLabel.setBounds(fileArea.reduced(2));
+
+    layoutControls(bounds);
+}
+
+void ConvolutionPage::visibilityChanged()
+{
+    // A session or preset may have brought a different response since the page was last shown
+    if (isVisible())
+        refreshFileLabel();
+}
+
+void ConvolutionPage::chooseFile()
+{
+    chooser = std::make_unique<juce::FileChooser>("Load an impulse response", processor.getImpulseResponseFile(instance), "*.wav");
+
+    chooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+        [safeThis = juce::Component::SafePointer<ConvolutionPage>(this)](const juce::FileChooser& fc)
+        {
+            auto file = fc.getResult();
+            if (safeThis == nullptr || file == juce::File())
+                return;
+
+            safeThis->processor.loadImpulseResponse(safeThis->instance, file);
+            safeThis->refreshFileLabel();
+        });
+}
+
+void ConvolutionPage::refreshFileLabel()
+{
+    auto file = processor.getImpulseResponseFile(instance);
+    fileLabel.setText(file == juce::File() ? juce::String("No impulse response") : file.getFileName(), juce::dontSendNotification);
+}
+
+//==============================================================================
+DSP_Gui::DSP_Gui(JUCE_MultiFX_ProcessorAudioProcessor& proc)
+    : processor(proc)
+{
+}
+
+void DSP_Gui::resized()  
+{
+    // Hidden pages are laid out when they are next shown
+    if (currentPage != nullptr)
+        currentPage->setBounds(getLocalBounds());
+}
+
 void DSP_Gui::paint(juce::Graphics& g)
 {
     //g.fillAll(juce::Colours::black);
     g.fillAll(ColorScheme::getBackgroundColor());
 }
 
-void DSP_Gui::rebuildInterface(std::vector< juce::RangedAudioParameter* > params)
+void DSP_Gui::showPage(JUCE_MultiFX_ProcessorAudioProcessor::ChainSlot slot)
 {
-    if (params == currentParams)
+    auto& page = pages[static_cast<size_t>(slot.instance)][static_cast<size_t>(slot.option)];
+    if (page == nullptr)
     {
-		// No need to rebuild if the parameters haven't changed
-		DBG("INTERFACE REBUILD SKIPPED: No changes in parameters");
-        return;
+        const auto& params = processor.getParamsForOption(slot.option, slot.instance);
+        jassert(params.empty() == false); // Ensure we have parameters for the selected DSP option
+
+        if (slot.option == JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option::Convolution)
+            page = std::make_unique<ConvolutionPage>(processor, slot.instance);
+        else
+            page = std::make_unique<DSP_Page>(params);
+
+        addChildComponent(page.get());
     }
 
-	// Interface rebuild
-	currentParams = params;
+    if (page.get() == currentPage)
+        return;
+
+    hidePage();
+
+    currentPage = page.get();
+    currentPage->setBounds(getLocalBounds());
+    currentPage->setVisible(true);
+}
 
-	sliderAttachments.clear();
-	comboBoxAttachments.clear();
-	buttonAttachments.clear();
+void DSP_Gui::hidePage()
+{
+    if (currentPage != nullptr)
+        currentPage->setVisible(false);
+
+    currentPage = nullptr;
+}
 
-	sliders.clear();
-	comboBoxes.clear();
-	buttons.clear();
+void DSP_Gui::toggleSliderEnablement(bool enabled)
+{
+    if (currentPage != nullptr)
+        currentPage->setControlsEnabled(enabled);
+}
 
-    for (size_t i = 0; i < params.size(); ++i)
+//==============================================================================
+PresetBar::PresetBar(JUCE_MultiFX_ProcessorAudioProcessor& p)
+    : processor(p)
+{
+    for (size_t i = 0; i < snapshotButtons.size(); ++i)
     {
-		auto p = params[i];
+        auto& button = snapshotButtons[i];
+        auto slot = static_cast<int>(i);
 
-        if (dynamic_cast<juce::AudioParameterBool*>(p))
-        {
-            DBG("Skipping button attachment");
-        }
-        else
-        {
-            sliders.push_back(std::make_unique<RotarySliderWithLabels>(p, p->label, p->getName(100)));
-            auto& slider = *sliders.back();
-            SimpleMBComp::addLabelPairs(slider.labels, *p, p->label);
-            slider.setSliderStyle(juce::Slider::SliderStyle::LinearVertical);
-            sliderAttachments.push_back(
-                std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>
-                (processor.apvts, p->getName(100), slider));
-        }
+        button.setButtonText(juce::String::charToString(static_cast<char>('A' + slot)));
 
-#if false
-		if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(p)) // Choice parameters
-        {
-			/*comboBoxes.push_back(std::make_unique<juce::ComboBox>());
-			auto& cb = *comboBoxes.back();
-			cb.addItemList(choice->choices, 1);
-            comboBoxAttachments.push_back(
-                std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>
-                (processor.apvts, p->getName(100), cb));*/
-        }
-		else if (auto* toggle = dynamic_cast<juce::AudioParameterBool*>(p)) // Toggle parameters
-        {
-			// Creating a power button for toggling
+        // Click recalls a snapshot, shift-click stores the current state into it
+        button.onClick = [this, slot]()
+            {
+                if (juce::ModifierKeys::getCurrentModifiers().isShiftDown())
+                    processor.storeSnapshot(slot);
+                else
+                    processor.recallSnapshot(slot);
 
-			/*buttons.push_back(std::make_unique<juce::ToggleButton>("Bypass"));
-			auto& btn = *buttons.back();
-            buttonAttachments.push_back(
-                std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>
-				(processor.apvts, p->getName(100), btn));*/
-        }
-		else // Slider parameters
-        {
-            sliders.push_back(std::make_unique<RotarySliderWithLabels>(p, p->label, p->getName(100)));
-            auto& slider = *sliders.back();
-            SimpleMBComp::addLabelPairs(slider.labels, *p, p->label);
-			slider.setSliderStyle(juce::Slider::SliderStyle::LinearVertical);
-            sliderAttachments.push_back(
-				std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>
-				(processor.apvts, p->getName(100), slider));
-        }
-#endif
+                refreshSnapshotButtons();
+            };
+
+        addAndMakeVisible(button);
     }
 
+    presetBox.setTextWhenNothingSelected("PRESETS");
+    presetBox.onChange = [this]()
+        {
+            auto index = presetBox.getSelectedItemIndex();
+            if (index >= 0)
+                processor.loadPresetFromBank(index);
+        };
+    addAndMakeVisible(presetBox);
+
+    saveButton.onClick = [this]() { showSaveDialog(); };
+    addAndMakeVisible(saveButton);
+
+    morphButton.setClickingTogglesState(true);
+    morphButtonAttachment = std::make_unique<juce::ButtonParameterAttachment>(*processor.snapshotMorphEnabled, morphButton);
+    morphButtonAttachment->sendInitialUpdate();
+    addAndMakeVisible(morphButton);
+
+    morphSliderAttachment = std::make_unique<juce::SliderParameterAttachment>(*processor.snapshotMorphPosition, morphSlider);
+    morphSliderAttachment->sendInitialUpdate();
+    addAndMakeVisible(morphSlider);
+
+    rateBox.addItemList(processor.internalRate->choices, 1);
+    rateBox.setTooltip("Internal processing rate, applied when the host restarts processing");
+    rateBoxAttachment = std::make_unique<juce::ComboBoxParameterAttachment>(*processor.internalRate, rateBox);
+    rateBoxAttachment->sendInitialUpdate();
+    addAndMakeVisible(rateBox);
+
+    stereoBox.addItemList(processor.stereoMode->choices, 1);
+    stereoBox.setTooltip("What the chain processes: left and right, mid and side, or only one of mid and side");
+    stereoBoxAttachment = std::make_unique<juce::ComboBoxParameterAttachment>(*processor.stereoMode, stereoBox);
+    stereoBoxAttachment->sendInitialUpdate();
+    addAndMakeVisible(stereoBox);
+
+    limiterButton.setClickingTogglesState(true);
+    limiterButton.setTooltip("True peak limiter on the output, engaged when the host restarts processing");
+    limiterButtonAttachment = std::make_unique<juce::ButtonParameterAttachment>(*processor.limiterEnabled, limiterButton);
+    limiterButtonAttachment->sendInitialUpdate();
+    addAndMakeVisible(limiterButton);
+
+    refreshPresetList();
+    refreshSnapshotButtons();
+}
 
-    for (auto& slider : sliders)
-    {
-		addAndMakeVisible(slider.get());
-    }
-    for (auto& cb : comboBoxes)
+void PresetBar::resized()
+{
+    auto bounds = getLocalBounds();
+
+    auto snapshotArea = bounds.removeFromLeft(bounds.getHeight() * static_cast<int>(snapshotButtons.size()));
+    for (auto& button : snapshotButtons)
+        button.setBounds(snapshotArea.removeFromLeft(bounds.getHeight()));
+
+    saveButton.setBounds(bounds.removeFromRight(bounds.getHeight() * 3));
+    rateBox.setBounds(bounds.removeFromRight(bounds.getHeight() * 4));
+    stereoBox.setBounds(bounds.removeFromRight(bounds.getHeight() * 4));
+    limiterButton.setBounds(bounds.removeFromRight(bounds.getHeight() * 3));
+
+    morphButton.setBounds(bounds.removeFromLeft(bounds.getHeight() * 3));
+    morphSlider.setBounds(bounds.removeFromLeft(bounds.getWidth() / 3));
+
+    presetBox.setBounds(bounds);
+}
+
+void PresetBar::paint(juce::Graphics& g)
+{
+    g.fillAll(ColorScheme::getBackgroundColor());
+}
+
+void PresetBar::refreshPresetList()
+{
+    presetBox.clear(juce::dontSendNotification);
+
+    const PresetBank& bank = *processor.presetBank;
+    for (int i = 0; i < bank.getNumPresets(); ++i)
     {
-		addAndMakeVisible(cb.get());
+        auto tags = bank.getPresetTags(i);
+        auto text = tags.isEmpty() ? bank.getPresetName(i) : bank.getPresetName(i) + " [" + tags.joinIntoString(", ") + "]";
+        presetBox.addItem(text, i + 1);
     }
-    for (auto& btn : buttons)
+}
+
+void PresetBar::refreshSnapshotButtons()
+{
+    for (size_t i = 0; i < snapshotButtons.size(); ++i)
     {
-        addAndMakeVisible(btn.get());
+        auto slot = static_cast<int>(i);
+        snapshotButtons[i].setToggleState(slot == processor.getActiveSnapshot(), juce::dontSendNotification);
+        snapshotButtons[i].setAlpha(processor.hasSnapshot(slot) || slot == processor.getActiveSnapshot() ? 1.f : 0.5f);
     }
-
-	resized();
-       
 }
 
-void DSP_Gui::toggleSliderEnablement(bool enabled)
+void PresetBar::showSaveDialog()
 {
-    for (auto& slider : sliders)
-		slider->setEnabled(enabled);
-    for (auto& cb : comboBoxes)
-		cb->setEnabled(enabled);
-    for (auto& btn : buttons)
-		btn->setEnabled(enabled);
+    auto* window = new juce::AlertWindow("SAVE PRESET", "", juce::MessageBoxIconType::NoIcon, this);
+    window->addTextEditor("name", "", "Name");
+    window->addTextEditor("tags", "", "Tags (comma separated)");
+    window->addButton("SAVE", 1, juce::KeyPress(juce::KeyPress::returnKey));
+    window->addButton("CANCEL", 0, juce::KeyPress(juce::KeyPress::escapeKey));
+
+    juce::Component::SafePointer<PresetBar> safeThis(this);
+    window->enterModalState(true, juce::ModalCallbackFunction::create([safeThis, window](int result)
+        {
+            if (result != 1 || safeThis == nullptr)
+                return;
+
+            auto tags = juce::StringArray::fromTokens(window->getTextEditorContents("tags"), ",", "");
+            tags.trim();
+            tags.removeEmptyStrings();
+
+            if (safeThis->processor.savePresetToBank(window->getTextEditorContents("name"), tags))
+                safeThis->refreshPresetList();
+        }), true);
 }
 
 //==============================================================================
@@ -549,10 +798,16 @@ JUCE_MultiFX_ProcessorAudioProcessorEditor::JUCE_MultiFX_ProcessorAudioProcessor
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setLookAndFeel(&lookAndFeel);
+    setLookAndFeel(lookAndFeel);
 
 	addAndMakeVisible(tabbedComponent);
+	addAndMakeVisible(addSlotButton);
+	addAndMakeVisible(removeSlotButton);
+
+    addSlotButton.onClick = [this]() { showAddSlotMenu(); };
+    removeSlotButton.onClick = [this]() { removeCurrentSlot(); };
 	addAndMakeVisible(dspGUI);
+	addAndMakeVisible(presetBar);
 
 	addAndMakeVisible(analyzer);
 
@@ -562,11 +817,16 @@ JUCE_MultiFX_ProcessorAudioProcessorEditor::JUCE_MultiFX_ProcessorAudioProcessor
 	outGainControl = std::make_unique<RotarySliderWithLabels>(
         audioProcessor.outputGain, "dB", "OUT");
 
+	mixControl = std::make_unique<RotarySliderWithLabels>(
+        audioProcessor.mixPercent, "%", "MIX");
+
 	addAndMakeVisible(inGainControl.get());
 	addAndMakeVisible(outGainControl.get());
+	addAndMakeVisible(mixControl.get());
 
 	SimpleMBComp::addLabelPairs(inGainControl->labels, *audioProcessor.inputGain, "dB");
 	SimpleMBComp::addLabelPairs(outGainControl->labels, *audioProcessor.outputGain, "dB");
+	SimpleMBComp::addLabelPairs(mixControl->labels, *audioProcessor.mixPercent, "%");
 
     inGainAttachment = std::make_unique<juce::SliderParameterAttachment>(
 		*audioProcessor.inputGain, *inGainControl);
@@ -574,6 +834,9 @@ JUCE_MultiFX_ProcessorAudioProcessorEditor::JUCE_MultiFX_ProcessorAudioProcessor
 	outGainAttachment = std::make_unique<juce::SliderParameterAttachment>(
         *audioProcessor.outputGain, *outGainControl);
 
+	mixAttachment = std::make_unique<juce::SliderParameterAttachment>(
+        *audioProcessor.mixPercent, *mixControl);
+
 	audioProcessor.guiNeedsLatestDspOrder.set(true);
 
 	tabbedComponent.addListener(this);
@@ -625,31 +888,46 @@ void JUCE_MultiFX_ProcessorAudioProcessorEditor::paint (juce::Graphics& g)
 
 	
 
-    auto drawTicks = [&](auto rect, auto leftMeterRightEdge, auto rightMeterLeftEdge)
+    auto drawTicks = [&](juce::Rectangle<int> rect, int leftMeterRightEdge, int rightMeterLeftEdge)
         {
-            juce::Font meterFont = lookAndFeel.getIBMPlexMonoMediumFont(static_cast<float>(fontHeight) * 0.7f);
-            g.setFont(meterFont);
-
-            for (int i = MAX_DECIBELS; i >= NEGATIVE_INFINITY; i -= 12)
+            // The scale never changes between repaints, only the levels under it do
+            auto key = MeterScaleCache::Key
             {
-				auto y = juce::jmap<int>(i, NEGATIVE_INFINITY, MAX_DECIBELS, rect.getBottom(), rect.getY());
-                auto r = juce::Rectangle<int>(rect.getWidth(), fontHeight);
-                r.setCentre(rect.getCentreX(), y);
+                rect.getWidth(), rect.getHeight(),
+                leftMeterRightEdge - rect.getX(), rightMeterLeftEdge - rect.getX(),
+                g.getInternalContext().getPhysicalPixelScaleFactor()
+            };
+
+            auto scale = meterScales->get(key, [this, &key](juce::Graphics& sg, juce::Rectangle<int> area)
+                {
+                    juce::Font meterFont = lookAndFeel->getIBMPlexMonoMediumFont(static_cast<float>(fontHeight) * 0.7f);
+                    sg.setFont(meterFont);
 
-				g.setColour(i == 0 ? ColorScheme::getTitleColor() :
-                    i > 0 ? ColorScheme::getIndustrialRed() :
-                    ColorScheme::getTitleColor());
+                    for (int i = MAX_DECIBELS; i >= NEGATIVE_INFINITY; i -= 12)
+                    {
+                        auto y = juce::jmap<int>(i, NEGATIVE_INFINITY, MAX_DECIBELS, area.getBottom(), area.getY());
+                        auto r = juce::Rectangle<int>(area.getWidth(), fontHeight);
+                        r.setCentre(area.getCentreX(), y);
 
-				g.drawFittedText(juce::String(i), r, juce::Justification::centred, 1);
+                        sg.setColour(i == 0 ? ColorScheme::getTitleColor() :
+                            i > 0 ? ColorScheme::getIndustrialRed() :
+                            ColorScheme::getTitleColor());
 
-				g.setColour(ColorScheme::getBackgroundColor());
+                        sg.drawFittedText(juce::String(i), r, juce::Justification::centred, 1);
 
-                if (i != MAX_DECIBELS && i != NEGATIVE_INFINITY)
-                {
-                    g.drawLine(rect.getX() + tickIndent, y, leftMeterRightEdge - tickIndent, y);
-					g.drawLine(rightMeterLeftEdge + tickIndent, y, rect.getRight() - tickIndent, y);
-                }
-            }
+                        sg.setColour(ColorScheme::getBackgroundColor());
+
+                        if (i != MAX_DECIBELS && i != NEGATIVE_INFINITY)
+                        {
+                            sg.drawLine(static_cast<float>(area.getX() + tickIndent), static_cast<float>(y),
+                                        static_cast<float>(key.leftMeterRightEdge - tickIndent), static_cast<float>(y));
+                            sg.drawLine(static_cast<float>(key.rightMeterLeftEdge + tickIndent), static_cast<float>(y),
+                                        static_cast<float>(area.getRight() - tickIndent), static_cast<float>(y));
+                        }
+                    }
+                });
+
+            g.drawImage(scale, rect.toFloat());
         };
 
     auto drawMeter = [&fillMeter, &drawTicks](juce::Rectangle<int> rect, 
@@ -689,13 +967,21 @@ void JUCE_MultiFX_ProcessorAudioProcessorEditor::paint (juce::Graphics& g)
     g.fillRect(postMeterArea);
     g.fillRect(ioArea);
 
+    // The mix control sits under the output meter
+    postMeterArea.removeFromBottom(ioControlSize);
+
     drawMeter(preMeterArea, g, 
         audioProcessor.leftPreRMS, audioProcessor.rightPreRMS,
 		"");
 
+    // The limiter's gain reduction goes under the output meter while it's switched on
+    auto postLabel = juce::String();
+    if (audioProcessor.limiterEnabled->get())
+        postLabel = "GR " + juce::String(audioProcessor.limiterGainReduction.get(), 1);
+
     drawMeter(postMeterArea, g,
         audioProcessor.leftPostRMS, audioProcessor.rightPostRMS,
-        "");
+        postLabel);
 	
 }
 
@@ -712,10 +998,15 @@ void JUCE_MultiFX_ProcessorAudioProcessorEditor::resized()
 	auto rightMeterArea = bounds.removeFromRight(meterWidth);
 	inGainControl->setBounds(leftMeterArea.removeFromBottom(ioControlSize));
     outGainControl->setBounds(rightMeterArea.removeFromBottom(ioControlSize));
+    mixControl->setBounds(rightMeterArea.removeFromBottom(ioControlSize));
 
+    presetBar.setBounds(bounds.removeFromTop(presetBarHeight));
 	analyzer.setBounds(bounds.removeFromTop(bounds.getHeight() * 0.7));
 
-    tabbedComponent.setBounds(bounds.removeFromTop(30));
+    auto tabArea = bounds.removeFromTop(30);
+    removeSlotButton.setBounds(tabArea.removeFromRight(tabArea.getHeight()));
+    addSlotButton.setBounds(tabArea.removeFromRight(tabArea.getHeight()));
+    tabbedComponent.setBounds(tabArea);
 	dspGUI.setBounds(bounds);
 
 }
@@ -723,7 +1014,7 @@ void JUCE_MultiFX_ProcessorAudioProcessorEditor::resized()
 void JUCE_MultiFX_ProcessorAudioProcessorEditor::tabOrderChanged(JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order newOrder)
 {
     rebuildInterface();
-	audioProcessor.dspOrderFifo.push(newOrder);
+	audioProcessor.setDspOrder(newOrder);
 }
 
 void JUCE_MultiFX_ProcessorAudioProcessorEditor::timerCallback()
@@ -731,19 +1022,21 @@ void JUCE_MultiFX_ProcessorAudioProcessorEditor::timerCallback()
     
 	repaint();
 
+    // Snapshots can also be switched by the host through program changes
+    presetBar.refreshSnapshotButtons();
+
     if (audioProcessor.restoreDspOrderFifo.getNumAvailableForReading() == 0)
         return;
 
 	using T = JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order;
 	T newOrder;
-	newOrder.fill(JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option::END_OF_LIST);
-    auto empty = newOrder;
+    bool orderPulled = false;
     while (audioProcessor.restoreDspOrderFifo.pull(newOrder))
     {
-        ;
+        orderPulled = true;
     }
 
-    if (newOrder != empty)
+    if (orderPulled)
     {
 		addTabsFromDSPOrder(newOrder);
 	}
@@ -753,14 +1046,11 @@ void JUCE_MultiFX_ProcessorAudioProcessorEditor::timerCallback()
         selectedTabAttachment = std::make_unique<juce::ParameterAttachment>(*audioProcessor.selectedTab,[this](float tabNum)
             {
 				auto newTabNum = static_cast<int>(tabNum);
+                // The chain may have been shortened since the tab was selected
                 if (juce::isPositiveAndBelow(newTabNum, tabbedComponent.getNumTabs()))
                 {
 					tabbedComponent.setCurrentTabIndex(newTabNum);
                 }
-                else
-                {
-					jassertfalse; // Invalid tab index
-                }
             });
 		selectedTabAttachment->sendInitialUpdate();
     }
@@ -769,9 +1059,9 @@ void JUCE_MultiFX_ProcessorAudioProcessorEditor::timerCallback()
 void JUCE_MultiFX_ProcessorAudioProcessorEditor::addTabsFromDSPOrder(JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order newOrder)
 {
     tabbedComponent.clearTabs();
-    for (auto v : newOrder)
+    for (const auto& slot : newOrder)
     {
-		tabbedComponent.addTab(getNameFromDSPOption(v), ColorScheme::getTitleColor(), -1);
+		tabbedComponent.addTab(getTabNameFromChainSlot(slot), ColorScheme::getTitleColor(), -1);
 
 	}
 
@@ -781,10 +1071,8 @@ void JUCE_MultiFX_ProcessorAudioProcessorEditor::addTabsFromDSPOrder(JUCE_MultiF
     {
         if (auto tab = tabbedComponent.getTabButton(i))
         {
-            auto order = newOrder[i];
-            auto params = audioProcessor.getParamsForOption(order);
-
-            if (auto bypass = findBypassParam(params))
+            auto slot = newOrder[static_cast<size_t>(i)];
+            if (auto bypass = audioProcessor.getBypassParam(slot.option, slot.instance))
             {
                 auto pbwp = std::make_unique<PowerButtonWithParam>(bypass);
                 pbwp->setSize(size, size);
@@ -808,25 +1096,86 @@ void JUCE_MultiFX_ProcessorAudioProcessorEditor::addTabsFromDSPOrder(JUCE_MultiF
     }
 
     tabbedComponent.setTabColours();
+    addSlotButton.setEnabled(newOrder.isFull() == false);
+    removeSlotButton.setEnabled(newOrder.empty() == false);
+
     rebuildInterface();
-	audioProcessor.dspOrderFifo.push(newOrder);
+	audioProcessor.setDspOrder(newOrder);
 }   
 
+void JUCE_MultiFX_ProcessorAudioProcessorEditor::showAddSlotMenu()
+{
+    using Processor = JUCE_MultiFX_ProcessorAudioProcessor;
+    auto order = tabbedComponent.getOrder();
+
+    // Menu item IDs have to be non-zero, so they hold the encoded slot plus one
+    auto makeBandMenu = [&order](int band)
+    {
+        juce::PopupMenu menu;
+        for (int instance = 0; instance < Processor::NumModuleInstances; ++instance)
+        {
+            for (int i = 0; i < static_cast<int>(Processor::DSP_Option::END_OF_LIST); ++i)
+            {
+                Processor::ChainSlot slot { static_cast<Processor::DSP_Option>(i), instance, band };
+                menu.addItem(Processor::encodeChainSlot(slot) + 1, getTabNameFromChainSlot(slot), order.contains(slot) == false);
+            }
+        }
+        return menu;
+    };
+
+    // With the signal split, each band gets a submenu of its own
+    const auto numBands = audioProcessor.bandCount->get();
+    juce::PopupMenu menu = numBands > 1 ? juce::PopupMenu() : makeBandMenu(0);
+    for (int band = 0; numBands > 1 && band < numBands; ++band)
+        menu.addSubMenu("Band " + juce::String(band + 1), makeBandMenu(band));
+
+    menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&addSlotButton),
+        [safeThis = juce::Component::SafePointer<JUCE_MultiFX_ProcessorAudioProcessorEditor>(this)](int result)
+        {
+            if (safeThis == nullptr || result == 0)
+                return;
+
+            auto picked = Processor::decodeOrder({ result - 1 });
+            auto newOrder = safeThis->tabbedComponent.getOrder();
+            if (picked.empty() || newOrder.add(picked[0]) == false)
+                return;
+
+            safeThis->addTabsFromDSPOrder(newOrder);
+            safeThis->tabbedComponent.setCurrentTabIndex(static_cast<int>(newOrder.size()) - 1);
+        });
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessorEditor::removeCurrentSlot()
+{
+    auto index = tabbedComponent.getCurrentTabIndex();
+    auto newOrder = tabbedComponent.getOrder();
+    if (juce::isPositiveAndBelow(index, static_cast<int>(newOrder.size())) == false)
+        return;
+
+    newOrder.remove(static_cast<size_t>(index));
+    addTabsFromDSPOrder(newOrder);
+
+    if (newOrder.empty() == false)
+        tabbedComponent.setCurrentTabIndex(juce::jmin(index, static_cast<int>(newOrder.size()) - 1));
+}
+
 void JUCE_MultiFX_ProcessorAudioProcessorEditor::rebuildInterface()
 {
 	auto currentTabIndex = tabbedComponent.getCurrentTabIndex();
 	auto currentTab = tabbedComponent.getTabButton(currentTabIndex);
     if (auto etbb = dynamic_cast<ExtendedTabBarButton*>(currentTab))
     {
-		auto option = etbb->getOption();
-		auto params = audioProcessor.getParamsForOption(option);
-		jassert(params.empty() == false); // Ensure we have parameters for the selected DSP option
-		dspGUI.rebuildInterface(params);
+		dspGUI.showPage(etbb->getSlot());
         if (auto btn = dynamic_cast<PowerButtonWithParam*>(etbb->getExtraComponent()))
         {
 			refreshDSPGUIControlEnablement(btn);
         }
     }
+    else
+    {
+        // Every slot was removed
+        dspGUI.hidePage();
+    }
 }
 
 void JUCE_MultiFX_ProcessorAudioProcessorEditor::selectedTabChanged(int newCurrentTabIndex)
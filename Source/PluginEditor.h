@@ -13,20 +13,7 @@
 #include <LookAndFeel.h>
 #include <CustomButtons.h> // PowerButton
 #include <SpectrumAnalyzer.h>
-
-template<typename ParamsContainer>
-static juce::AudioParameterBool* findBypassParam(ParamsContainer& params)
-{
-    for (auto* p : params)
-    {
-        if (auto* bypass = dynamic_cast<juce::AudioParameterBool*>(p))
-        {
-            if (bypass->getName(100).contains("Bypass"))
-                return bypass;
-        }
-    }
-    return nullptr;
-}
+#include "SharedResources.h"
 
 struct ExtendedTabbedButtonBar : juce::TabbedButtonBar, juce::DragAndDropTarget, juce::DragAndDropContainer
 {
@@ -58,6 +45,9 @@ struct ExtendedTabbedButtonBar : juce::TabbedButtonBar, juce::DragAndDropTarget,
 
     void setTabColours();
 
+    // The chain as the tabs currently show it
+    JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order getOrder();
+
 private:
     juce::TabBarButton* findDraggedItem(const SourceDetails& dragSourceDetails);
 	int FindDraggedItemIndex(const SourceDetails& dragSourceDetails);
@@ -90,7 +80,7 @@ private:
 
 struct ExtendedTabBarButton : juce::TabBarButton
 {
-    ExtendedTabBarButton(const juce::String& name, juce::TabbedButtonBar& owner, JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option dspOption);
+    ExtendedTabBarButton(const juce::String& name, juce::TabbedButtonBar& owner, JUCE_MultiFX_ProcessorAudioProcessor::ChainSlot chainSlot);
 	juce::ComponentDragger dragger;
 	std::unique_ptr<HorizontalConstrainer> constrainer;
 
@@ -98,38 +88,83 @@ struct ExtendedTabBarButton : juce::TabBarButton
 
     void mouseDrag(const juce::MouseEvent& e) override;
 
-    JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option getOption() const { return option; }
+    JUCE_MultiFX_ProcessorAudioProcessor::ChainSlot getSlot() const { return slot; }
 
     int getBestTabLength(int depth) override;
 
 private:
-    JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option option;
+    JUCE_MultiFX_ProcessorAudioProcessor::ChainSlot slot;
 
 };
 
 struct RotarySliderWithLabels;
 
+// The controls of one module instance, built the first time that instance is shown
+struct DSP_Page : juce::Component
+{
+    DSP_Page(const std::vector< juce::RangedAudioParameter* >& params);
+
+    void resized() override;
+
+    void setControlsEnabled(bool enabled);
+
+protected:
+    // Lays the controls out in bounds, pages with more on them keep the rest
+    void layoutControls(juce::Rectangle<int> bounds);
+
+private:
+    static constexpr int MaxSlidersPerRow = 12;
+
+    std::vector<std::unique_ptr<RotarySliderWithLabels>> sliders;
+    std::vector<std::unique_ptr<juce::ComboBox>> comboBoxes;
+    std::vector<std::unique_ptr<juce::Button>> buttons;
+
+    std::vector<std::unique_ptr<juce::SliderParameterAttachment>> sliderAttachments;
+    std::vector<std::unique_ptr<juce::ComboBoxParameterAttachment>> comboBoxAttachments;
+    std::vector<std::unique_ptr<juce::ButtonParameterAttachment>> buttonAttachments;
+};
+
+// The convolution module's controls, under the impulse response's file and a button to load another
+struct ConvolutionPage : DSP_Page
+{
+    ConvolutionPage(JUCE_MultiFX_ProcessorAudioProcessor& p, int instance);
+
+    void resized() override;
+    void visibilityChanged() override;
+
+private:
+    JUCE_MultiFX_ProcessorAudioProcessor& processor;
+    const int instance;
+
+    juce::TextButton loadButton { "LOAD IR" }, clearButton { "CLEAR" };
+    juce::Label fileLabel;
+    std::unique_ptr<juce::FileChooser> chooser;
+
+    void chooseFile();
+    void refreshFileLabel();
+};
+
+/*
+Shows the page of the selected tab. Pages are kept once built, so switching tabs,
+reordering or removing a slot only changes which page is visible.
+*/
 struct DSP_Gui : juce::Component
 {
     DSP_Gui(JUCE_MultiFX_ProcessorAudioProcessor& p);
 
-
     void resized() override;
     void paint(juce::Graphics& g) override;
 
-    void rebuildInterface(std::vector< juce::RangedAudioParameter* > params);
+    void showPage(JUCE_MultiFX_ProcessorAudioProcessor::ChainSlot slot);
+    void hidePage();
 	void toggleSliderEnablement(bool enabled);
 
+private:
 	JUCE_MultiFX_ProcessorAudioProcessor& processor;
-    std::vector<std::unique_ptr<RotarySliderWithLabels>> sliders;
-    std::vector<std::unique_ptr<juce::ComboBox>> comboBoxes;
-    std::vector<std::unique_ptr<juce::Button>> buttons;
-
-    std::vector<std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>> sliderAttachments;
-    std::vector<std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment>> comboBoxAttachments;
-    std::vector<std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment>> buttonAttachments;
 
-	std::vector< juce::RangedAudioParameter* > currentParams;
+    std::array<std::array<std::unique_ptr<DSP_Page>, JUCE_MultiFX_ProcessorAudioProcessor::NumOptions>,
+               JUCE_MultiFX_ProcessorAudioProcessor::NumModuleInstances> pages;
+    DSP_Page* currentPage = nullptr;
 };
 
 //==============================================================================
@@ -144,6 +179,41 @@ private:
 	juce::AudioParameterBool* param;
 };
 
+//==============================================================================
+
+struct PresetBar : juce::Component
+{
+    PresetBar(JUCE_MultiFX_ProcessorAudioProcessor& p);
+
+    void resized() override;
+    void paint(juce::Graphics& g) override;
+
+    void refreshPresetList();
+    void refreshSnapshotButtons();
+
+private:
+    void showSaveDialog();
+
+    JUCE_MultiFX_ProcessorAudioProcessor& processor;
+    std::array<juce::TextButton, JUCE_MultiFX_ProcessorAudioProcessor::NumSnapshots> snapshotButtons;
+    juce::ComboBox presetBox;
+    juce::TextButton saveButton { "SAVE" };
+
+    juce::TextButton morphButton { "MORPH" };
+    juce::Slider morphSlider { juce::Slider::LinearHorizontal, juce::Slider::NoTextBox };
+    std::unique_ptr<juce::ButtonParameterAttachment> morphButtonAttachment;
+    std::unique_ptr<juce::SliderParameterAttachment> morphSliderAttachment;
+
+    juce::ComboBox rateBox;
+    std::unique_ptr<juce::ComboBoxParameterAttachment> rateBoxAttachment;
+
+    juce::ComboBox stereoBox;
+    std::unique_ptr<juce::ComboBoxParameterAttachment> stereoBoxAttachment;
+
+    juce::TextButton limiterButton { "LIMIT" };
+    std::unique_ptr<juce::ButtonParameterAttachment> limiterButtonAttachment;
+};
+
 //==============================================================================
 /**
 */
@@ -166,9 +236,12 @@ private:
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     JUCE_MultiFX_ProcessorAudioProcessor& audioProcessor;
-    LookAndFeel lookAndFeel;
+    juce::SharedResourcePointer<LookAndFeel> lookAndFeel;
+    juce::SharedResourcePointer<MeterScaleCache> meterScales;
     DSP_Gui dspGUI { audioProcessor } ;
+    PresetBar presetBar { audioProcessor };
 	ExtendedTabbedButtonBar tabbedComponent;
+    juce::TextButton addSlotButton { "+" }, removeSlotButton { "-" };
 
     SimpleMBComp::SpectrumAnalyzer analyzer
     {
@@ -182,15 +255,19 @@ private:
     static constexpr int tickIndent = 8;
     static constexpr int meterChanWidth = 18;
     static constexpr int ioControlSize = 100;
+    static constexpr int presetBarHeight = 24;
 
-	std::unique_ptr<RotarySliderWithLabels> inGainControl, outGainControl;
-	std::unique_ptr<juce::SliderParameterAttachment> inGainAttachment, outGainAttachment;
+	std::unique_ptr<RotarySliderWithLabels> inGainControl, outGainControl, mixControl;
+	std::unique_ptr<juce::SliderParameterAttachment> inGainAttachment, outGainAttachment, mixAttachment;
 
 	std::unique_ptr<juce::ParameterAttachment> selectedTabAttachment;
 
     void addTabsFromDSPOrder(JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order dspOrder);
     void rebuildInterface();
 
+    void showAddSlotMenu();
+    void removeCurrentSlot();
+
     void refreshDSPGUIControlEnablement(PowerButtonWithParam* button);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (JUCE_MultiFX_ProcessorAudioProcessorEditor)
@@ -9,29 +9,6 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
-auto getPhaserRateName() { return juce::String("Phaser Rate (Hz)"); }
-auto getPhaserDepthName() { return juce::String("Phaser Depth (%)"); }
-auto getPhaserCenterFreqName() { return juce::String("Phaser Center Frequency (Hz)"); }
-auto getPhaserFeedbackName() { return juce::String("Phaser Feedback (%)"); }
-auto getPhaserMixName() { return juce::String("Phaser Mix (%)"); }
-auto getPhaserBypassName() { return juce::String("Phaser Bypass"); }
-
-auto getChorusRateName() { return juce::String("Chorus Rate (Hz)"); }
-auto getChorusDepthName() { return juce::String("Chorus Depth (%)"); }
-auto getChorusCenterDelayName() { return juce::String("Chorus Center Delay (Ms)"); }
-auto getChorusFeedbackName() { return juce::String("Chorus Feedback (%)"); }
-auto getChorusMixName() { return juce::String("Chorus Mix (%)"); }
-auto getChorusBypassName() { return juce::String("Chorus Bypass"); }
-
-auto getOverdriveSaturationName() { return juce::String("Overdrive Saturation"); }
-auto getOverdriveBypassName() { return juce::String("Overdrive Bypass"); }
-
-auto getLadderFilterModeName() { return juce::String("Ladder Filter Mode"); }
-auto getLadderFilterCutoffName() { return juce::String("Ladder Filter Cutoff (Hz)"); }
-auto getLadderFilterResonanceName() { return juce::String("Ladder Filter Resonance"); }
-auto getLadderFilterDriveName() { return juce::String("Ladder Filter Drive"); }
-auto getLadderFilterBypassName() { return juce::String("Ladder Filter Bypass"); }
-
 auto getLadderFilterChoices() 
 {
     return juce::StringArray
@@ -45,12 +22,6 @@ auto getLadderFilterChoices()
     };
 }
 
-auto getGeneralFilterModeName() { return juce::String("General Filter Mode"); }
-auto getGeneralFilterFreqName() { return juce::String("General Filter Frequency (Hz)"); }
-auto getGeneralFilterQualityName() { return juce::String("General Filter Quality"); }
-auto getGeneralFilterGainName() { return juce::String("General Filter Gain (dB)"); }
-auto getGeneralFilterBypassName() { return juce::String("General Filter Bypass"); }
-
 auto getGeneralFilterChoices()
 {
     return juce::StringArray
@@ -58,14 +29,190 @@ auto getGeneralFilterChoices()
         "Peak",
         "Bandpass",
         "Notch",
-        "Allpass"
+        "Allpass",
+        "Low Shelf",
+        "High Shelf"
     };
 }
 
+/*
+Synced delay lengths in beats, paired with the choices shown for them.
+T is a triplet, a trailing dot is a dotted note.
+*/
+static const std::array<std::pair<const char*, double>, 14>& getDelayNotes()
+{
+    static const std::array<std::pair<const char*, double>, 14> notes
+    {{
+        { "1/1", 4.0 },
+        { "1/2", 2.0 },
+        { "1/2.", 3.0 },
+        { "1/2T", 4.0 / 3.0 },
+        { "1/4", 1.0 },
+        { "1/4.", 1.5 },
+        { "1/4T", 2.0 / 3.0 },
+        { "1/8", 0.5 },
+        { "1/8.", 0.75 },
+        { "1/8T", 1.0 / 3.0 },
+        { "1/16", 0.25 },
+        { "1/16.", 0.375 },
+        { "1/16T", 1.0 / 6.0 },
+        { "1/32", 0.125 },
+    }};
+    return notes;
+}
+
+auto getDelayNoteChoices()
+{
+    juce::StringArray choices;
+    for (const auto& [name, beats] : getDelayNotes())
+        choices.add(name);
+    return choices;
+}
+
 auto getSelectedTabName() { return juce::String("Selected Tab"); }
 
 auto getInputGainName() { return juce::String("Input Gain (dB)"); }
 auto getOutputGainName() { return juce::String("Output Gain (dB)"); }
+auto getMixName() { return juce::String("Mix (%)"); }
+
+auto getSnapshotMorphTimeName() { return juce::String("Snapshot Morph Time (ms)"); }
+auto getSnapshotMorphName() { return juce::String("Snapshot Morph"); }
+auto getSnapshotMorphEnabledName() { return juce::String("Snapshot Morph Enabled"); }
+
+auto getInternalRateName() { return juce::String("Internal Rate"); }
+auto getStereoModeName() { return juce::String("Stereo Mode"); }
+auto getBandCountName() { return juce::String("Band Count"); }
+
+auto getLimiterName() { return juce::String("Limiter"); }
+auto getLimiterCeilingName() { return juce::String("Limiter Ceiling (dBTP)"); }
+auto getLimiterReleaseName() { return juce::String("Limiter Release (ms)"); }
+
+juce::String getCrossoverFrequencyName(int index) { return "Crossover " + juce::String(index + 1) + " (Hz)"; }
+juce::String getBandBypassName(int band) { return "Band " + juce::String(band + 1) + " Bypass"; }
+
+// 0 runs the chain at the host's rate
+static constexpr std::array<double, 5> internalRates { 0.0, 44100.0, 48000.0, 88200.0, 96000.0 };
+
+static juce::String getModuleName(JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option option)
+{
+    using DSP_Option = JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option;
+    switch (option)
+    {
+    case DSP_Option::Phase:         return "Phaser";
+    case DSP_Option::Chorus:        return "Chorus";
+    case DSP_Option::Overdrive:     return "Overdrive";
+    case DSP_Option::LadderFilter:  return "Ladder Filter";
+    case DSP_Option::GeneralFilter: return "General Filter";
+    case DSP_Option::Delay:         return "Delay";
+    case DSP_Option::Convolution:   return "Convolution";
+    case DSP_Option::END_OF_LIST:   break;
+    }
+    jassertfalse;
+    return {};
+}
+
+/*
+Instance 0 keeps the original names so existing sessions load unchanged, later
+instances are numbered after the module name: "Phaser 2 Rate (Hz)".
+*/
+static juce::String getInstanceName(const juce::String& name, JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option option, int instance)
+{
+    if (instance == 0)
+        return name;
+
+    auto module = getModuleName(option);
+    jassert(name.startsWith(module));
+    return module + " " + juce::String(instance + 1) + name.substring(module.length());
+}
+
+juce::String JUCE_MultiFX_ProcessorAudioProcessor::getModuleParamID(ModuleParam param, int instance)
+{
+    auto index = static_cast<size_t>(param);
+    return getInstanceName(moduleParamIDs[index], moduleParamOwners[index], instance);
+}
+
+juce::String JUCE_MultiFX_ProcessorAudioProcessor::getModuleParamName(ModuleParam param, int instance)
+{
+    auto index = static_cast<size_t>(param);
+    return getInstanceName(moduleParamNames[index], moduleParamOwners[index], instance);
+}
+
+// Same order as ModuleParameters::getParamsNeedingSmoothing()
+static std::array<juce::String, JUCE_MultiFX_ProcessorAudioProcessor::ModuleParameters::NumSmoothed> getModuleSmoothedNames(int instance)
+{
+    using Processor = JUCE_MultiFX_ProcessorAudioProcessor;
+
+    std::array<juce::String, Processor::ModuleParameters::NumSmoothed> names;
+    for (size_t i = 0; i < names.size(); ++i)
+        names[i] = Processor::getModuleParamName(Processor::ModuleParameters::smoothedOrder[i], instance);
+
+    return names;
+}
+
+/*
+Lays the smoothed parameters out in the order they were added to the plugin: the
+first instance's modules up to the general filter, the global controls, the first
+instance's delay, each further instance up to its delay, then the modules added
+since for every instance in turn. Modulation targets are stored in sessions as
+indices into this order.
+*/
+template<typename T, size_t NumPerInstance, size_t NumInstances, size_t NumGlobal>
+static std::array<T, NumPerInstance * NumInstances + NumGlobal> arrangeSmoothedParams(
+    const std::array<std::array<T, NumPerInstance>, NumInstances>& instances,
+    const std::array<T, NumGlobal>& globals)
+{
+    using Parameters = JUCE_MultiFX_ProcessorAudioProcessor::ModuleParameters;
+    constexpr auto numOriginal = static_cast<std::ptrdiff_t>(NumPerInstance - Parameters::NumAppendedSmoothed);
+    constexpr auto numBeforeGlobals = numOriginal - static_cast<std::ptrdiff_t>(Parameters::NumDelaySmoothed);
+
+    std::array<T, NumPerInstance * NumInstances + NumGlobal> arranged {};
+    auto out = std::copy(instances[0].begin(), instances[0].begin() + numBeforeGlobals, arranged.begin());
+    out = std::copy(globals.begin(), globals.end(), out);
+    out = std::copy(instances[0].begin() + numBeforeGlobals, instances[0].begin() + numOriginal, out);
+
+    for (size_t i = 1; i < NumInstances; ++i)
+        out = std::copy(instances[i].begin(), instances[i].begin() + numOriginal, out);
+
+    for (size_t i = 0; i < NumInstances; ++i)
+        out = std::copy(instances[i].begin() + numOriginal, instances[i].end(), out);
+
+    return arranged;
+}
+
+/*
+Modulation targets, in getParamsNeedingSmoothing() order.
+Sessions store the target as an index into this list, only ever append to it.
+*/
+static juce::StringArray getModulationTargetNames()
+{
+    using Processor = JUCE_MultiFX_ProcessorAudioProcessor;
+    std::array<std::array<juce::String, Processor::ModuleParameters::NumSmoothed>, Processor::NumModuleInstances> instanceNames;
+    for (size_t i = 0; i < instanceNames.size(); ++i)
+        instanceNames[i] = getModuleSmoothedNames(static_cast<int>(i));
+
+    auto globalNames = std::array
+    {
+        getInputGainName(),
+        getOutputGainName(),
+        getMixName(),
+    };
+
+    juce::StringArray targetNames;
+    for (const auto& name : arrangeSmoothedParams(instanceNames, globalNames))
+        targetNames.add(name);
+
+    return targetNames;
+}
+
+static juce::String getSnapshotName(int slot) { return juce::String::charToString(static_cast<char>('A' + slot)); }
+
+// The state property holding the path of an instance's impulse response
+static juce::Identifier getImpulseResponsePropertyName(int instance)
+{
+    return instance == 0 ? "ConvolutionImpulse" : "ConvolutionImpulse" + juce::String(instance + 1);
+}
+
+static_assert(ConvolutionWorker::MaxInstances == JUCE_MultiFX_ProcessorAudioProcessor::NumModuleInstances);
 
 //==============================================================================
 JUCE_MultiFX_ProcessorAudioProcessor::JUCE_MultiFX_ProcessorAudioProcessor()
@@ -74,6 +221,7 @@ JUCE_MultiFX_ProcessorAudioProcessor::JUCE_MultiFX_ProcessorAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
@@ -81,122 +229,149 @@ JUCE_MultiFX_ProcessorAudioProcessor::JUCE_MultiFX_ProcessorAudioProcessor()
 #endif
 {
 
-    for (size_t i = 0; i < static_cast<size_t>(DSP_Option::END_OF_LIST); ++i)
-    {
-		dspOrder[i] = static_cast<DSP_Option>(i);
-	}
+    dspOrder = makeDefaultOrder();
+    requestedDspOrder = dspOrder;
+    allocateDelayRings(dspOrder);
 
 	restoreDspOrderFifo.push(dspOrder);
 
-    auto floatParams = std::array
-    {
-		&phaserRateHz,
-		&phaserDepthPercent,
-		&phaserCenterFreqHz,
-		&phaserFeedbackPercent,
-        &phaserMixPercent,
-
-        &chorusRateHz,
-        &chorusDepthPercent,
-        &chorusCenterDelayMs,
-        &chorusFeedbackPercent,
-        &chorusMixPercent,
-
-        &overdriveSaturation,
+    for (size_t i = 0; i < moduleParams.size(); ++i)
+        moduleParams[i].attach(apvts, static_cast<int>(i));
 
-        &ladderFilterCutoffHz,
-        &ladderFilterResonance,
-        &ladderFilterDrive,
-
-        &generalFilterFreqHz,
-        &generalFilterQuality,
-        &generalFilterGain,
+    for (size_t i = 0; i < channels.size(); ++i)
+        channels[i].setChainIndex(static_cast<int>(i));
 
+    auto floatParams = std::array
+    {
         &inputGain,
 		&outputGain,
+        &mixPercent,
+
+        &snapshotMorphTimeMs,
+        &snapshotMorphPosition,
+
+        &limiterCeiling,
+        &limiterRelease,
     };
 
     auto floatNameFuncs = std::array
     {
-		&getPhaserRateName,
-		&getPhaserDepthName,
-		&getPhaserCenterFreqName,
-        &getPhaserFeedbackName,
-        &getPhaserMixName,
-
-        &getChorusRateName,
-        &getChorusDepthName,
-        &getChorusCenterDelayName,
-        &getChorusFeedbackName,
-        &getChorusMixName,
-
-		&getOverdriveSaturationName,
-
-        &getLadderFilterCutoffName,
-        &getLadderFilterResonanceName,
-        &getLadderFilterDriveName,
-
-		&getGeneralFilterFreqName,
-        &getGeneralFilterQualityName,
-		&getGeneralFilterGainName,
-
 		&getInputGainName,
 		&getOutputGainName,
+        &getMixName,
 
+        &getSnapshotMorphTimeName,
+        &getSnapshotMorphName,
+
+        &getLimiterCeilingName,
+        &getLimiterReleaseName,
     };
 
 	initCachedParams<juce::AudioParameterFloat*>(floatParams, floatNameFuncs);
 
-	auto choiceParams = std::array
-    {
-        &ladderFilterMode,
-        &generalFilterMode,
-    };
-
-    auto choiceNameFuncs = std::array
+    auto boolParams = std::array
     {
-        &getLadderFilterModeName,
-        &getGeneralFilterModeName,
+        &snapshotMorphEnabled,
+        &limiterEnabled,
     };
 
-    initCachedParams<juce::AudioParameterChoice*>(choiceParams, choiceNameFuncs);
-
-    auto bypassParams = std::array
-    {
-        &phaserBypass,
-        &chorusBypass,
-        &overdriveBypass,
-        &ladderFilterBypass,
-        &generalFilterBypass,
-	};
-
-    auto bypassNameFuncs = std::array
+    auto boolNameFuncs = std::array
     {
-        &getPhaserBypassName,
-        &getChorusBypassName,
-        &getOverdriveBypassName,
-        &getLadderFilterBypassName,
-        &getGeneralFilterBypassName,
+        &getSnapshotMorphEnabledName,
+        &getLimiterName,
     };
 
-	initCachedParams<juce::AudioParameterBool*>(bypassParams, bypassNameFuncs);
+    initCachedParams<juce::AudioParameterBool*>(boolParams, boolNameFuncs);
 
     auto intParams = std::array
     {
         &selectedTab,
+        &bandCount,
 	};
 
     auto intFuncs = std::array
     {
         &getSelectedTabName,
+        &getBandCountName,
 	};
 
 	initCachedParams<juce::AudioParameterInt*>(intParams, intFuncs);
 
+    auto choiceParams = std::array
+    {
+        &internalRate,
+        &stereoMode,
+    };
+
+    auto choiceFuncs = std::array
+    {
+        &getInternalRateName,
+        &getStereoModeName,
+    };
+
+    initCachedParams<juce::AudioParameterChoice*>(choiceParams, choiceFuncs);
+
+    for (size_t i = 0; i < crossoverFrequencies.size(); ++i)
+    {
+        crossoverFrequencies[i] = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter(getCrossoverFrequencyName(static_cast<int>(i))));
+        jassert(crossoverFrequencies[i] != nullptr);
+    }
+
+    for (size_t i = 0; i < bandBypasses.size(); ++i)
+    {
+        bandBypasses[i] = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter(getBandBypassName(static_cast<int>(i))));
+        jassert(bandBypasses[i] != nullptr);
+    }
+
+    for (const auto& paramID : latencyParamIDs)
+        apvts.addParameterListener(paramID, this);
+
+    for (const auto& paramID : getEqBandParamIDs())
+        apvts.addParameterListener(paramID, this);
+
+    modulationMatrix.attachParameters(apvts);
+
+#if JUCE_DEBUG
+    auto targetNames = getModulationTargetNames();
+    auto smoothedParams = getParamsNeedingSmoothing();
+    jassert(targetNames.size() == static_cast<int>(smoothedParams.size()));
+    for (size_t i = 0; i < smoothedParams.size(); ++i)
+        jassert(targetNames[static_cast<int>(i)] == smoothedParams[i]->getName(100));
+#endif
+
+    jassert(getParameters().size() <= MaxSnapshotParams);
+
+    // Changes to the smoothed parameters made on the audio thread are timed, see parameterValueChanged()
+    smoothedParamIndices.fill(-1);
+    auto timedParams = getParamsNeedingSmoothing();
+    for (size_t i = 0; i < timedParams.size(); ++i)
+    {
+        smoothedParamIndices[static_cast<size_t>(timedParams[i]->getParameterIndex())] = static_cast<int>(i);
+        timedParams[i]->addListener(this);
+    }
+
+    // Pick the SIMD kernels at load rather than on the first audio callback. The tests verify them
+    SimdKernels::get();
+    DBG("SIMD kernels: " << SimdKernels::getIsaName(SimdKernels::getActiveIsa()));
+
+    // Only the first instance reads the bank, parameter indices are the same in every one
+    if (presetBank->loadAttempted == false)
+        reloadPresetBank(PresetBank::getDefaultBankFile());
 }
 
 JUCE_MultiFX_ProcessorAudioProcessor::~JUCE_MultiFX_ProcessorAudioProcessor()
 {
+    for (const auto& paramID : latencyParamIDs)
+        apvts.removeParameterListener(paramID, this);
+
+    for (const auto& paramID : getEqBandParamIDs())
+        apvts.removeParameterListener(paramID, this);
+
+    for (auto* param : getParamsNeedingSmoothing())
+        param->removeListener(this);
+
+    cancelPendingUpdate();
+    stopTimer();
 }
 
 //==============================================================================
@@ -234,27 +409,40 @@ bool JUCE_MultiFX_ProcessorAudioProcessor::isMidiEffect() const
 
 double JUCE_MultiFX_ProcessorAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return tailLengthSeconds.load();
 }
 
 int JUCE_MultiFX_ProcessorAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    // The snapshot slots come first, followed by the presets in the bank
+    return NumSnapshots + presetBank->getNumPresets();
 }
 
 int JUCE_MultiFX_ProcessorAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram;
 }
 
 void JUCE_MultiFX_ProcessorAudioProcessor::setCurrentProgram (int index)
 {
+    if (juce::isPositiveAndBelow(index, NumSnapshots))
+    {
+        recallSnapshot(index);
+    }
+    else if (loadPresetFromBank(index - NumSnapshots) == false)
+    {
+        return;
+    }
+
+    currentProgram = index;
 }
 
 const juce::String JUCE_MultiFX_ProcessorAudioProcessor::getProgramName (int index)
 {
-    return {};
+    if (juce::isPositiveAndBelow(index, NumSnapshots))
+        return "Snapshot " + getSnapshotName(index);
+
+    return presetBank->getPresetName(index - NumSnapshots);
 }
 
 void JUCE_MultiFX_ProcessorAudioProcessor::changeProgramName (int index, const juce::String& newName)
@@ -267,25 +455,94 @@ void JUCE_MultiFX_ProcessorAudioProcessor::prepareToPlay (double sampleRate, int
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
 
+    maximumHostBlockSize = samplesPerBlock;
+    hostSampleRate = sampleRate;
+    worstCallbackLoad.set(0.f);
+    numCallbackOverruns.set(0);
+    numOversizeBlocks.set(0);
+
+    // With an internal rate chosen, the chain and everything feeding it are prepared for that rate
+    fixedRate.prepare(sampleRate, getInternalRateHz(), getMainBusNumInputChannels(), samplesPerBlock);
+    processingSampleRate = fixedRate.getProcessingRate();
+    const auto processingBlockSize = fixedRate.getMaximumProcessingBlockSize();
+
+    for (int instance = 0; instance < NumModuleInstances; ++instance)
+        linearPhaseEngaged[static_cast<size_t>(instance)] = isLinearPhaseSwitchedOn(instance);
+
+    numLinearPhaseEngaged = static_cast<int>(std::count(linearPhaseEngaged.begin(), linearPhaseEngaged.end(), true));
+    limiterEngaged = limiterEnabled->get();
+    setLatencySamples(getTotalLatencySamples(fixedRate, numLinearPhaseEngaged, limiterEngaged));
+
+    outputLimiter.prepare(sampleRate, getMainBusNumOutputChannels());
+    limiterGainReduction.set(0.f);
+
+    // Sets still queued were designed before this prepare, start again from the parameters
+    eqBandsSampleRate = processingSampleRate;
+    while (eqBandsFifo.pull(pulledEqBands))
+        ;
+    eqBands = designEqBands(processingSampleRate);
+    ++eqBandsVersion;
+
+    designLinearPhaseKernels(eqBands);
+    for (auto& kernels : linearPhaseKernels)
+        kernels.acquire();
+
+    // Responses made for another rate are loaded again, the channels pass through until they arrive
+    convolutionWorker.setSampleRate(processingSampleRate);
+    for (auto& setup : activeConvolutions)
+    {
+        if (setup != nullptr && setup->getSampleRate() != processingSampleRate)
+        {
+            convolutionWorker.retire(setup);
+            setup = nullptr;
+        }
+    }
+
+    prepareDelayRings(processingSampleRate);
+
 	juce::dsp::ProcessSpec spec;
-	spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = samplesPerBlock;
+	spec.sampleRate = processingSampleRate;
+    spec.maximumBlockSize = static_cast<juce::uint32>(processingBlockSize);
 	spec.numChannels = 1; // Mono processing for each channel
 
-    leftChannel.prepare(spec);
-	rightChannel.prepare(spec);
+    // The channels pick up their initial bypass states from here
+    updateDiscreteValues();
+
+    for (auto& channel : channels)
+        channel.prepare(spec);
+
+    // Pairs the channels for ping-pong unless only one of them runs
+    activeStereoMode = StereoMode::END_OF_LIST;
+    updateStereoMode();
 
     for (auto smoother : getSmoothers())
     {
-        smoother->reset(sampleRate, 0.005);
+        smoother->reset(processingSampleRate, 0.005);
 	}
 
+    // Events were timed for the blocks before this prepare
+    parameterEvents.clear();
+    hasQueuedEvents.fill(false);
+    liveEventOffset = 0;
+
 	updateSmoothersFromParams(1, SmootherUpdateMode::initialize);
 
-    spec.numChannels = getTotalNumInputChannels();
+    spec.numChannels = getMainBusNumInputChannels();
+
+    inputGainLinear = juce::Decibels::decibelsToGain(inputGainSmoother.getCurrentValue());
+    outputGainLinear = juce::Decibels::decibelsToGain(outputGainSmoother.getCurrentValue());
+
+    // The dry side is mixed in before converting back, so it only waits for the chain itself
+    dryDelay.prepare(static_cast<int>(spec.numChannels), processingBlockSize, getChainLatencySamples(numLinearPhaseEngaged));
+    dryBuffer.setSize(static_cast<int>(spec.numChannels), processingBlockSize);
 
-    inputGainDSP.prepare(spec);
-    outputGainDSP.prepare(spec);
+    modulationMatrix.prepare(processingSampleRate, sampleRate);
+
+    crossover.prepare(processingSampleRate, processingBlockSize);
+    activeNumBands = 0;
+    bandRunning.fill(false);
+    bandProcessed.fill(false);
+    updateBands();
 
     leftSCSF.prepare(samplesPerBlock);
 	rightSCSF.prepare(samplesPerBlock);
@@ -294,242 +551,710 @@ void JUCE_MultiFX_ProcessorAudioProcessor::prepareToPlay (double sampleRate, int
 
 void JUCE_MultiFX_ProcessorAudioProcessor::updateSmoothersFromParams(int numSamplesToSkip, SmootherUpdateMode init)
 {
-    auto paramsNeedingSmoothing = std::vector
-    {
-        phaserRateHz,
-        phaserDepthPercent,
-        phaserCenterFreqHz,
-        phaserFeedbackPercent,
-        phaserMixPercent,
-        chorusRateHz,
-        chorusDepthPercent,
-        chorusCenterDelayMs,
-        chorusFeedbackPercent,
-        chorusMixPercent,
-        overdriveSaturation,
-        ladderFilterCutoffHz,
-        ladderFilterResonance,
-        ladderFilterDrive,
-        generalFilterFreqHz,
-        generalFilterQuality,
-        generalFilterGain,
-		inputGain,
-		outputGain,
-    };
-
+    auto paramsNeedingSmoothing = getParamsNeedingSmoothing();
 	auto smoothers = getSmoothers();
-	jassert(smoothers.size() == paramsNeedingSmoothing.size());
+
+    const auto isMorphing = snapshotMorph.samplesRemaining > 0 && init == SmootherUpdateMode::liveInRealtime;
+    const auto morphProgress = isMorphing ?
+        1.f - static_cast<float>(snapshotMorph.samplesRemaining) / static_cast<float>(snapshotMorph.totalSamples) : 1.f;
+
+    // A snapshot recall takes over from the morph engine until it has finished, a restored state from both
+    const auto useMorphEngine = isMorphing == false && holdingRestoredState == false && isMorphEngineActive();
+    morphEngineDrivingParams = useMorphEngine;
+    if (useMorphEngine)
+        snapshotMorpher.process(snapshotMorphPosition->get(), morphTargets.data(), morphDiscreteTargets.data());
 
     for (size_t i = 0; i < smoothers.size(); i++)
     {
 		auto smoother = smoothers[i];
 		auto param = paramsNeedingSmoothing[i];
 
+        if (hasQueuedEvents[i] == false)
+            automatedTargets[i] = param->get();
+
+        auto target = automatedTargets[i];
+        if (holdingRestoredState)
+            target = param->convertFrom0to1(restoredState.values[static_cast<size_t>(param->getParameterIndex())]);
+        else if (isMorphing)
+            target = juce::jmap(morphProgress, snapshotMorph.from[i], snapshotMorph.to[i]);
+        else if (useMorphEngine)
+            target = param->convertFrom0to1(morphTargets[i]);
+
+        if (isModulating)
+            target = param->convertFrom0to1(juce::jlimit(0.f, 1.f, param->convertTo0to1(target) + modulationOffsets[i]));
+
         if ( init == SmootherUpdateMode::initialize)
-			smoother->setCurrentAndTargetValue(param->get());
+			smoother->setCurrentAndTargetValue(target);
         else
-			smoother->setTargetValue(param->get());
+			smoother->setTargetValue(target);
 
 		smoother->skip(numSamplesToSkip);
     }
 
+    if (isMorphing)
+        snapshotMorph.samplesRemaining = juce::jmax(0, snapshotMorph.samplesRemaining - numSamplesToSkip);
 }
 
-void JUCE_MultiFX_ProcessorAudioProcessor::MonoChannelDSP::prepare(const juce::dsp::ProcessSpec& spec)
+bool JUCE_MultiFX_ProcessorAudioProcessor::addParameterEvent(const juce::AudioProcessorParameter& param, int sampleOffset, float normalisedValue)
 {
-	jassert(spec.numChannels == 1); // This DSP is designed for mono channels only
-    std::vector<juce::dsp::ProcessorBase*> dsp
-    {
-        &phaser,
-        &chorus,
-        &overdrive,
-        &ladderFilter,
-        &generalFilter
-    };
+    auto index = param.getParameterIndex();
+    if (juce::isPositiveAndBelow(index, MaxSnapshotParams) == false || smoothedParamIndices[static_cast<size_t>(index)] < 0)
+        return false; // Discrete parameters are read once per sub-block
 
-    for (auto p : dsp)
+    auto target = static_cast<size_t>(smoothedParamIndices[static_cast<size_t>(index)]);
+
+    // The sub-blocks count samples at the processing rate
+    return queueParameterEvent(target, juce::roundToInt(sampleOffset * fixedRate.getRateRatio()),
+                               getParamsNeedingSmoothing()[target]->convertFrom0to1(normalisedValue));
+}
+
+bool JUCE_MultiFX_ProcessorAudioProcessor::queueParameterEvent(size_t target, int offset, float value)
+{
+    if (parameterEvents.add(offset, target, value, MinSubBlockSize) == false)
     {
-        p->prepare(spec);
-        p->reset();
+        jassertfalse; // More automation points than one block can hold
+        return false;
     }
 
-	overdrive.dsp.setCutoffFrequencyHz(20000.f);
+    hasQueuedEvents[target] = true;
+    return true;
 }
 
-void JUCE_MultiFX_ProcessorAudioProcessor::releaseResources()
+void JUCE_MultiFX_ProcessorAudioProcessor::parameterValueChanged(int parameterIndex, float newValue)
 {
-    // When playback stops, you can use this as an opportunity to free up any
-    // spare memory, etc.
+    // The list belongs to the audio thread, anything else is read by the next sub-block
+    if (juce::Thread::getCurrentThreadId() != audioThreadId.load(std::memory_order_relaxed))
+        return;
+
+    if (juce::isPositiveAndBelow(parameterIndex, MaxSnapshotParams) == false || smoothedParamIndices[static_cast<size_t>(parameterIndex)] < 0)
+        return;
+
+    auto target = static_cast<size_t>(smoothedParamIndices[static_cast<size_t>(parameterIndex)]);
+    queueParameterEvent(target, liveEventOffset, getParamsNeedingSmoothing()[target]->convertFrom0to1(newValue));
 }
 
-#ifndef JucePlugin_PreferredChannelConfigurations
-bool JUCE_MultiFX_ProcessorAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+double JUCE_MultiFX_ProcessorAudioProcessor::getInternalRateHz() const
 {
-  #if JucePlugin_IsMidiEffect
-    juce::ignoreUnused (layouts);
-    return true;
-  #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
-        return false;
-
-    // This checks if the input layout matches the output layout
-   #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
-        return false;
-   #endif
+    return internalRates[static_cast<size_t>(juce::jlimit(0, static_cast<int>(internalRates.size()) - 1, internalRate->getIndex()))];
+}
 
-    return true;
-  #endif
+int JUCE_MultiFX_ProcessorAudioProcessor::getTotalLatencySamples(const FixedRateConverter& converter, int numLinearPhase, bool limiter) const
+{
+    // The chain's own latency is counted at the processing rate, the limiter's at the host's
+    return converter.getLatencySamples()
+         + juce::roundToInt(getChainLatencySamples(numLinearPhase) * getSampleRate() / converter.getProcessingRate())
+         + (limiter ? TruePeakLimiter::getLatencySamples(getSampleRate()) : 0);
 }
-#endif
 
-juce::AudioProcessorValueTreeState::ParameterLayout JUCE_MultiFX_ProcessorAudioProcessor::createParameterlayout() {
+juce::StringArray JUCE_MultiFX_ProcessorAudioProcessor::getLatencyParamIDs()
+{
+    juce::StringArray paramIDs { getInternalRateName(), getLimiterName() };
+    for (int instance = 0; instance < NumModuleInstances; ++instance)
+        paramIDs.add(getModuleParamID(ModuleParam::GeneralFilterLinearPhase, instance));
 
-	juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    return paramIDs;
+}
 
-    const int versionHint = 1;
-    
-    auto name = getInputGainName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{name, versionHint},
-        name,
-        juce::NormalisableRange<float>(-18.f, 18.f, 0.1f, 1.f),
-        0.f,
-        "dB"
-	));
+bool JUCE_MultiFX_ProcessorAudioProcessor::isLinearPhaseSwitchedOn(int instance) const
+{
+    return static_cast<juce::AudioParameterBool*>(moduleParams[static_cast<size_t>(instance)].get(ModuleParam::GeneralFilterLinearPhase))->get();
+}
 
-	name = getOutputGainName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{name, versionHint},
-        name,
-        juce::NormalisableRange<float>(-18.f, 18.f, 0.1f, 1.f),
-        0.f,
-        "dB"
-    ));
+int JUCE_MultiFX_ProcessorAudioProcessor::countLinearPhaseSwitches() const
+{
+    auto count = 0;
+    for (int instance = 0; instance < NumModuleInstances; ++instance)
+        count += isLinearPhaseSwitchedOn(instance) ? 1 : 0;
 
-	// Phaser parameters
-    /*
-    Phaser:
-    Rate: hz
-    Depth: 0 to 100
-    Center freq: hz
-    Feedback: -1 to 1
-    Mix: 0 to 1
-    */
+    return count;
+}
 
-	name = getPhaserRateName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{name, versionHint},
-        name,
-        juce::NormalisableRange<float>(0.01f, 2.f, 0.01f, 1.f),
-        0.2f,
-        "Hz"
-	));
+void JUCE_MultiFX_ProcessorAudioProcessor::designLinearPhaseKernels(const EqBandSet& set)
+{
+    // Instances switched off keep their last kernel, they're flat until a prepare engages them
+    for (int instance = 0; instance < NumModuleInstances; ++instance)
+    {
+        if (isLinearPhaseSwitchedOn(instance) == false)
+            continue;
 
-    name = getPhaserDepthName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{name, versionHint},
-        name,
-        juce::NormalisableRange<float>(0.0f, 100.f, 0.1f, 1.f),
-        5.f,
-        "%"
-	));
+        auto& kernels = linearPhaseKernels[static_cast<size_t>(instance)];
+        kernels.beginWrite().design(set.coefficients[static_cast<size_t>(instance)].data(), set.numBands[static_cast<size_t>(instance)]);
+        kernels.publish();
+    }
+}
 
-    name = getPhaserCenterFreqName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{name, versionHint},
-        name,
-        juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 1.f),
-        1000.f,
-        "Hz"
-    ));
-    name = getPhaserFeedbackName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{name, versionHint},
-        name,
-        juce::NormalisableRange<float>(-100.f, 100.f, 0.1f, 1.f),
-        0.0f,
-        "%"
-    ));
-    name = getPhaserMixName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{name, versionHint},
-        name,
-        juce::NormalisableRange<float>(0.f, 100.f, 0.1f, 1.f),
-        50.f,
-        "%"
-	));
+void JUCE_MultiFX_ProcessorAudioProcessor::loadImpulseResponse(int instance, const juce::File& file)
+{
+    if (juce::isPositiveAndBelow(instance, NumModuleInstances) == false)
+    {
+        jassertfalse;
+        return;
+    }
 
-    name = getPhaserBypassName();
-    layout.add(std::make_unique<juce::AudioParameterBool>(
-        juce::ParameterID{ name, versionHint },
-        name,
-        false
-    ));
+    apvts.state.setProperty(getImpulseResponsePropertyName(instance), file.getFullPathName(), nullptr);
+    convolutionWorker.requestLoad(instance, file);
+}
+
+juce::File JUCE_MultiFX_ProcessorAudioProcessor::getImpulseResponseFile(int instance) const
+{
+    if (juce::isPositiveAndBelow(instance, NumModuleInstances) == false)
+    {
+        jassertfalse;
+        return {};
+    }
+
+    return convolutionWorker.getFile(instance);
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::requestImpulseResponses()
+{
+    // Sessions without a response unload whatever was there
+    for (int instance = 0; instance < NumModuleInstances; ++instance)
+    {
+        auto path = apvts.state.getProperty(getImpulseResponsePropertyName(instance)).toString();
+        convolutionWorker.requestLoad(instance, juce::File::isAbsolutePath(path) ? juce::File(path) : juce::File());
+    }
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::updateConvolutions()
+{
+    for (int instance = 0; instance < NumModuleInstances; ++instance)
+    {
+        ConvolutionSetup* setup = nullptr;
+        if (convolutionWorker.pullSetup(instance, setup) == false)
+            continue;
+
+        // Loaded for the rate before the last prepare, the reload for this one is on its way
+        if (setup != nullptr && setup->getSampleRate() != processingSampleRate)
+        {
+            convolutionWorker.retire(setup);
+            continue;
+        }
+
+        for (auto& channel : channels)
+            channel.setConvolution(instance, setup);
+
+        trace.record(AudioTrace::Type::CoefficientsChanged, 1.f);
+
+        auto& active = activeConvolutions[static_cast<size_t>(instance)];
+        convolutionWorker.retire(active);
+        active = setup;
+    }
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::allocateDelayRings(const DSP_Order& order)
+{
+    const juce::ScopedLock sl(delayRingLock);
+
+    for (auto slot : order)
+    {
+        if (slot.option != DSP_Option::Delay)
+            continue;
+
+        const auto instance = static_cast<size_t>(slot.instance);
+        delayRingsRequested[instance] = true;
+
+        // Before the first prepare, prepareDelayRings() allocates it for the rate
+        if (delayRingSize > 0 && delayRingMemory[instance] == nullptr)
+        {
+            delayRingMemory[instance] = std::make_unique<float[]>(channels.size() * static_cast<size_t>(delayRingSize));
+            delayRings[instance].store(delayRingMemory[instance].get(), std::memory_order_release);
+        }
+    }
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::prepareDelayRings(double sampleRate)
+{
+    const juce::ScopedLock sl(delayRingLock);
+
+    const auto size = RingDelay::getRingSize(sampleRate);
+    if (size != delayRingSize)
+    {
+        delayRingSize = size;
+        for (auto& memory : delayRingMemory)
+            memory.reset();
+    }
+
+    for (size_t instance = 0; instance < delayRingMemory.size(); ++instance)
+    {
+        auto& memory = delayRingMemory[instance];
+        if (delayRingsRequested[instance] && memory == nullptr)
+            memory = std::make_unique<float[]>(channels.size() * static_cast<size_t>(delayRingSize));
+
+        delayRings[instance].store(memory.get(), std::memory_order_release);
+        activeDelayRings[instance] = memory.get();
+    }
+}
+
+float* JUCE_MultiFX_ProcessorAudioProcessor::getDelayRing(int instance, int chainIndex) const
+{
+    auto* ring = activeDelayRings[static_cast<size_t>(instance)];
+    return ring != nullptr ? ring + static_cast<size_t>(chainIndex) * static_cast<size_t>(delayRingSize) : nullptr;
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::updateDelayRings()
+{
+    for (int instance = 0; instance < NumModuleInstances; ++instance)
+    {
+        auto* ring = delayRings[static_cast<size_t>(instance)].load(std::memory_order_acquire);
+        if (ring == activeDelayRings[static_cast<size_t>(instance)])
+            continue;
+
+        activeDelayRings[static_cast<size_t>(instance)] = ring;
+        for (auto& channel : channels)
+            channel.updateDelayRing(instance);
+    }
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::parameterChanged(const juce::String& parameterID, float)
+{
+    // Can arrive on any thread, the new latency and the bands' coefficients are worked out on the message thread
+    if (latencyParamIDs.contains(parameterID))
+        latencyChanged = true;
+    else
+        eqBandParamsChanged = true;
+
+    triggerAsyncUpdate();
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::handleAsyncUpdate()
+{
+    if (eqBandParamsChanged.exchange(false))
+    {
+        if (auto sampleRate = eqBandsSampleRate.load(); sampleRate > 0.0)
+        {
+            auto set = designEqBands(sampleRate);
+            designLinearPhaseKernels(set);
+            eqBandsFifo.push(set);
+        }
+    }
+
+    if (latencyChanged.exchange(false) == false || getSampleRate() <= 0.0)
+        return;
+
+    // A throwaway converter, the audio thread keeps using the prepared one
+    FixedRateConverter converter;
+    converter.prepare(getSampleRate(), getInternalRateHz(), 1, 1);
 
     /*
-    Chorus:
+    Hosts restart processing when the latency changes, which brings the new rate
+    and switches in through prepareToPlay(). Ask for the restart even when it
+    hasn't changed.
+    */
+    auto latency = getTotalLatencySamples(converter, countLinearPhaseSwitches(), limiterEnabled->get());
+    if (latency != getLatencySamples())
+        setLatencySamples(latency);
+    else
+        updateHostDisplay(juce::AudioProcessor::ChangeDetails().withLatencyChanged(true));
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::ModuleParameters::attach(juce::AudioProcessorValueTreeState& apvts, int instance)
+{
+    // The only name lookups, everything after this goes through the registry
+    for (size_t i = 0; i < registry.size(); ++i)
+    {
+        auto& info = registry[i];
+        info.param = apvts.getParameter(getModuleParamID(static_cast<ModuleParam>(i), instance));
+        jassert(info.param != nullptr); // Ensure the parameter was created successfully
+
+        info.range = &info.param->getNormalisableRange();
+        info.module = moduleParamOwners[i];
+        info.instance = instance;
+
+        auto& controls = controlsByOption[static_cast<size_t>(info.module)];
+
+        switch (moduleParamKinds[i])
+        {
+        case ModuleParamKind::Float:
+            jassert(dynamic_cast<juce::AudioParameterFloat*>(info.param) != nullptr);
+            info.smoother = &smoothers[i];
+            controls.push_back(info.param);
+            break;
+        case ModuleParamKind::Static:
+            jassert(dynamic_cast<juce::AudioParameterFloat*>(info.param) != nullptr);
+            controls.push_back(info.param);
+            break;
+        case ModuleParamKind::Choice:
+            jassert(dynamic_cast<juce::AudioParameterChoice*>(info.param) != nullptr);
+            controls.push_back(info.param);
+            break;
+        case ModuleParamKind::Switch:
+            jassert(dynamic_cast<juce::AudioParameterBool*>(info.param) != nullptr);
+            controls.push_back(info.param);
+            break;
+        case ModuleParamKind::Bypass:
+            jassert(dynamic_cast<juce::AudioParameterBool*>(info.param) != nullptr);
+            break;
+        }
+    }
+}
+
+juce::AudioParameterBool* JUCE_MultiFX_ProcessorAudioProcessor::ModuleParameters::getBypass(DSP_Option option) const
+{
+    if (juce::isPositiveAndBelow(static_cast<size_t>(option), NumOptions) == false)
+    {
+        jassertfalse;
+        return nullptr;
+    }
+
+    return static_cast<juce::AudioParameterBool*>(get(moduleBypassParams[static_cast<size_t>(option)]));
+}
+
+const std::vector<juce::RangedAudioParameter*>& JUCE_MultiFX_ProcessorAudioProcessor::ModuleParameters::getParamsForOption(DSP_Option option) const
+{
+    jassert(juce::isPositiveAndBelow(static_cast<size_t>(option), NumOptions));
+    return controlsByOption[static_cast<size_t>(option)];
+}
+
+std::array<juce::AudioParameterFloat*, JUCE_MultiFX_ProcessorAudioProcessor::ModuleParameters::NumSmoothed> JUCE_MultiFX_ProcessorAudioProcessor::ModuleParameters::getParamsNeedingSmoothing() const
+{
+    std::array<juce::AudioParameterFloat*, NumSmoothed> params {};
+    for (size_t i = 0; i < params.size(); ++i)
+        params[i] = static_cast<juce::AudioParameterFloat*>(get(smoothedOrder[i]));
+
+    return params;
+}
+
+std::array<juce::SmoothedValue<float>*, JUCE_MultiFX_ProcessorAudioProcessor::ModuleParameters::NumSmoothed> JUCE_MultiFX_ProcessorAudioProcessor::ModuleParameters::getSmoothers()
+{
+    std::array<juce::SmoothedValue<float>*, NumSmoothed> result {};
+    for (size_t i = 0; i < result.size(); ++i)
+        result[i] = &smoothers[static_cast<size_t>(smoothedOrder[i])];
+
+	return result;
+}
+
+std::array<juce::AudioParameterFloat*, JUCE_MultiFX_ProcessorAudioProcessor::NumSmoothedParams> JUCE_MultiFX_ProcessorAudioProcessor::getParamsNeedingSmoothing() const
+{
+    std::array<std::array<juce::AudioParameterFloat*, ModuleParameters::NumSmoothed>, NumModuleInstances> instances;
+    for (size_t i = 0; i < instances.size(); ++i)
+        instances[i] = moduleParams[i].getParamsNeedingSmoothing();
+
+    return arrangeSmoothedParams(instances, std::array
+        {
+            inputGain,
+            outputGain,
+            mixPercent,
+        });
+}
+
+std::array<juce::RangedAudioParameter*, JUCE_MultiFX_ProcessorAudioProcessor::NumDiscreteParams> JUCE_MultiFX_ProcessorAudioProcessor::getDiscreteParams() const
+{
+    std::array<juce::RangedAudioParameter*, NumDiscreteParams> params {};
+    auto out = params.begin();
+
+    for (const auto& instance : moduleParams)
+    {
+        // Same order as DiscreteParam
+        auto instanceParams = std::array<juce::RangedAudioParameter*, NumDiscreteParamsPerInstance>
+        {
+            instance.get(ModuleParam::LadderFilterMode),
+            instance.get(ModuleParam::GeneralFilterMode),
+            instance.get(ModuleParam::PhaserBypass),
+            instance.get(ModuleParam::ChorusBypass),
+            instance.get(ModuleParam::OverdriveBypass),
+            instance.get(ModuleParam::LadderFilterBypass),
+            instance.get(ModuleParam::GeneralFilterBypass),
+            instance.get(ModuleParam::DelaySync),
+            instance.get(ModuleParam::DelayNote),
+            instance.get(ModuleParam::DelayPingPong),
+            instance.get(ModuleParam::DelayBypass),
+            instance.get(ModuleParam::ConvolutionBypass),
+        };
+
+        out = std::copy(instanceParams.begin(), instanceParams.end(), out);
+    }
+
+    return params;
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::updateDiscreteValues()
+{
+    auto params = getDiscreteParams();
+
+    // The parameters may be half old and half new until they've caught up with a restore
+    if (holdingRestoredState)
+    {
+        for (size_t i = 0; i < params.size(); ++i)
+            discreteValues[i] = params[i]->convertFrom0to1(restoredState.values[static_cast<size_t>(params[i]->getParameterIndex())]);
+        return;
+    }
+
+    // morphDiscreteTargets is refreshed by updateSmoothersFromParams() whenever the engine drives the smoothers
+    if (morphEngineDrivingParams)
+    {
+        discreteValues = morphDiscreteTargets;
+        return;
+    }
+
+    for (size_t i = 0; i < params.size(); ++i)
+        discreteValues[i] = params[i]->convertFrom0to1(params[i]->getValue());
+}
+
+bool JUCE_MultiFX_ProcessorAudioProcessor::isOptionBypassed(DSP_Option option, int instance) const
+{
+    switch (option)
+    {
+    case DSP_Option::Phase:
+        return getDiscreteIndex(DiscreteParam::PhaserBypass, instance) != 0;
+    case DSP_Option::Chorus:
+        return getDiscreteIndex(DiscreteParam::ChorusBypass, instance) != 0;
+    case DSP_Option::Overdrive:
+        return getDiscreteIndex(DiscreteParam::OverdriveBypass, instance) != 0;
+    case DSP_Option::LadderFilter:
+        return getDiscreteIndex(DiscreteParam::LadderFilterBypass, instance) != 0;
+    case DSP_Option::GeneralFilter:
+        return getDiscreteIndex(DiscreteParam::GeneralFilterBypass, instance) != 0;
+    case DSP_Option::Delay:
+        return getDiscreteIndex(DiscreteParam::DelayBypass, instance) != 0;
+    case DSP_Option::Convolution:
+        return getDiscreteIndex(DiscreteParam::ConvolutionBypass, instance) != 0;
+    case DSP_Option::END_OF_LIST:
+        break;
+    }
+    jassertfalse;
+    return false;
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::MonoChannelDSP::prepare(const juce::dsp::ProcessSpec& spec)
+{
+	jassert(spec.numChannels == 1); // This DSP is designed for mono channels only
+
+    // The pool never changes size, so slots can point into it from the audio thread
+    if (modulePool == nullptr)
+        modulePool = std::make_unique<ModuleSet[]>(static_cast<size_t>(NumModuleInstances));
+
+    for (int instance = 0; instance < NumModuleInstances; ++instance)
+    {
+        auto& modules = getModules(instance);
+
+        modules.linearPhase = p.linearPhaseEngaged[static_cast<size_t>(instance)];
+        modules.linearPhaseFilter.dsp.setKernels(modules.linearPhase ? &p.linearPhaseKernels[static_cast<size_t>(instance)] : nullptr);
+        setConvolution(instance, p.activeConvolutions[static_cast<size_t>(instance)]);
+        updateDelayRing(instance);
+
+        std::vector<juce::dsp::ProcessorBase*> dsp
+        {
+            &modules.phaser,
+            &modules.chorus,
+            &modules.overdrive,
+            &modules.ladderFilter,
+            &modules.generalFilter,
+            &modules.linearPhaseFilter,
+            &modules.delay,
+            &modules.convolution
+        };
+
+        for (auto module : dsp)
+        {
+            module->prepare(spec);
+            module->reset();
+        }
+
+        modules.overdrive.dsp.setCutoffFrequencyHz(20000.f);
+
+        for (size_t i = 0; i < modules.wasBypassed.size(); ++i)
+            modules.wasBypassed[i] = p.isOptionBypassed(static_cast<DSP_Option>(i), instance);
+
+        modules.silentSamples.fill(0);
+        modules.asleep.fill(false);
+    }
+
+    crossfadeBuffer.setSize(1, static_cast<int>(spec.maximumBlockSize));
+
+    for (auto& pad : linearPhasePads)
+        pad.prepare(1, static_cast<int>(spec.maximumBlockSize), 0, getChainLatencySamples(p.numLinearPhaseEngaged));
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::MonoChannelDSP::reset()
+{
+    if (modulePool == nullptr)
+        return;
+
+    for (int instance = 0; instance < NumModuleInstances; ++instance)
+    {
+        auto& modules = getModules(instance);
+        for (size_t i = 0; i < NumOptions; ++i)
+            resetModule(modules, static_cast<DSP_Option>(i));
+
+        modules.silentSamples.fill(0);
+        modules.asleep.fill(false);
+    }
+
+    for (auto& pad : linearPhasePads)
+        pad.reset();
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::MonoChannelDSP::resetModules(const DSP_Order& order)
+{
+    if (modulePool == nullptr)
+        return;
+
+    for (const auto& slot : order)
+    {
+        auto& modules = getModules(slot.instance);
+        const auto index = static_cast<size_t>(slot.option);
+
+        resetModule(modules, slot.option);
+        modules.silentSamples[index] = 0;
+        modules.asleep[index] = false;
+    }
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::releaseResources()
+{
+    // When playback stops, you can use this as an opportunity to free up any
+    // spare memory, etc.
+}
+
+#ifndef JucePlugin_PreferredChannelConfigurations
+bool JUCE_MultiFX_ProcessorAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+{
+  #if JucePlugin_IsMidiEffect
+    juce::ignoreUnused (layouts);
+    return true;
+  #else
+    // This is the place where you check if the layout is supported.
+    // In this template code we only support mono or stereo.
+    // Some plugin hosts, such as certain GarageBand versions, will only
+    // load plugins that support stereo bus layouts.
+    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
+     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+        return false;
+
+    // This checks if the input layout matches the output layout
+   #if ! JucePlugin_IsSynth
+    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+        return false;
+
+    // The sidechain is optional, and only ever mono or stereo
+    if (layouts.inputBuses.size() > 1)
+    {
+        auto sidechain = layouts.getChannelSet(true, 1);
+        if (sidechain.isDisabled() == false
+         && sidechain != juce::AudioChannelSet::mono()
+         && sidechain != juce::AudioChannelSet::stereo())
+            return false;
+    }
+   #endif
+
+    return true;
+  #endif
+}
+#endif
+
+void JUCE_MultiFX_ProcessorAudioProcessor::ModuleParameters::addToLayout(juce::AudioProcessorValueTreeState::ParameterLayout& layout,
+                                                                       int instance,
+                                                                       int versionHint)
+{
+    auto id = [&](ModuleParam param) { return juce::ParameterID{ getModuleParamID(param, instance), versionHint }; };
+    auto name = [&](ModuleParam param) { return getModuleParamName(param, instance); };
+
+    /*
+    Phaser:
     Rate: hz
-    Depth: 0 to 1
-	Center delay: ms (1 to 100)
+    Depth: 0 to 100
+    Center freq: hz
     Feedback: -1 to 1
     Mix: 0 to 1
     */
 
-    name = getChorusRateName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{ name, versionHint },
-        name,
-        juce::NormalisableRange<float>(0.01f, 15.f, 0.01f, 1.f),
-        0.9f,
+        id(ModuleParam::PhaserRate),
+        name(ModuleParam::PhaserRate),
+        juce::NormalisableRange<float>(0.01f, 2.f, 0.01f, 1.f),
+        0.2f,
         "Hz"
-    ));
+	));
 
-	name = getChorusDepthName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{ name, versionHint },
-        name,
-        juce::NormalisableRange<float>(0.f, 100.f, 0.1f, 1.f),
+        id(ModuleParam::PhaserDepth),
+        name(ModuleParam::PhaserDepth),
+        juce::NormalisableRange<float>(0.0f, 100.f, 0.1f, 1.f),
         5.f,
         "%"
-    ));
+	));
 
-    name = getChorusCenterDelayName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{ name, versionHint },
-        name,
-        juce::NormalisableRange<float>(0.01f, 20.f, 0.01f, 1.f),
-        3.f,
-        "Ms"
+        id(ModuleParam::PhaserCenterFreq),
+        name(ModuleParam::PhaserCenterFreq),
+        juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 1.f),
+        1000.f,
+        "Hz"
     ));
-
-    name = getChorusFeedbackName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{ name, versionHint },
-        name,
+        id(ModuleParam::PhaserFeedback),
+        name(ModuleParam::PhaserFeedback),
         juce::NormalisableRange<float>(-100.f, 100.f, 0.1f, 1.f),
         0.0f,
         "%"
     ));
-
-    name = getChorusMixName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{ name, versionHint },
-        name,
-        juce::NormalisableRange<float>(0.0f, 100.f, 0.1f, 5.f),
+        id(ModuleParam::PhaserMix),
+        name(ModuleParam::PhaserMix),
+        juce::NormalisableRange<float>(0.f, 100.f, 0.1f, 1.f),
         50.f,
         "%"
-    ));
+	));
 
-	name = getChorusBypassName();
     layout.add(std::make_unique<juce::AudioParameterBool>(
-        juce::ParameterID{ name, versionHint },
-        name,
+        id(ModuleParam::PhaserBypass),
+        name(ModuleParam::PhaserBypass),
+        false
+    ));
+
+    /*
+    Chorus:
+    Rate: hz
+    Depth: 0 to 1
+	Center delay: ms (1 to 100)
+    Feedback: -1 to 1
+    Mix: 0 to 1
+    */
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        id(ModuleParam::ChorusRate),
+        name(ModuleParam::ChorusRate),
+        juce::NormalisableRange<float>(0.01f, 15.f, 0.01f, 1.f),
+        0.9f,
+        "Hz"
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        id(ModuleParam::ChorusDepth),
+        name(ModuleParam::ChorusDepth),
+        juce::NormalisableRange<float>(0.f, 100.f, 0.1f, 1.f),
+        5.f,
+        "%"
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        id(ModuleParam::ChorusCenterDelay),
+        name(ModuleParam::ChorusCenterDelay),
+        juce::NormalisableRange<float>(0.01f, 20.f, 0.01f, 1.f),
+        3.f,
+        "Ms"
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        id(ModuleParam::ChorusFeedback),
+        name(ModuleParam::ChorusFeedback),
+        juce::NormalisableRange<float>(-100.f, 100.f, 0.1f, 1.f),
+        0.0f,
+        "%"
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        id(ModuleParam::ChorusMix),
+        name(ModuleParam::ChorusMix),
+        juce::NormalisableRange<float>(0.0f, 100.f, 0.1f, 5.f),
+        50.f,
+        "%"
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        id(ModuleParam::ChorusBypass),
+        name(ModuleParam::ChorusBypass),
         false
 	));
 
@@ -539,19 +1264,17 @@ juce::AudioProcessorValueTreeState::ParameterLayout JUCE_MultiFX_ProcessorAudioP
     Drive: 1 to 100
     */
 
-    name = getOverdriveSaturationName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{ name, versionHint },
-        name,
+        id(ModuleParam::OverdriveSaturation),
+        name(ModuleParam::OverdriveSaturation),
         juce::NormalisableRange<float>(1.f, 100.f, 0.1f, 1.f),
         1.f,
         ""
 	));
 
-	name = getOverdriveBypassName();
     layout.add(std::make_unique<juce::AudioParameterBool>(
-        juce::ParameterID{ name, versionHint },
-        name,
+        id(ModuleParam::OverdriveBypass),
+        name(ModuleParam::OverdriveBypass),
 		false
 	));
 
@@ -563,46 +1286,41 @@ juce::AudioProcessorValueTreeState::ParameterLayout JUCE_MultiFX_ProcessorAudioP
 	Drive: 1 to 100
     */
 
-	name = getLadderFilterModeName();
 	auto choices = getLadderFilterChoices();
     layout.add(std::make_unique<juce::AudioParameterChoice>(
-        juce::ParameterID{ name, versionHint },
-        name,
+        id(ModuleParam::LadderFilterMode),
+        name(ModuleParam::LadderFilterMode),
         choices,
         0 // Default to LPF12
 	));
 
-	name = getLadderFilterCutoffName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{ name, versionHint },
-        name,
+        id(ModuleParam::LadderFilterCutoff),
+        name(ModuleParam::LadderFilterCutoff),
         juce::NormalisableRange<float>(20.f, 20000.f, 0.1f, .4f),
         20000.f,
         "Hz"
     ));
 
-	name = getLadderFilterResonanceName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{ name, versionHint },
-        name,
+        id(ModuleParam::LadderFilterResonance),
+        name(ModuleParam::LadderFilterResonance),
         juce::NormalisableRange<float>(0.f, 100.f, 0.1f, 1.f),
         0.0f,
         "%"
     ));
 
-	name = getLadderFilterDriveName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{ name, versionHint },
-        name,
+        id(ModuleParam::LadderFilterDrive),
+        name(ModuleParam::LadderFilterDrive),
         juce::NormalisableRange<float>(1.f, 100.f, 0.1f, 1.f),
         1.f,
         ""
     ));
 
-	name = getLadderFilterBypassName();
     layout.add(std::make_unique<juce::AudioParameterBool>(
-        juce::ParameterID{ name, versionHint },
-        name,
+        id(ModuleParam::LadderFilterBypass),
+        name(ModuleParam::LadderFilterBypass),
 		false
 	));
           
@@ -614,448 +1332,1804 @@ juce::AudioProcessorValueTreeState::ParameterLayout JUCE_MultiFX_ProcessorAudioP
 	Q: 0.1 to 10 (0.05 steps)
 	Gain: -24db to +24db (0.5db steps)
     */
-	name = getGeneralFilterModeName();
 	choices = getGeneralFilterChoices();
     layout.add(std::make_unique<juce::AudioParameterChoice>(
-        juce::ParameterID{ name, versionHint },
-        name,
+        id(ModuleParam::GeneralFilterMode),
+        name(ModuleParam::GeneralFilterMode),
         choices,
         0 // Default to Peak
 	));
 
-    name = getGeneralFilterFreqName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{ name, versionHint },
-        name,
+        id(ModuleParam::GeneralFilterFreq),
+        name(ModuleParam::GeneralFilterFreq),
         juce::NormalisableRange<float>(20.f, 20000.f, 1.f, .4f),
         750.f,
         "Hz"
 	));
 
-    name = getGeneralFilterQualityName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{ name, versionHint },
-        name,
+        id(ModuleParam::GeneralFilterQuality),
+        name(ModuleParam::GeneralFilterQuality),
         juce::NormalisableRange<float>(0.01f, 100.f, 0.01f, 1.f),
         0.72f,
         ""
     ));
 
-    name = getGeneralFilterGainName();
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        juce::ParameterID{ name, versionHint },
-        name,
-        juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f),
-        0.0f,
-        "dB"
-	));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        id(ModuleParam::GeneralFilterGain),
+        name(ModuleParam::GeneralFilterGain),
+        juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f),
+        0.0f,
+        "dB"
+	));
+
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        id(ModuleParam::GeneralFilterBypass),
+        name(ModuleParam::GeneralFilterBypass),
+        false
+	));
+
+    /*
+    General Filter bands 2 to 8:
+    Bands: how many of the bands are used, the first is the one above
+    Mode, Frequency, Q and Gain: as for the first band, but not smoothed or
+    modulated, their coefficients are designed on the message thread
+    */
+    juce::StringArray bandCounts;
+    for (int count = 1; count <= ParametricEq::MaxBands; ++count)
+        bandCounts.add(juce::String(count));
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        id(ModuleParam::GeneralFilterBands),
+        name(ModuleParam::GeneralFilterBands),
+        bandCounts,
+        0 // Default to the first band only
+    ));
+
+    // Spread over the spectrum, so a band that is switched on doesn't land on top of another
+    constexpr std::array<float, ParametricEq::MaxBands> bandFrequencies { 750.f, 100.f, 250.f, 500.f, 1500.f, 3000.f, 6000.f, 12000.f };
+
+    for (int band = 1; band < ParametricEq::MaxBands; ++band)
+    {
+        layout.add(std::make_unique<juce::AudioParameterChoice>(
+            id(getEqBandParam(band, EqBandField::Mode)),
+            name(getEqBandParam(band, EqBandField::Mode)),
+            choices,
+            0 // Default to Peak
+        ));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            id(getEqBandParam(band, EqBandField::Frequency)),
+            name(getEqBandParam(band, EqBandField::Frequency)),
+            juce::NormalisableRange<float>(20.f, 20000.f, 1.f, .4f),
+            bandFrequencies[static_cast<size_t>(band)],
+            "Hz"
+        ));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            id(getEqBandParam(band, EqBandField::Quality)),
+            name(getEqBandParam(band, EqBandField::Quality)),
+            juce::NormalisableRange<float>(0.01f, 100.f, 0.01f, 1.f),
+            0.72f,
+            ""
+        ));
+
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            id(getEqBandParam(band, EqBandField::Gain)),
+            name(getEqBandParam(band, EqBandField::Gain)),
+            juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f),
+            0.0f,
+            "dB"
+        ));
+    }
+
+    /*
+    Linear Phase: every band's magnitude without its phase shift, at the cost of
+    about 50 ms of latency. Switching takes effect when the host next prepares.
+    */
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        id(ModuleParam::GeneralFilterLinearPhase),
+        name(ModuleParam::GeneralFilterLinearPhase),
+        false
+    ));
+
+    /*
+    Delay:
+    Time: ms (used when not synced)
+    Sync: follows the host tempo, the length comes from Note
+    Feedback: 0 to 95 %
+    Low/High cut: filters in the feedback path
+    Ping pong: feedback crosses between left and right
+    Mix: 0 to 100 %
+    */
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        id(ModuleParam::DelayTime),
+        name(ModuleParam::DelayTime),
+        juce::NormalisableRange<float>(1.f, 2000.f, 0.1f, .4f),
+        350.f,
+        "ms"
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        id(ModuleParam::DelaySync),
+        name(ModuleParam::DelaySync),
+        false
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        id(ModuleParam::DelayNote),
+        name(ModuleParam::DelayNote),
+        getDelayNoteChoices(),
+        4 // Default to 1/4
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        id(ModuleParam::DelayFeedback),
+        name(ModuleParam::DelayFeedback),
+        juce::NormalisableRange<float>(0.f, 95.f, 0.1f, 1.f),
+        35.f,
+        "%"
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        id(ModuleParam::DelayLowCut),
+        name(ModuleParam::DelayLowCut),
+        juce::NormalisableRange<float>(20.f, 2000.f, 1.f, .4f),
+        80.f,
+        "Hz"
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        id(ModuleParam::DelayHighCut),
+        name(ModuleParam::DelayHighCut),
+        juce::NormalisableRange<float>(1000.f, 20000.f, 1.f, .4f),
+        8000.f,
+        "Hz"
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        id(ModuleParam::DelayPingPong),
+        name(ModuleParam::DelayPingPong),
+        false
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        id(ModuleParam::DelayMix),
+        name(ModuleParam::DelayMix),
+        juce::NormalisableRange<float>(0.f, 100.f, 0.1f, 1.f),
+        35.f,
+        "%"
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        id(ModuleParam::DelayBypass),
+        name(ModuleParam::DelayBypass),
+        false
+    ));
+
+    /*
+    Convolution:
+    Mix: 0 to 100 %
+    Gain: applied to the convolved signal, the response is normalised when loaded
+    */
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        id(ModuleParam::ConvolutionMix),
+        name(ModuleParam::ConvolutionMix),
+        juce::NormalisableRange<float>(0.f, 100.f, 0.1f, 1.f),
+        100.f,
+        "%"
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        id(ModuleParam::ConvolutionGain),
+        name(ModuleParam::ConvolutionGain),
+        juce::NormalisableRange<float>(-24.f, 24.f, 0.1f, 1.f),
+        0.f,
+        "dB"
+    ));
+
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        id(ModuleParam::ConvolutionBypass),
+        name(ModuleParam::ConvolutionBypass),
+        false
+    ));
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout JUCE_MultiFX_ProcessorAudioProcessor::createParameterlayout() {
+
+	juce::AudioProcessorValueTreeState::ParameterLayout layout;
+
+    const int versionHint = 1;
+    
+    auto name = getInputGainName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{name, versionHint},
+        name,
+        juce::NormalisableRange<float>(-18.f, 18.f, 0.1f, 1.f),
+        0.f,
+        "dB"
+	));
+
+	name = getOutputGainName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{name, versionHint},
+        name,
+        juce::NormalisableRange<float>(-18.f, 18.f, 0.1f, 1.f),
+        0.f,
+        "dB"
+    ));
+
+    name = getMixName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{name, versionHint},
+        name,
+        juce::NormalisableRange<float>(0.f, 100.f, 0.1f, 1.f),
+        100.f,
+        "%"
+    ));
+
+    ModuleParameters::addToLayout(layout, 0, versionHint);
+
+    ModulationMatrix::addParameters(layout, getModulationTargetNames(), versionHint);
+
+    name = getSnapshotMorphTimeName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name, versionHint },
+        name,
+        juce::NormalisableRange<float>(0.f, 2000.f, 1.f, .5f),
+        50.f,
+        "ms"
+    ));
+
+    name = getSnapshotMorphName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name, versionHint },
+        name,
+        juce::NormalisableRange<float>(0.f, 1.f, 0.001f, 1.f),
+        0.f,
+        ""
+    ));
+
+    name = getSnapshotMorphEnabledName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        juce::ParameterID{ name, versionHint },
+        name,
+        false
+    ));
+
+	name = getSelectedTabName();
+    layout.add(std::make_unique<juce::AudioParameterInt>(
+        juce::ParameterID{ name, versionHint },
+        name,
+        0, 
+        static_cast<int>(MaxChainLength) - 1,
+		static_cast<int>(DSP_Option::Chorus)
+    ));
+
+    // Appended so the parameter indices of the first instance stay where they were
+    for (int instance = 1; instance < NumModuleInstances; ++instance)
+        ModuleParameters::addToLayout(layout, instance, versionHint);
+
+    // Changing it restarts processing with a new latency, so hosts shouldn't automate it
+    name = getInternalRateName();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ name, versionHint },
+        name,
+        juce::StringArray{ "Host", "44.1 kHz", "48 kHz", "88.2 kHz", "96 kHz" },
+        0,
+        juce::AudioParameterChoiceAttributes().withAutomatable(false)
+    ));
+
+    name = getStereoModeName();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ name, versionHint },
+        name,
+        juce::StringArray{ "L/R", "Mid/Side", "Mid Only", "Side Only" },
+        0
+    ));
+
+    name = getBandCountName();
+    layout.add(std::make_unique<juce::AudioParameterInt>(
+        juce::ParameterID{ name, versionHint },
+        name,
+        1,
+        LinkwitzRileyCrossover::MaxBands,
+        1
+    ));
+
+    const auto defaultCrossovers = std::array { 200.f, 1000.f, 5000.f };
+    static_assert(defaultCrossovers.size() == LinkwitzRileyCrossover::MaxSplits);
+
+    for (int i = 0; i < LinkwitzRileyCrossover::MaxSplits; ++i)
+    {
+        name = getCrossoverFrequencyName(i);
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID{ name, versionHint },
+            name,
+            juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 0.25f),
+            defaultCrossovers[static_cast<size_t>(i)],
+            "Hz"
+        ));
+    }
+
+    for (int band = 0; band < LinkwitzRileyCrossover::MaxBands; ++band)
+    {
+        name = getBandBypassName(band);
+        layout.add(std::make_unique<juce::AudioParameterBool>(
+            juce::ParameterID{ name, versionHint },
+            name,
+            false
+        ));
+    }
+
+    // Changing it restarts processing with a new latency, like the internal rate
+    name = getLimiterName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(
+        juce::ParameterID{ name, versionHint },
+        name,
+        false,
+        juce::AudioParameterBoolAttributes().withAutomatable(false)
+    ));
+
+    name = getLimiterCeilingName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name, versionHint },
+        name,
+        juce::NormalisableRange<float>(-12.f, 0.f, 0.1f, 1.f),
+        -1.f,
+        "dBTP"
+    ));
+
+    name = getLimiterReleaseName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name, versionHint },
+        name,
+        juce::NormalisableRange<float>(1.f, 1000.f, 0.1f, .4f),
+        100.f,
+        "ms"
+    ));
+
+	return layout;
+}
+
+// Trips around a feedback loop before it has decayed by 60 dB
+static double getFeedbackRepeats(float feedback)
+{
+    auto gain = juce::jlimit(0.0, 0.999, std::abs(static_cast<double>(feedback)));
+    if (gain < 0.001)
+        return 0.0;
+
+    return std::log(0.001) / std::log(gain);
+}
+
+// 60 dB decay time of a resonance
+static double getResonanceDecaySeconds(double frequencyHz, double q)
+{
+    return std::log(1000.0) * q / (juce::MathConstants<double>::pi * juce::jmax(1.0, frequencyHz));
+}
+
+static_assert(JUCE_MultiFX_ProcessorAudioProcessor::getEqBandParam(ParametricEq::MaxBands - 1, JUCE_MultiFX_ProcessorAudioProcessor::EqBandField::Gain)
+              == JUCE_MultiFX_ProcessorAudioProcessor::ModuleParam::GeneralFilterBand8Gain,
+              "The registry needs four rows for every band after the first");
+
+juce::StringArray JUCE_MultiFX_ProcessorAudioProcessor::getEqBandParamIDs()
+{
+    juce::StringArray paramIDs;
+    for (int instance = 0; instance < NumModuleInstances; ++instance)
+    {
+        // The first band only for the linear phase kernel, the minimum phase filter designs it itself
+        for (auto param : { ModuleParam::GeneralFilterMode, ModuleParam::GeneralFilterFreq, ModuleParam::GeneralFilterQuality, ModuleParam::GeneralFilterGain })
+            paramIDs.add(getModuleParamID(param, instance));
+
+        paramIDs.add(getModuleParamID(ModuleParam::GeneralFilterBands, instance));
+
+        for (int band = 1; band < ParametricEq::MaxBands; ++band)
+        {
+            for (int field = 0; field < static_cast<int>(EqBandField::END_OF_LIST); ++field)
+                paramIDs.add(getModuleParamID(getEqBandParam(band, static_cast<EqBandField>(field)), instance));
+        }
+    }
+
+    return paramIDs;
+}
+
+JUCE_MultiFX_ProcessorAudioProcessor::EqBandSet JUCE_MultiFX_ProcessorAudioProcessor::designEqBands(double sampleRate) const
+{
+    EqBandSet set;
+    set.sampleRate = sampleRate;
+
+    for (size_t instance = 0; instance < moduleParams.size(); ++instance)
+    {
+        const auto& params = moduleParams[instance];
+        auto getIndex = [&params](ModuleParam param) { return static_cast<juce::AudioParameterChoice*>(params.get(param))->getIndex(); };
+        auto getValue = [&params](ModuleParam param) { return static_cast<juce::AudioParameterFloat*>(params.get(param))->get(); };
+
+        set.numBands[instance] = getIndex(ModuleParam::GeneralFilterBands) + 1;
+
+        // Unsmoothed and unmodulated, as the linear phase kernel follows it
+        ParametricEq::Band first;
+        first.mode = static_cast<GeneralFilterMode>(getIndex(ModuleParam::GeneralFilterMode));
+        first.frequency = getValue(ModuleParam::GeneralFilterFreq);
+        first.quality = getValue(ModuleParam::GeneralFilterQuality);
+        first.gainDecibels = getValue(ModuleParam::GeneralFilterGain);
+        set.coefficients[instance][0] = ParametricEq::design(first, sampleRate);
+
+        for (int band = 1; band < set.numBands[instance]; ++band)
+        {
+            ParametricEq::Band settings;
+            settings.mode = static_cast<GeneralFilterMode>(getIndex(getEqBandParam(band, EqBandField::Mode)));
+            settings.frequency = getValue(getEqBandParam(band, EqBandField::Frequency));
+            settings.quality = getValue(getEqBandParam(band, EqBandField::Quality));
+            settings.gainDecibels = getValue(getEqBandParam(band, EqBandField::Gain));
+
+            set.coefficients[instance][static_cast<size_t>(band)] = ParametricEq::design(settings, sampleRate);
+            set.tailSeconds[instance] = juce::jmax(set.tailSeconds[instance], getResonanceDecaySeconds(settings.frequency, settings.quality));
+        }
+    }
+
+    return set;
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::MonoChannelDSP::updateDSPFromParams(const DSP_Order& dspOrder)
+{
+    /*
+    An instance that joins the chain is updated before its first sub-block runs, and
+    glides from the settings it had when it left, the same as after a parameter change.
+    */
+    std::array<bool, NumModuleInstances> inChain {};
+    for (const auto& slot : dspOrder)
+    {
+        if (juce::isPositiveAndBelow(slot.instance, NumModuleInstances))
+            inChain[static_cast<size_t>(slot.instance)] = true;
+    }
+
+    for (int instance = 0; instance < NumModuleInstances; ++instance)
+    {
+        if (inChain[static_cast<size_t>(instance)])
+            updateModules(getModules(instance), p.moduleParams[static_cast<size_t>(instance)], instance);
+    }
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::MonoChannelDSP::updateModules(ModuleSet& modules, const ModuleParameters& params, int instance)
+{
+    modules.phaser.dsp.setRate(params.getSmoothedValue(ModuleParam::PhaserRate));
+    modules.phaser.dsp.setDepth(params.getSmoothedValue(ModuleParam::PhaserDepth) * 0.01f );
+    modules.phaser.dsp.setCentreFrequency(params.getSmoothedValue(ModuleParam::PhaserCenterFreq));
+    modules.phaser.dsp.setFeedback(params.getSmoothedValue(ModuleParam::PhaserFeedback) * 0.01f);
+    modules.phaser.dsp.setMix(params.getSmoothedValue(ModuleParam::PhaserMix) * 0.01f);
+
+    modules.chorus.dsp.setRate(params.getSmoothedValue(ModuleParam::ChorusRate));
+    modules.chorus.dsp.setDepth(params.getSmoothedValue(ModuleParam::ChorusDepth) * 0.01f);
+    modules.chorus.dsp.setCentreDelay(params.getSmoothedValue(ModuleParam::ChorusCenterDelay));
+    modules.chorus.dsp.setFeedback(params.getSmoothedValue(ModuleParam::ChorusFeedback) * 0.01f);
+    modules.chorus.dsp.setMix(params.getSmoothedValue(ModuleParam::ChorusMix) * 0.01f);
+
+    modules.overdrive.dsp.setDrive(params.getSmoothedValue(ModuleParam::OverdriveSaturation));
+
+    modules.ladderFilter.dsp.setMode(static_cast<juce::dsp::LadderFilter<float>::Mode>(p.getDiscreteIndex(DiscreteParam::LadderFilterMode, instance)));
+    modules.ladderFilter.dsp.setCutoffFrequencyHz(params.getSmoothedValue(ModuleParam::LadderFilterCutoff));
+    modules.ladderFilter.dsp.setResonance(params.getSmoothedValue(ModuleParam::LadderFilterResonance) * 0.01f);
+    modules.ladderFilter.dsp.setDrive(params.getSmoothedValue(ModuleParam::LadderFilterDrive));
+
+    auto sampleRate = p.processingSampleRate;
+
+	// The first band follows its smoothed parameters, designing it here doesn't allocate
+	auto genMode = p.getDiscreteIndex(DiscreteParam::GeneralFilterMode, instance);
+	auto genHz = params.getSmoothedValue(ModuleParam::GeneralFilterFreq);
+	auto genQ = params.getSmoothedValue(ModuleParam::GeneralFilterQuality);
+    auto genGain = params.getSmoothedValue(ModuleParam::GeneralFilterGain);
+
+	bool filterChanged = false;
+
+    filterChanged |= (modules.filterFreq != genHz);
+    filterChanged |= (modules.filterQ != genQ);
+    filterChanged |= (modules.filterGain != genGain);
+
+	auto updatedMode = static_cast<GeneralFilterMode>(genMode);
+    filterChanged |= (modules.filterMode != updatedMode);
+
+    if (filterChanged)
+    {
+        modules.filterMode = updatedMode;
+        modules.filterFreq = genHz;
+        modules.filterQ = genQ;
+        modules.filterGain = genGain;
+
+        ParametricEq::Band band;
+        band.mode = modules.filterMode;
+        band.frequency = modules.filterFreq;
+        band.quality = modules.filterQ;
+        band.gainDecibels = modules.filterGain;
+
+        // The state carries over, the transposed form copes with coefficients moving under it
+        modules.generalFilter.dsp.setCoefficients(0, ParametricEq::design(band, sampleRate));
+    }
+
+    // The other bands arrive designed, only the new set needs copying in
+    if (modules.filterBandsVersion != p.eqBandsVersion)
+    {
+        modules.filterBandsVersion = p.eqBandsVersion;
+
+        const auto& coefficients = p.eqBands.coefficients[static_cast<size_t>(instance)];
+        for (int band = 1; band < ParametricEq::MaxBands; ++band)
+            modules.generalFilter.dsp.setCoefficients(band, coefficients[static_cast<size_t>(band)]);
+
+        modules.generalFilter.dsp.setNumBands(p.eqBands.numBands[static_cast<size_t>(instance)]);
+    }
+
+    auto delayMs = params.getSmoothedValue(ModuleParam::DelayTime);
+    if (p.getDiscreteIndex(DiscreteParam::DelaySync, instance) != 0)
+    {
+        const auto& notes = getDelayNotes();
+        auto note = juce::jlimit(0, static_cast<int>(notes.size()) - 1, p.getDiscreteIndex(DiscreteParam::DelayNote, instance));
+        delayMs = static_cast<float>(notes[static_cast<size_t>(note)].second * 60000.0 / p.hostBpm);
+    }
+
+    modules.delay.dsp.setDelayMs(delayMs);
+    modules.delay.dsp.setFeedback(params.getSmoothedValue(ModuleParam::DelayFeedback) * 0.01f);
+    modules.delay.dsp.setMix(params.getSmoothedValue(ModuleParam::DelayMix) * 0.01f);
+    modules.delay.dsp.setLowCutHz(params.getSmoothedValue(ModuleParam::DelayLowCut));
+    modules.delay.dsp.setHighCutHz(params.getSmoothedValue(ModuleParam::DelayHighCut));
+
+    auto pingPong = partner != nullptr && p.getDiscreteIndex(DiscreteParam::DelayPingPong, instance) != 0;
+    modules.delay.dsp.setPingPongPartner(pingPong ? &partner->getModules(instance).delay.dsp : nullptr, SubBlockSize);
+
+    modules.convolution.dsp.setMix(params.getSmoothedValue(ModuleParam::ConvolutionMix) * 0.01f);
+    modules.convolution.dsp.setGainDecibels(params.getSmoothedValue(ModuleParam::ConvolutionGain));
+
+    // Offline renders don't wait on the worker, the tail is worked out in line
+    modules.convolution.dsp.setNonRealtime(p.isNonRealtime());
+
+    auto setTail = [&](DSP_Option option, double seconds)
+        {
+            modules.tailSamples[static_cast<size_t>(option)] = static_cast<int>(std::ceil((seconds + MinTailSeconds) * sampleRate));
+        };
+
+    // The phaser's six allpass stages delay the feedback by roughly 1 / (pi * centre) each
+    setTail(DSP_Option::Phase, getFeedbackRepeats(params.getSmoothedValue(ModuleParam::PhaserFeedback) * 0.01f)
+                               * 6.0 / (juce::MathConstants<double>::pi * params.getSmoothedValue(ModuleParam::PhaserCenterFreq)));
+
+    // JUCE's chorus sweeps up to 20 ms either side of the centre delay
+    auto chorusSeconds = (params.getSmoothedValue(ModuleParam::ChorusCenterDelay) + params.getSmoothedValue(ModuleParam::ChorusDepth) * 0.2f) * 0.001;
+    setTail(DSP_Option::Chorus, chorusSeconds * (1.0 + getFeedbackRepeats(params.getSmoothedValue(ModuleParam::ChorusFeedback) * 0.01f)));
+
+    setTail(DSP_Option::Overdrive, 0.0);
+
+    // Q of the ladder rises towards self oscillation as the resonance approaches 100%
+    auto ladderQ = 0.5 / (1.0 - 0.99 * params.getSmoothedValue(ModuleParam::LadderFilterResonance) * 0.01);
+    setTail(DSP_Option::LadderFilter, getResonanceDecaySeconds(params.getSmoothedValue(ModuleParam::LadderFilterCutoff), ladderQ));
+
+    if (modules.linearPhase)
+        setTail(DSP_Option::GeneralFilter, (LinearPhaseKernel::NumTaps + LinearPhaseKernel::PartitionSize) / sampleRate);
+    else
+        setTail(DSP_Option::GeneralFilter, juce::jmax(getResonanceDecaySeconds(modules.filterFreq, modules.filterQ),
+                                                      p.eqBands.tailSeconds[static_cast<size_t>(instance)]));
+
+    setTail(DSP_Option::Delay, delayMs * 0.001 * (1.0 + getFeedbackRepeats(params.getSmoothedValue(ModuleParam::DelayFeedback) * 0.01f)));
+    setTail(DSP_Option::Convolution, modules.convolution.dsp.getLengthSeconds());
+}
+
+const std::vector< juce::RangedAudioParameter*>& JUCE_MultiFX_ProcessorAudioProcessor::getParamsForOption(DSP_Option option, int instance) const
+{
+    if (juce::isPositiveAndBelow(instance, NumModuleInstances) == false)
+    {
+        jassertfalse;
+        static const std::vector<juce::RangedAudioParameter*> none;
+        return none;
+    }
+
+    return moduleParams[static_cast<size_t>(instance)].getParamsForOption(option);
+}
+
+juce::AudioParameterBool* JUCE_MultiFX_ProcessorAudioProcessor::getBypassParam(DSP_Option option, int instance) const
+{
+    if (juce::isPositiveAndBelow(instance, NumModuleInstances) == false)
+    {
+        jassertfalse;
+        return nullptr;
+    }
+
+    return moduleParams[static_cast<size_t>(instance)].getBypass(option);
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::processBlock (juce::AudioBuffer<float>& hostBuffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    const auto numSamples = hostBuffer.getNumSamples();
+
+    // Whichever thread the host calls from now, its parameter changes are timed from here on
+    audioThreadId.store(juce::Thread::getCurrentThreadId(), std::memory_order_relaxed);
+
+    if (numSamples <= maximumHostBlockSize || maximumHostBlockSize <= 0)
+    {
+        processHostBlock(hostBuffer, true);
+    }
+    else
+    {
+        // Some hosts send more than they promised. The pieces refer to the host's channels, nothing is allocated
+        numOversizeBlocks.set(numOversizeBlocks.get() + 1);
+        trace.record(AudioTrace::Type::OversizeBlock, static_cast<float>(numSamples));
+
+        for (int start = 0; start < numSamples; start += maximumHostBlockSize)
+        {
+            const auto pieceSize = juce::jmin(maximumHostBlockSize, numSamples - start);
+            juce::AudioBuffer<float> piece(hostBuffer.getArrayOfWritePointers(), hostBuffer.getNumChannels(), start, pieceSize);
+            processHostBlock(piece, start + pieceSize == numSamples);
+        }
+    }
+
+    recordCallbackTime(startTicks, numSamples);
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::recordCallbackTime(juce::int64 startTicks, int numSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    const auto endTicks = juce::Time::getHighResolutionTicks();
+    const auto elapsed = juce::Time::highResolutionTicksToSeconds(endTicks - startTicks);
+    const auto load = static_cast<float>(elapsed * hostSampleRate / numSamples);
+
+    trace.recordSpan(AudioTrace::Type::Callback, static_cast<float>(numSamples), startTicks, endTicks);
+
+    if (load > worstCallbackLoad.get())
+        worstCallbackLoad.set(load);
+
+    // Rendering offline may take as long as it likes
+    if (load > 1.f && isNonRealtime() == false)
+    {
+        numCallbackOverruns.set(numCallbackOverruns.get() + 1);
+        trace.record(AudioTrace::Type::CallbackOverrun, load);
+    }
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::traceBypassChanges()
+{
+    int mask = 0;
+    for (int instance = 0; instance < NumModuleInstances; ++instance)
+    {
+        for (size_t i = 0; i < NumOptions; ++i)
+        {
+            if (isOptionBypassed(static_cast<DSP_Option>(i), instance))
+                mask |= 1 << (static_cast<size_t>(instance) * NumOptions + i);
+        }
+    }
+
+    if (mask != tracedBypassMask)
+    {
+        trace.record(AudioTrace::Type::BypassChanged, static_cast<float>(mask));
+        tracedBypassMask = mask;
+    }
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::processHostBlock(juce::AudioBuffer<float>& hostBuffer, bool lastPiece)
+{
+    juce::ScopedNoDenormals noDenormals;
+    auto totalNumInputChannels  = getTotalNumInputChannels();
+    auto totalNumOutputChannels = getTotalNumOutputChannels();
+
+    // In case we have more outputs than inputs, this code clears any output
+    // channels that didn't contain input data, (because these aren't
+    // guaranteed to be empty - they may contain garbage).
+    // This is here to avoid people getting screaming feedback
+    // when they first compile a plugin, but obviously you don't need to keep
+    // this code if your algorithm always overwrites all the output channels.
+    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+        hostBuffer.clear (i, 0, hostBuffer.getNumSamples());
+
+    // The sidechain only feeds the modulation matrix, everything else runs on the main bus
+    auto buffer = getBusBuffer(hostBuffer, false, 0);
+    if (getBusCount(true) > 1)
+    {
+        auto sidechain = getBusBuffer(hostBuffer, true, 1);
+        modulationMatrix.setSidechain(sidechain.getArrayOfReadPointers(), sidechain.getNumChannels(), buffer.getNumSamples());
+    }
+    else
+    {
+        modulationMatrix.setSidechain(nullptr, 0, buffer.getNumSamples());
+    }
+
+    if (auto* playHead = getPlayHead())
+    {
+        if (auto position = playHead->getPosition())
+        {
+            if (auto bpm = position->getBpm(); bpm.hasValue() && *bpm > 0.0)
+                hostBpm = *bpm;
+        }
+    }
+
+    // Only the newest set of band coefficients matters
+    bool eqBandsArrived = false;
+    while (eqBandsFifo.pull(pulledEqBands))
+        eqBandsArrived = true;
+
+    if (eqBandsArrived && pulledEqBands.sampleRate == processingSampleRate)
+    {
+        eqBands = pulledEqBands;
+        ++eqBandsVersion;
+        trace.record(AudioTrace::Type::CoefficientsChanged, 0.f);
+    }
+
+    // Every channel and band then reads the same kernel for the whole block
+    for (auto& kernels : linearPhaseKernels)
+        kernels.acquire();
+
+    updateConvolutions();
+
+    updateStereoMode();
+
+    // Mid Only and Side Only leave one channel idle, it isn't updated or processed
+    const auto processLeft = activeStereoMode != StereoMode::SideOnly;
+    const auto processRight = activeStereoMode != StereoMode::MidOnly;
+    const auto midSide = activeStereoMode != StereoMode::LeftRight && buffer.getNumChannels() >= 2;
+
+    // A restored state is held until the parameters match it
+    if (applyChainChanges() == false && holdingRestoredState && pendingStateRestores.load() == 0)
+        holdingRestoredState = false;
+
+    if (guiNeedsLatestDspOrder.compareAndSetBool(false, true))
+    {
+		restoreDspOrderFifo.push(dspOrder);
+    }
+
+    bool morphStatesChanged = false;
+    while (morphStatesFifo.pull(pulledMorphStates))
+        morphStatesChanged = true;
+
+    if (morphStatesChanged)
+        snapshotMorpher.setStates(pulledMorphStates);
+
+    // After the orders above, a delay that just joined the chain has its ring from the start
+    updateDelayRings();
+
+    // The bands' chains come from the order just settled on
+    updateBands();
+
+    if (processLeft)
+        channels[0].updateDSPFromParams(processedOrder);
+    if (processRight)
+        channels[1].updateDSPFromParams(processedOrder);
+
+	/*auto block = juce::dsp::AudioBlock<float>(buffer);
+
+	leftChannel.process(block.getSingleChannelBlock(0), dspOrder);
+	rightChannel.process(block.getSingleChannelBlock(1), dspOrder);*/
+
+    auto block = juce::dsp::AudioBlock<float>(buffer);
+
+    const auto numSamples = buffer.getNumSamples();
+
+    // Measured before the gain stage, which may encode to M/S, at the gain the stage ramps to
+    const auto inputGainTarget = inputGainSmoother.getNextValue();
+    const auto inputGainTargetLinear = juce::Decibels::decibelsToGain(inputGainTarget);
+	leftPreRMS.set(getRMSLevel(buffer, 0, numSamples) * inputGainTargetLinear);
+	rightPreRMS.set(getRMSLevel(buffer, 1, numSamples) * inputGainTargetLinear);
+
+    if (midSide)
+        applyGainRampSumDifference(block, inputGainLinear, inputGainTarget, 0.5f);
+    else
+        applyGainRamp(block, inputGainLinear, inputGainTarget);
+
+    // In fixed-rate mode the sub-blocks, smoothers and dry mix all count samples at the internal rate
+    auto chainBlock = fixedRate.toProcessingRate(block);
+	auto samplesRemaining = static_cast<int>(chainBlock.getNumSamples());
+
+    auto applyEvent = [this](const auto& event) { automatedTargets[event.target] = event.value; };
+
+    // With every band left out there is nothing to split for, the input passes straight through
+    const auto splitBands = activeNumBands > 1 && std::find(bandProcessed.begin(), bandProcessed.end(), true) != bandProcessed.end();
+    if (splitBands)
+        crossover.process(chainBlock);
+
+    size_t startSample = 0;
+    while (samplesRemaining > 0)
+    {
+        // Sub-blocks end early at the next parameter event, events just past the start are pulled onto it
+        auto start = static_cast<int>(startSample);
+        auto end = parameterEvents.consume(start + MinSubBlockSize, start + juce::jmin(samplesRemaining, SubBlockSize), applyEvent);
+		auto samplesToProcess = end - start;
+		auto subBlock = chainBlock.getSubBlock(startSample, static_cast<size_t>(samplesToProcess));
+
+        // Changes made on the audio thread while this sub-block runs take effect after it
+        liveEventOffset = end;
+
+        // The sidechain runs at the host's rate, the last sub-block takes whatever rounding left over
+        auto sidechainEnd = samplesToProcess == samplesRemaining ? numSamples : juce::roundToInt(end / fixedRate.getRateRatio());
+        isModulating = modulationMatrix.process(subBlock, sidechainEnd, modulationOffsets.data(), static_cast<int>(modulationOffsets.size()));
+
+        auto startMix = mixPercentSmoother.getCurrentValue();
+		updateSmoothersFromParams(samplesToProcess, SmootherUpdateMode::liveInRealtime);
+        updateDiscreteValues();
+
+        if (trace.isEnabled())
+            traceBypassChanges();
+        auto endMix = mixPercentSmoother.getCurrentValue();
+
+        // Fully wet sub-blocks never touch the dry copy
+        dryDelay.push(subBlock);
+        const auto needsDry = startMix < 100.f || endMix < 100.f;
+        if (needsDry)
+        {
+            auto dryBlock = juce::dsp::AudioBlock<float>(dryBuffer).getSubBlock(0, samplesToProcess);
+            dryBlock.copyFrom(subBlock);
+            dryDelay.read(dryBlock);
+        }
+
+        // The modules of every band at once, an instance can have modules on more than one
+        auto& left = channels[0];
+        auto& right = channels[1];
+        if (processLeft)
+            left.updateDSPFromParams(processedOrder);
+        if (processRight)
+            right.updateDSPFromParams(processedOrder);
+
+        for (int band = 0; band < activeNumBands; ++band)
+        {
+            const auto processed = bandProcessed[static_cast<size_t>(band)];
+
+            // Whatever isn't processed still has to wait for the linear phase filters
+            const auto padOnly = processed == false && numLinearPhaseEngaged > 0 && (splitBands || band == 0);
+            if (processed == false && padOnly == false)
+                continue;
+
+            auto bandBlock = splitBands ? crossover.getBand(band, startSample, static_cast<size_t>(samplesToProcess)) : subBlock;
+            const auto& bandOrder = bandOrders[static_cast<size_t>(band)];
+
+            if (processLeft && processed)
+                left.process(bandBlock.getSingleChannelBlock(0), bandOrder, band);
+            else
+                left.processLatencyOnly(bandBlock.getSingleChannelBlock(0), band);
+
+            if (processRight && processed)
+                right.process(bandBlock.getSingleChannelBlock(1), bandOrder, band);
+            else
+                right.processLatencyOnly(bandBlock.getSingleChannelBlock(1), band);
+        }
+
+        // The Linkwitz-Riley bands sum back flat, the ones left out included
+        if (splitBands)
+        {
+            subBlock.copyFrom(crossover.getBand(0, startSample, static_cast<size_t>(samplesToProcess)));
+            for (int band = 1; band < activeNumBands; ++band)
+                subBlock.add(crossover.getBand(band, startSample, static_cast<size_t>(samplesToProcess)));
+        }
+
+        if (needsDry)
+            mixDrySignal(subBlock, startMix, endMix);
+         
+		startSample += static_cast<size_t>(samplesToProcess);
+		samplesRemaining -= samplesToProcess;
+    }
+
+    // Points queued past the end of the block still set where the parameter ends up
+    if (lastPiece)
+    {
+        parameterEvents.consume(std::numeric_limits<int>::max(), 0, applyEvent);
+        parameterEvents.clear();
+        hasQueuedEvents.fill(false);
+    }
+    else
+    {
+        parameterEvents.advance(static_cast<int>(chainBlock.getNumSamples()));
+    }
+
+    liveEventOffset = 0;
+
+    fixedRate.fromProcessingRate(chainBlock, block);
+
+    // Decoding back to L/R shares the pass with the output gain
+    if (midSide)
+        applyGainRampSumDifference(block, outputGainLinear, outputGainSmoother.getNextValue(), 1.f);
+    else
+        applyGainRamp(block, outputGainLinear, outputGainSmoother.getNextValue());
+
+    // Last, on what actually leaves the plugin
+    if (limiterEngaged)
+    {
+        outputLimiter.setCeilingDecibels(limiterCeiling->get());
+        outputLimiter.setReleaseMs(limiterRelease->get());
+        outputLimiter.process(block);
+        limiterGainReduction.set(outputLimiter.getGainReductionDecibels());
+    }
+
+    // Modules in series ring out one after the other, the bands side by side. Both channels share the same settings
+    auto& tailChannel = channels[processLeft ? 0 : 1];
+    auto tailSamples = 0.0;
+    for (int band = 0; band < activeNumBands; ++band)
+    {
+        if (bandProcessed[static_cast<size_t>(band)] == false)
+            continue;
+
+        auto bandTailSamples = 0.0;
+        for (const auto& slot : bandOrders[static_cast<size_t>(band)])
+        {
+            if (isOptionBypassed(slot.option, slot.instance) == false)
+                bandTailSamples += tailChannel.getModules(slot.instance).tailSamples[static_cast<size_t>(slot.option)];
+        }
+
+        tailSamples = juce::jmax(tailSamples, bandTailSamples);
+    }
+    tailLengthSeconds.store(tailSamples / processingSampleRate);
+
+	leftPostRMS.set(getRMSLevel(buffer, 0, numSamples));
+	rightPostRMS.set(getRMSLevel(buffer, 1, numSamples));
+
+    leftSCSF.update(buffer);
+	rightSCSF.update(buffer);
+
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::mixDrySignal(const juce::dsp::AudioBlock<float>& wet, float startMix, float endMix)
+{
+    const auto numSamples = static_cast<int>(wet.getNumSamples());
+    jassert(numSamples <= dryBuffer.getNumSamples());
+
+    // wet = dry + mix * (wet - dry), with the mix ramped per sample across the sub-block
+    const auto startGain = startMix * 0.01f;
+    const auto step = (endMix - startMix) * 0.01f / static_cast<float>(numSamples);
+
+    const auto numChannels = juce::jmin(static_cast<int>(wet.getNumChannels()), dryBuffer.getNumChannels());
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* out = wet.getChannelPointer(static_cast<size_t>(ch));
+        const auto* dry = dryBuffer.getReadPointer(ch);
+
+        SimdKernels::crossfade(out, dry, numSamples, startGain, step);
+    }
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::applyGainRamp(const juce::dsp::AudioBlock<float>& block, float& currentGain, float targetDecibels)
+{
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+    if (numSamples == 0)
+        return;
+
+    const auto targetGain = juce::Decibels::decibelsToGain(targetDecibels);
+    const auto step = (targetGain - currentGain) / static_cast<float>(numSamples);
+
+    for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+        SimdKernels::applyGainRamp(block.getChannelPointer(ch), numSamples, currentGain, step);
+
+    currentGain = targetGain;
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::applyGainRampSumDifference(const juce::dsp::AudioBlock<float>& block, float& currentGain, float targetDecibels, float scale)
+{
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+    if (numSamples == 0 || block.getNumChannels() < 2)
+        return;
+
+    const auto targetGain = juce::Decibels::decibelsToGain(targetDecibels);
+    const auto step = (targetGain - currentGain) / static_cast<float>(numSamples);
+
+    SimdKernels::sumAndDifference(block.getChannelPointer(0), block.getChannelPointer(1), numSamples, currentGain * scale, step * scale);
+
+    for (size_t ch = 2; ch < block.getNumChannels(); ++ch)
+        SimdKernels::applyGainRamp(block.getChannelPointer(ch), numSamples, currentGain, step);
+
+    currentGain = targetGain;
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::updateStereoMode()
+{
+    auto mode = static_cast<StereoMode>(juce::jlimit(0, static_cast<int>(StereoMode::END_OF_LIST) - 1, stereoMode->getIndex()));
+    if (mode == activeStereoMode)
+        return;
+
+    // Whatever the delays and filters held belonged to the other signal
+    if (activeStereoMode != StereoMode::END_OF_LIST)
+    {
+        for (auto& channel : channels)
+            channel.reset();
+    }
+
+    // A channel that doesn't run can't take part in ping-pong
+    const auto bothRun = mode == StereoMode::LeftRight || mode == StereoMode::MidSide;
+    channels[0].setPartner(bothRun ? &channels[1] : nullptr);
+    channels[1].setPartner(bothRun ? &channels[0] : nullptr);
+
+    activeStereoMode = mode;
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::updateBands()
+{
+    std::array<float, LinkwitzRileyCrossover::MaxSplits> frequencies {};
+    for (size_t i = 0; i < frequencies.size(); ++i)
+        frequencies[i] = crossoverFrequencies[i]->get();
+
+    // The crossover splits a stereo pair, a mono bus runs the whole chain unsplit
+    crossover.setBands(getMainBusNumInputChannels() >= 2 ? bandCount->get() : 1, frequencies);
+
+    // A different split changes what every band carries
+    const auto numBands = crossover.getNumBands();
+    const auto countChanged = numBands != activeNumBands;
+    activeNumBands = numBands;
+
+    if (countChanged)
+    {
+        for (auto& channel : channels)
+            channel.reset();
+    }
+
+    for (auto& order : bandOrders)
+        order = DSP_Order();
+
+    for (const auto& slot : dspOrder)
+        bandOrders[static_cast<size_t>(juce::jmin(slot.band, numBands - 1))].add(slot);
+
+    const auto processLeft = activeStereoMode != StereoMode::SideOnly;
+    const auto processRight = activeStereoMode != StereoMode::MidOnly;
+    processedOrder = DSP_Order();
+
+    for (int band = 0; band < MaxBands; ++band)
+    {
+        const auto& order = bandOrders[static_cast<size_t>(band)];
+
+        // With one band the modules' own bypasses are all there is
+        const auto running = band < numBands && (numBands == 1 || bandBypasses[static_cast<size_t>(band)]->get() == false);
+
+        // A band coming back from bypass picks up where its input is now, not where it left off
+        auto& wasRunning = bandRunning[static_cast<size_t>(band)];
+        if (running && wasRunning == false && countChanged == false)
+        {
+            channels[0].resetModules(order);
+            channels[1].resetModules(order);
+        }
+
+        wasRunning = running;
+
+        const auto bypassedThroughout = (processLeft == false || channels[0].isBypassedThroughout(order))
+                                     && (processRight == false || channels[1].isBypassedThroughout(order));
+
+        auto& processed = bandProcessed[static_cast<size_t>(band)];
+        processed = running && bypassedThroughout == false;
+
+        if (processed)
+        {
+            for (const auto& slot : order)
+                processedOrder.add(slot);
+        }
+    }
+}
+
+float JUCE_MultiFX_ProcessorAudioProcessor::getRMSLevel(const juce::AudioBuffer<float>& buffer, int channel, int numSamples)
+{
+    if (numSamples <= 0 || juce::isPositiveAndBelow(channel, buffer.getNumChannels()) == false)
+        return 0.f;
+
+    return std::sqrt(SimdKernels::sumOfSquares(buffer.getReadPointer(channel), numSamples) / static_cast<float>(numSamples));
+}
+
+std::array<juce::SmoothedValue<float>*, JUCE_MultiFX_ProcessorAudioProcessor::NumSmoothedParams> JUCE_MultiFX_ProcessorAudioProcessor::getSmoothers()
+{
+    std::array<std::array<juce::SmoothedValue<float>*, ModuleParameters::NumSmoothed>, NumModuleInstances> instances;
+    for (size_t i = 0; i < instances.size(); ++i)
+        instances[i] = moduleParams[i].getSmoothers();
+
+    auto smoothers = arrangeSmoothedParams(instances, std::array
+        {
+            &inputGainSmoother,
+            &outputGainSmoother,
+            &mixPercentSmoother,
+        });
+
+    static_assert(smoothers.size() == NumSmoothedParams);
+	return smoothers;
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::MonoChannelDSP::processModule(DSP_Option option,
+                                                                         ModuleSet& modules,
+                                                                         const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    switch (option)
+    {
+    case DSP_Option::Phase:         modules.phaser.dsp.process(context); return;
+    case DSP_Option::Chorus:        modules.chorus.dsp.process(context); return;
+    case DSP_Option::Overdrive:     modules.overdrive.dsp.process(context); return;
+    case DSP_Option::LadderFilter:  modules.ladderFilter.dsp.process(context); return;
+    case DSP_Option::GeneralFilter: modules.generalFilter.dsp.process(context); return;
+    case DSP_Option::Delay:         modules.delay.dsp.process(context); return;
+    case DSP_Option::Convolution:   modules.convolution.dsp.process(context); return;
+    case DSP_Option::END_OF_LIST:   break;
+    }
+    jassertfalse;
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::MonoChannelDSP::process(juce::dsp::AudioBlock<float> block, const DSP_Order &dspOrder, int band)
+{
+    // Process the audio through the DSP chain
+    auto context = juce::dsp::ProcessContextReplacing<float>(block);
+    auto numLinearPhase = 0;
+
+    for (const auto& slot : dspOrder)
+    {
+        if (slot.option == DSP_Option::END_OF_LIST || juce::isPositiveAndBelow(slot.instance, NumModuleInstances) == false)
+        {
+            jassertfalse; // This should never happen
+            continue;
+        }
+
+        auto& modules = getModules(slot.instance);
+        const auto optionIndex = static_cast<size_t>(slot.option);
+        const auto bypassed = p.isOptionBypassed(slot.option, slot.instance);
+
+        juce::ScopedValueSetter<bool> svs(context.isBypassed, bypassed);
+
+#if VERIFY_BYPASS_FUNCTIONALITY
+        if (context.isBypassed)
+        {
+            jassertfalse;
+        }
+
+        if (slot.option == DSP_Option::GeneralFilter)
+        {
+            continue;
+        }
+
+#endif
+
+        // Never sleeps or skips, bypass fades it to a plain delay so the latency stays the same
+        if (slot.option == DSP_Option::GeneralFilter && modules.linearPhase)
+        {
+            modules.linearPhaseFilter.dsp.process(context);
+            modules.wasBypassed[optionIndex] = bypassed;
+            ++numLinearPhase;
+            continue;
+        }
+
+        if (bypassed != modules.wasBypassed[optionIndex])
+        {
+            processWithBypassCrossfade(modules, slot.option, context, bypassed);
+            modules.wasBypassed[optionIndex] = bypassed;
+            modules.silentSamples[optionIndex] = 0;
+            modules.asleep[optionIndex] = false;
+            continue;
+        }
+
+        if (bypassed == false && updateSleepState(modules, slot, block))
+            continue;
+
+        processModule(slot.option, modules, context);
+    }
+
+    applyLinearPhasePad(block, band, numLinearPhase);
+}
+
+bool JUCE_MultiFX_ProcessorAudioProcessor::MonoChannelDSP::isBypassedThroughout(const DSP_Order& dspOrder)
+{
+    for (const auto& slot : dspOrder)
+    {
+        auto& modules = getModules(slot.instance);
+        const auto bypassed = p.isOptionBypassed(slot.option, slot.instance);
+
+        // A bypassed linear phase filter still delays its share, the pad can't stand in for its fade
+        if (bypassed == false || modules.wasBypassed[static_cast<size_t>(slot.option)] == false
+            || (slot.option == DSP_Option::GeneralFilter && modules.linearPhase))
+            return false;
+    }
+
+    return true;
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::MonoChannelDSP::applyLinearPhasePad(const juce::dsp::AudioBlock<float>& block, int band, int numLinearPhase)
+{
+    if (p.numLinearPhaseEngaged == 0)
+        return;
+
+    // Every channel and band is as late as the engaged filters make the reported latency, in a slot or not
+    auto& pad = linearPhasePads[static_cast<size_t>(band)];
+    pad.setDelaySamples(getChainLatencySamples(p.numLinearPhaseEngaged - numLinearPhase));
+    pad.push(block);
+    pad.read(block);
+}
+
+bool JUCE_MultiFX_ProcessorAudioProcessor::MonoChannelDSP::updateSleepState(ModuleSet& modules,
+                                                                            ChainSlot slot,
+                                                                            const juce::dsp::AudioBlock<float>& input)
+{
+    const auto index = static_cast<size_t>(slot.option);
+    const auto numSamples = static_cast<int>(input.getNumSamples());
+
+    auto range = juce::FloatVectorOperations::findMinAndMax(input.getChannelPointer(0), numSamples);
+    if (juce::jmax(std::abs(range.getStart()), std::abs(range.getEnd())) >= SilenceThreshold)
+    {
+        // The state was cleared when it fell asleep, so it picks up from silence
+        modules.silentSamples[index] = 0;
+        modules.asleep[index] = false;
+        return false;
+    }
+
+    if (modules.asleep[index])
+        return true;
+
+    modules.silentSamples[index] = juce::jmin(modules.silentSamples[index], std::numeric_limits<int>::max() - numSamples) + numSamples;
+    if (modules.silentSamples[index] <= modules.tailSamples[index])
+        return false;
+
+    // A ping-pong delay reads its partner's ring in lockstep, so it has to keep running with it
+    if (slot.option == DSP_Option::Delay && p.getDiscreteIndex(DiscreteParam::DelayPingPong, slot.instance) != 0)
+        return false;
+
+    resetModule(modules, slot.option);
+    modules.asleep[index] = true;
+    return true;
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::MonoChannelDSP::resetModule(ModuleSet& modules, DSP_Option option)
+{
+    switch (option)
+    {
+    case DSP_Option::Phase:
+        modules.phaser.reset();
+        return;
+    case DSP_Option::Chorus:
+        modules.chorus.reset();
+        return;
+    case DSP_Option::Overdrive:
+        modules.overdrive.reset();
+        return;
+    case DSP_Option::LadderFilter:
+        modules.ladderFilter.reset();
+        return;
+    case DSP_Option::GeneralFilter:
+        modules.generalFilter.reset();
+        modules.linearPhaseFilter.reset();
+        return;
+    case DSP_Option::Delay:
+        modules.delay.reset();
+        return;
+    case DSP_Option::Convolution:
+        modules.convolution.reset();
+        return;
+    case DSP_Option::END_OF_LIST:
+        break;
+    }
+    jassertfalse;
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::MonoChannelDSP::processWithBypassCrossfade(ModuleSet& modules,
+                                                                                      DSP_Option option,
+                                                                                      const juce::dsp::ProcessContextReplacing<float>& context,
+                                                                                      bool fadeToBypassed)
+{
+    auto& block = context.getOutputBlock();
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+    jassert(numSamples <= crossfadeBuffer.getNumSamples());
+
+    auto* dry = crossfadeBuffer.getWritePointer(0);
+    auto* wet = block.getChannelPointer(0);
+    juce::FloatVectorOperations::copy(dry, wet, numSamples);
+
+    // Run the module for the whole fade, whichever way it's going
+    auto processed = juce::dsp::ProcessContextReplacing<float>(block);
+    processModule(option, modules, processed);
+
+    const auto start = fadeToBypassed ? 1.f : 0.f;
+    const auto step = (fadeToBypassed ? -1.f : 1.f) / static_cast<float>(numSamples);
+    SimdKernels::crossfade(wet, dry, numSamples, start, step);
+}
+
+//==============================================================================
+bool JUCE_MultiFX_ProcessorAudioProcessor::hasEditor() const
+{
+    return true; // (change this to false if you choose to not supply an editor)
+}
+
+juce::AudioProcessorEditor* JUCE_MultiFX_ProcessorAudioProcessor::createEditor()
+{
+    return new JUCE_MultiFX_ProcessorAudioProcessorEditor (*this);
+	//return new juce::GenericAudioProcessorEditor(*this);
+}
+
+//==============================================================================
+
+template<>
+struct juce::VariantConverter<JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order>
+{
+    static JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order fromVar(const juce::var& v)
+    {
+		jassert(v.isBinaryData()); // Ensure the var is a binary data type
+        if (v.isBinaryData() == false)
+            return JUCE_MultiFX_ProcessorAudioProcessor::makeDefaultOrder();
+
+        auto mb = *v.getBinaryData();
+        juce::MemoryInputStream mis(mb, false);
+        std::vector<int> arr;
+        while (!mis.isExhausted())
+        {
+            arr.push_back(mis.readInt());
+        }
+
+        return JUCE_MultiFX_ProcessorAudioProcessor::decodeOrder(arr);
+	}
+     
+    static juce::var toVar(const JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order& t)
+    {
+        juce::MemoryBlock mb;
+
+        //JUCE memory output stream uses scoping to complete writing to the MemoryBlock
+        {
+            juce::MemoryOutputStream mos(mb, false);
+
+            for (const auto& slot : t)
+            {
+				mos.writeInt(JUCE_MultiFX_ProcessorAudioProcessor::encodeChainSlot(slot));
+            }
+		}
+        return mb;
+    }
+};
 
-    name = getGeneralFilterBypassName();
-    layout.add(std::make_unique<juce::AudioParameterBool>(
-        juce::ParameterID{ name, versionHint },
-        name,
-        false
-	));
+JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order JUCE_MultiFX_ProcessorAudioProcessor::makeDefaultOrder()
+{
+    DSP_Order order;
+    for (int i = 0; i < static_cast<int>(DSP_Option::END_OF_LIST); ++i)
+        order.add({ static_cast<DSP_Option>(i), 0 });
 
-	name = getSelectedTabName();
-    layout.add(std::make_unique<juce::AudioParameterInt>(
-        juce::ParameterID{ name, versionHint },
-        name,
-        0, 
-        static_cast<int>(DSP_Option::END_OF_LIST) - 1,
-		static_cast<int>(DSP_Option::Chorus)
-    ));
+    return order;
+}
 
-	return layout;
+void JUCE_MultiFX_ProcessorAudioProcessor::setDspOrder(const DSP_Order& newOrder)
+{
+    // Every change reaches the audio thread in the end, so the order can be saved with the state now
+    requestedDspOrder = newOrder;
+    allocateDelayRings(newOrder);
+
+    ChainChange change;
+    change.type = ChainChange::Type::Order;
+    change.snapshot.order = newOrder;
+    publishChainChange(change);
 }
 
-void JUCE_MultiFX_ProcessorAudioProcessor::MonoChannelDSP::updateDSPFromParams()
+void JUCE_MultiFX_ProcessorAudioProcessor::publishChainChange(const ChainChange& change)
 {
-    phaser.dsp.setRate(p.phaserRateHzSmoother.getCurrentValue());
-    phaser.dsp.setDepth(p.phaserDepthPercentSmoother.getCurrentValue() * 0.01f );
-    phaser.dsp.setCentreFrequency(p.phaserCenterFreqHzSmoother.getCurrentValue());
-    phaser.dsp.setFeedback(p.phaserFeedbackPercentSmoother.getCurrentValue() * 0.01f);
-    phaser.dsp.setMix(p.phaserMixPercentSmoother.getCurrentValue() * 0.01f);
+    // Behind any change still waiting, so the audio thread sees them in the order they were made
+    if (flushChainChanges() && chainChangeFifo.push(change))
+        return;
 
-    chorus.dsp.setRate(p.chorusRateHzSmoother.getCurrentValue());
-    chorus.dsp.setDepth(p.chorusDepthPercentSmoother.getCurrentValue() * 0.01f);
-    chorus.dsp.setCentreDelay(p.chorusCenterDelayMsSmoother.getCurrentValue());
-    chorus.dsp.setFeedback(p.chorusFeedbackPercentSmoother.getCurrentValue() * 0.01f);
-    chorus.dsp.setMix(p.chorusMixPercentSmoother.getCurrentValue() * 0.01f);
+    // A recall replaces the order and the morph, a restored state replaces everything
+    auto overrides = [&change](const ChainChange& waiting)
+    {
+        switch (change.type)
+        {
+        case ChainChange::Type::Order:          return waiting.type == ChainChange::Type::Order;
+        case ChainChange::Type::SnapshotRecall: return waiting.type != ChainChange::Type::StateRestore;
+        case ChainChange::Type::StateRestore:   return true;
+        }
+        return false;
+    };
 
-    overdrive.dsp.setDrive(p.overdriveSaturationSmoother.getCurrentValue());
+    while (pendingChainChanges.empty() == false && overrides(pendingChainChanges.back()))
+        pendingChainChanges.pop_back();
 
-    ladderFilter.dsp.setMode(static_cast<juce::dsp::LadderFilter<float>::Mode>(p.ladderFilterMode->getIndex()));
-    ladderFilter.dsp.setCutoffFrequencyHz(p.ladderFilterCutoffHzSmoother.getCurrentValue());
-    ladderFilter.dsp.setResonance(p.ladderFilterResonanceSmoother.getCurrentValue() * 0.01f);
-    ladderFilter.dsp.setDrive(p.ladderFilterDriveSmoother.getCurrentValue());
+    pendingChainChanges.push_back(change);
 
-    auto sampleRate = p.getSampleRate();
+    // Polled rather than left to an AsyncUpdater, which would spin while the host isn't calling processBlock()
+    if (isTimerRunning() == false)
+        startTimer(10);
+}
 
-	// Update the general filter coefficients based on the current parameters
-	auto genMode = p.generalFilterMode->getIndex();
-	auto genHz = p.generalFilterFreqHzSmoother.getCurrentValue();
-	auto genQ = p.generalFilterQualitySmoother.getCurrentValue();
-    auto genGain = p.generalFilterGainSmoother.getCurrentValue();
+bool JUCE_MultiFX_ProcessorAudioProcessor::flushChainChanges()
+{
+    size_t numPushed = 0;
+    while (numPushed < pendingChainChanges.size() && chainChangeFifo.push(pendingChainChanges[numPushed]))
+        ++numPushed;
 
-	bool filterChanged = false;
+    pendingChainChanges.erase(pendingChainChanges.begin(), pendingChainChanges.begin() + static_cast<std::ptrdiff_t>(numPushed));
+    return pendingChainChanges.empty();
+}
 
-    filterChanged |= (filterFreq != genHz);
-    filterChanged |= (filterQ != genQ);
-    filterChanged |= (filterGain != genGain);
+void JUCE_MultiFX_ProcessorAudioProcessor::timerCallback()
+{
+    if (flushChainChanges())
+        stopTimer();
+}
 
-	auto updatedMode = static_cast<GeneralFilterMode>(genMode);
-    filterChanged |= (filterMode != updatedMode);
+bool JUCE_MultiFX_ProcessorAudioProcessor::applyChainChanges()
+{
+    bool stateRestored = false;
 
-    if (filterChanged)
+    // Everything arrives complete and preallocated, and is applied in the order it was made
+    while (chainChangeFifo.pull(pulledChainChange))
     {
-        filterMode = updatedMode;
-        filterFreq = genHz;
-        filterQ = genQ;
-        filterGain = genGain;
-
-        juce::dsp::IIR::Coefficients<float>::Ptr coefficients;
-
-        switch (filterMode)
+        switch (pulledChainChange.type)
         {
-        case GeneralFilterMode::Peak:
-            coefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, filterFreq, filterQ, juce::Decibels::decibelsToGain(filterGain));
-            break;
-        case GeneralFilterMode::Bandpass:
-            coefficients = juce::dsp::IIR::Coefficients<float>::makeBandPass(sampleRate, filterFreq, filterQ);
-            break;
-        case GeneralFilterMode::Notch:
-            coefficients = juce::dsp::IIR::Coefficients<float>::makeNotch(sampleRate, filterFreq, filterQ);
-            break;
-        case GeneralFilterMode::Allpass:
-            coefficients = juce::dsp::IIR::Coefficients<float>::makeAllPass(sampleRate, filterFreq, filterQ);
+        case ChainChange::Type::Order:
+#if VERIFY_BYPASS_FUNCTIONALITY
+            jassertfalse;
+#endif
+            // The modules all live in the preallocated pool, switching orders is just a copy
+            if (pulledChainChange.snapshot.order != dspOrder)
+            {
+                dspOrder = pulledChainChange.snapshot.order;
+                trace.record(AudioTrace::Type::OrderChanged, static_cast<float>(dspOrder.size()));
+            }
             break;
-        case GeneralFilterMode::END_OF_LIST:
-            jassertfalse; // This should never happen
+
+        case ChainChange::Type::SnapshotRecall:
+            beginSnapshotMorph(pulledChainChange.snapshot);
+            trace.record(AudioTrace::Type::SnapshotRecalled);
             break;
-        }
 
-        if (coefficients != nullptr)
-        {
-            //if (generalFilter.dsp.coefficients->coefficients.size() != coefficients->coefficients.size())
-            //{
-            //    jassertfalse; // Coefficients size mismatch
-            //}
-            *generalFilter.dsp.coefficients = *coefficients;
-            generalFilter.reset();
+        case ChainChange::Type::StateRestore:
+            restoredState = pulledChainChange.snapshot;
+            adoptRestoredState();
+            stateRestored = true;
+            break;
         }
     }
+
+    return stateRestored;
 }
 
-std::vector< juce::RangedAudioParameter*> JUCE_MultiFX_ProcessorAudioProcessor::getParamsForOption(DSP_Option option)
+int JUCE_MultiFX_ProcessorAudioProcessor::encodeChainSlot(ChainSlot slot)
 {
-    switch (option)
-    {
-    case DSP_Option::Phase:
-        return
-        {
-            phaserRateHz,
-            phaserDepthPercent, 
-            phaserCenterFreqHz, 
-            phaserFeedbackPercent, 
-            phaserMixPercent, 
-            phaserBypass
-        };
-    case DSP_Option::Chorus:
-        return
-        {
-            chorusRateHz, 
-            chorusDepthPercent, 
-            chorusCenterDelayMs, 
-            chorusFeedbackPercent, 
-            chorusMixPercent, 
-            chorusBypass
-        };
-    case DSP_Option::Overdrive:
-        return
-        {
-            overdriveSaturation, 
-            overdriveBypass
-        };
-    case DSP_Option::LadderFilter:
-        return
-        {
-            ladderFilterMode, 
-            ladderFilterCutoffHz, 
-            ladderFilterResonance, 
-            ladderFilterDrive, 
-            ladderFilterBypass
-        };
-    case DSP_Option::GeneralFilter:
-        return
-        {
-            generalFilterMode, 
-            generalFilterFreqHz, 
-            generalFilterQuality, 
-            generalFilterGain, 
-            generalFilterBypass
-        };
-	case DSP_Option::END_OF_LIST:
-		break; // This should never happen
-	}
-    jassertfalse;
-    return {};
-    
+    return static_cast<int>(slot.option) | (slot.instance << 8) | (slot.band << 16);
 }
 
-
-void JUCE_MultiFX_ProcessorAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order JUCE_MultiFX_ProcessorAudioProcessor::decodeOrder(const std::vector<int>& storedOrder)
 {
-    juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    DSP_Order order;
 
-    // In case we have more outputs than inputs, this code clears any output
-    // channels that didn't contain input data, (because these aren't
-    // guaranteed to be empty - they may contain garbage).
-    // This is here to avoid people getting screaming feedback
-    // when they first compile a plugin, but obviously you don't need to keep
-    // this code if your algorithm always overwrites all the output channels.
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
+    for (auto value : storedOrder)
+    {
+        // Unused bank entries are negative
+        if (value < 0)
+            continue;
 
-	// TODO: wet/dry mix control [STRETCH]
-	// TODO: mono and stereo versions [STRETCH]
-	// TODO: modulators (eg. LFOs, envelopes, etc.) [STRETCH]
-	// TODO: thread-safe filter updates [STRETCH]
-	// TODO: pre/post filtering [STRETCH]
-	// TODO: delay module [STRETCH]
+        ChainSlot slot { static_cast<DSP_Option>(value & 0xff), (value >> 8) & 0xff, value >> 16 };
+        if (juce::isPositiveAndBelow(value & 0xff, static_cast<int>(DSP_Option::END_OF_LIST)) == false
+            || juce::isPositiveAndBelow(slot.instance, NumModuleInstances) == false
+            || juce::isPositiveAndBelow(slot.band, MaxBands) == false)
+            continue;
 
-	leftChannel.updateDSPFromParams();
-	rightChannel.updateDSPFromParams();
+        order.add(slot);
+    }
 
-    auto newDSPOrder = DSP_Order();
+    return order;
+}
 
-	// Try to pull the DSP order from the FIFO
-    while (dspOrderFifo.pull(newDSPOrder))
+//==============================================================================
+bool JUCE_MultiFX_ProcessorAudioProcessor::isSnapshotParameter(const juce::AudioProcessorParameter* param) const
+{
+    // Nor should anything that needs the host to restart
+    for (const auto& params : moduleParams)
     {
-#if VERIFY_BYPASS_FUNCTIONALITY
-        jassertfalse;
-#endif
+        if (param == params.get(ModuleParam::GeneralFilterLinearPhase))
+            return false;
     }
 
-	// If the DSP order has changed, we need to reconfigure the DSP chain
-    if ( newDSPOrder != DSP_Order() )
-		dspOrder = newDSPOrder;
+    // GUI state and the morph controls themselves shouldn't change when a snapshot is recalled
+    return param != selectedTab
+        && param != internalRate
+        && param != limiterEnabled
+        && param != snapshotMorphTimeMs
+        && param != snapshotMorphPosition
+        && param != snapshotMorphEnabled;
+}
+
+JUCE_MultiFX_ProcessorAudioProcessor::Snapshot JUCE_MultiFX_ProcessorAudioProcessor::captureSnapshot() const
+{
+    Snapshot snapshot;
 
-    if (guiNeedsLatestDspOrder.compareAndSetBool(false, true))
+    for (auto* param : getParameters())
     {
-		restoreDspOrderFifo.push(dspOrder);
+        auto index = param->getParameterIndex();
+        if (juce::isPositiveAndBelow(index, MaxSnapshotParams))
+            snapshot.values[static_cast<size_t>(index)] = param->getValue();
     }
 
-	/*auto block = juce::dsp::AudioBlock<float>(buffer);
+    snapshot.order = requestedDspOrder;
+    snapshot.isValid = true;
+    return snapshot;
+}
 
-	leftChannel.process(block.getSingleChannelBlock(0), dspOrder);
-	rightChannel.process(block.getSingleChannelBlock(1), dspOrder);*/
+void JUCE_MultiFX_ProcessorAudioProcessor::applySnapshot(const Snapshot& snapshot)
+{
+    jassert(snapshot.isValid);
 
-    auto block = juce::dsp::AudioBlock<float>(buffer);
+    // The audio thread starts morphing towards the snapshot straight away,
+    // the host and GUI catch up through the parameters below.
+    requestedDspOrder = snapshot.order;
+    allocateDelayRings(snapshot.order);
 
-	auto preCtx = juce::dsp::ProcessContextReplacing<float>(block);
+    ChainChange change;
+    change.type = ChainChange::Type::SnapshotRecall;
+    change.snapshot = snapshot;
+    publishChainChange(change);
 
-	inputGainSmoother.setTargetValue(inputGain->get());
-	outputGainSmoother.setTargetValue(outputGain->get());
-    inputGainDSP.setGainDecibels(inputGainSmoother.getNextValue());
-	inputGainDSP.process(preCtx);
+    for (auto* param : getParameters())
+    {
+        if (isSnapshotParameter(param) == false)
+            continue;
 
-    const auto numSamples = buffer.getNumSamples();
-	auto samplesRemaining = numSamples;
-	auto maxSamplesToProcess = juce::jmin(samplesRemaining, 64);
+        auto value = snapshot.values[static_cast<size_t>(param->getParameterIndex())];
+        if (param->getValue() != value)
+        {
+            param->beginChangeGesture();
+            param->setValueNotifyingHost(value);
+            param->endChangeGesture();
+        }
+    }
+}
 
-	leftPreRMS.set(buffer.getRMSLevel(0, 0, numSamples));
-	rightPreRMS.set(buffer.getRMSLevel(1, 0, numSamples));
+void JUCE_MultiFX_ProcessorAudioProcessor::beginSnapshotMorph(const Snapshot& snapshot)
+{
+    auto smoothers = getSmoothers();
+    auto params = getParamsNeedingSmoothing();
 
-    
-    size_t startSample = 0;
-    while (samplesRemaining > 0)
+    for (size_t i = 0; i < smoothers.size(); ++i)
     {
-		auto samplesToProcess = juce::jmin(samplesRemaining, maxSamplesToProcess);
-		updateSmoothersFromParams(samplesToProcess, SmootherUpdateMode::liveInRealtime);
+        snapshotMorph.from[i] = smoothers[i]->getCurrentValue();
+        snapshotMorph.to[i] = params[i]->convertFrom0to1(snapshot.values[static_cast<size_t>(params[i]->getParameterIndex())]);
+    }
 
-		leftChannel.updateDSPFromParams();
-        rightChannel.updateDSPFromParams();
+    snapshotMorph.totalSamples = juce::jmax(1, juce::roundToInt(snapshotMorphTimeMs->get() * 0.001 * processingSampleRate));
+    snapshotMorph.samplesRemaining = snapshotMorph.totalSamples;
 
-		auto subBlock = block.getSubBlock(startSample, samplesToProcess);
+    if (snapshot.order != dspOrder)
+    {
+        dspOrder = snapshot.order;
+        restoreDspOrderFifo.push(dspOrder);
+        trace.record(AudioTrace::Type::OrderChanged, static_cast<float>(dspOrder.size()));
+    }
+}
 
-        leftChannel.process(subBlock.getSingleChannelBlock(0), dspOrder);
-        rightChannel.process(subBlock.getSingleChannelBlock(1), dspOrder);
-         
-		startSample += samplesToProcess;
-		samplesRemaining -= samplesToProcess;
+JUCE_MultiFX_ProcessorAudioProcessor::Snapshot JUCE_MultiFX_ProcessorAudioProcessor::makeRestoredState(const juce::ValueTree& tree) const
+{
+    Snapshot state;
+
+    // Parameters the tree doesn't have go back to their defaults, as replaceState() does
+    for (auto* param : getParameters())
+    {
+        auto index = param->getParameterIndex();
+        if (juce::isPositiveAndBelow(index, MaxSnapshotParams) == false)
+            continue;
+
+        auto& value = state.values[static_cast<size_t>(index)];
+        value = param->getDefaultValue();
+
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param))
+        {
+            auto paramTree = tree.getChildWithProperty("id", ranged->paramID);
+            if (paramTree.hasProperty("value"))
+                value = ranged->convertTo0to1(static_cast<float>(paramTree.getProperty("value")));
+        }
     }
 
-	auto postCtx = juce::dsp::ProcessContextReplacing<float>(block);
-	outputGainDSP.setGainDecibels(outputGainSmoother.getNextValue());
-	outputGainDSP.process(postCtx);
+    state.order = tree.hasProperty("dspOrder") ?
+        juce::VariantConverter<DSP_Order>::fromVar(tree.getProperty("dspOrder")) : requestedDspOrder;
+    state.isValid = true;
+    return state;
+}
 
-	leftPostRMS.set(buffer.getRMSLevel(0, 0, numSamples));
-	rightPostRMS.set(buffer.getRMSLevel(1, 0, numSamples));
+void JUCE_MultiFX_ProcessorAudioProcessor::adoptRestoredState()
+{
+    // A recall still morphing would carry on from the state being replaced
+    snapshotMorph.samplesRemaining = 0;
+    holdingRestoredState = true;
+    trace.record(AudioTrace::Type::StateRestored);
 
-    leftSCSF.update(buffer);
-	rightSCSF.update(buffer);
+    if (restoredState.order != dspOrder)
+    {
+        dspOrder = restoredState.order;
+        restoreDspOrderFifo.push(dspOrder);
+        trace.record(AudioTrace::Type::OrderChanged, static_cast<float>(dspOrder.size()));
+    }
+}
 
+bool JUCE_MultiFX_ProcessorAudioProcessor::hasSnapshot(int slot) const
+{
+    return juce::isPositiveAndBelow(slot, NumSnapshots) && snapshots[static_cast<size_t>(slot)].isValid;
 }
 
-std::vector<juce::SmoothedValue<float>*> JUCE_MultiFX_ProcessorAudioProcessor::getSmoothers()
-{
-    auto smoothers = std::vector
-    {
-		&phaserRateHzSmoother,
-		&phaserDepthPercentSmoother,
-		&phaserCenterFreqHzSmoother,
-		&phaserFeedbackPercentSmoother,
-		&phaserMixPercentSmoother,
-		&chorusRateHzSmoother,
-		&chorusDepthPercentSmoother,
-		&chorusCenterDelayMsSmoother,
-		&chorusFeedbackPercentSmoother,
-		&chorusMixPercentSmoother,
-		&overdriveSaturationSmoother,
-		&ladderFilterCutoffHzSmoother,
-		&ladderFilterResonanceSmoother,
-		&ladderFilterDriveSmoother,
-		&generalFilterFreqHzSmoother,
-		&generalFilterQualitySmoother,
-        &generalFilterGainSmoother,
-		&inputGainSmoother,
-		&outputGainSmoother,
-    };
+void JUCE_MultiFX_ProcessorAudioProcessor::storeSnapshot(int slot)
+{
+    if (juce::isPositiveAndBelow(slot, NumSnapshots) == false)
+    {
+        jassertfalse;
+        return;
+    }
 
-	return smoothers;
+    snapshots[static_cast<size_t>(slot)] = captureSnapshot();
+    activeSnapshot = slot;
+    publishMorphStates();
 }
 
-void JUCE_MultiFX_ProcessorAudioProcessor::MonoChannelDSP::process(juce::dsp::AudioBlock<float> block, const DSP_Order &dspOrder)
+bool JUCE_MultiFX_ProcessorAudioProcessor::isMorphEngineActive() const
 {
-    // Convert DSP_Order to DSP_Pointers
-    DSP_Pointers dspPointers;
-    //dspPointers.fill(nullptr); // Initialize all pointers to nullptr
-    dspPointers.fill({});
+    return snapshotMorphEnabled->get() && snapshotMorpher.canMorph();
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::publishMorphStates()
+{
+    Morpher::States states;
+    auto continuousParams = getParamsNeedingSmoothing();
+    auto discreteParams = getDiscreteParams();
 
-    for (size_t i = 0; i < dspPointers.size(); ++i)
+    for (size_t slot = 0; slot < snapshots.size(); ++slot)
     {
-        switch (dspOrder[i])
+        const auto& snapshot = snapshots[slot];
+        states.isValid[slot] = snapshot.isValid;
+        if (snapshot.isValid == false)
+            continue;
+
+        for (size_t i = 0; i < continuousParams.size(); ++i)
+            states.continuous[slot][i] = snapshot.values[static_cast<size_t>(continuousParams[i]->getParameterIndex())];
+
+        for (size_t i = 0; i < discreteParams.size(); ++i)
         {
-        case DSP_Option::Phase:
-            dspPointers[i].processor = &phaser;
-            dspPointers[i].bypassed = p.phaserBypass->get();
-            break;
-        case DSP_Option::Chorus:
-            dspPointers[i].processor = &chorus;
-            dspPointers[i].bypassed = p.chorusBypass->get();
-            break;
-        case DSP_Option::Overdrive:
-            dspPointers[i].processor = &overdrive;
-            dspPointers[i].bypassed = p.overdriveBypass->get();
-            break;
-        case DSP_Option::LadderFilter:
-            dspPointers[i].processor = &ladderFilter;
-            dspPointers[i].bypassed = p.ladderFilterBypass->get();
-            break;
-        case DSP_Option::GeneralFilter:
-            dspPointers[i].processor = &generalFilter;
-            dspPointers[i].bypassed = p.generalFilterBypass->get();
-            break;
-        case DSP_Option::END_OF_LIST:
-            jassertfalse; // This should never happen
-            break;
+            auto* param = discreteParams[i];
+            states.discrete[slot][i] = param->convertFrom0to1(snapshot.values[static_cast<size_t>(param->getParameterIndex())]);
         }
     }
 
-    // Process the audio through the DSP chain
-    auto context = juce::dsp::ProcessContextReplacing<float>(block);
+    morphStatesFifo.push(states);
+}
 
-    for (size_t i = 0; i < dspPointers.size(); ++i)
+void JUCE_MultiFX_ProcessorAudioProcessor::recallSnapshot(int slot)
+{
+    if (juce::isPositiveAndBelow(slot, NumSnapshots) == false)
     {
-        if (dspPointers[i].processor != nullptr)
-        {
-            juce::ScopedValueSetter<bool> svs(context.isBypassed, dspPointers[i].bypassed);
-
-#if VERIFY_BYPASS_FUNCTIONALITY
-            if (context.isBypassed)
-            {
-                jassertfalse;
-            }
+        jassertfalse;
+        return;
+    }
 
-            if (dspPointers[i].processor == &generalFilter)
-            {
-                continue;
-            }
+    if (slot == activeSnapshot && hasSnapshot(slot))
+        return;
 
-#endif
+    // Edits made since the last switch belong to the slot being left, like an A/B compare
+    storeSnapshot(activeSnapshot);
 
+    // An empty slot starts out as a copy of the current state
+    if (hasSnapshot(slot) == false)
+        snapshots[static_cast<size_t>(slot)] = snapshots[static_cast<size_t>(activeSnapshot)];
 
-            dspPointers[i].processor->process(context);
-        }
-    }
+    activeSnapshot = slot;
+    publishMorphStates();
+    applySnapshot(snapshots[static_cast<size_t>(slot)]);
 }
 
-//==============================================================================
-bool JUCE_MultiFX_ProcessorAudioProcessor::hasEditor() const
+void JUCE_MultiFX_ProcessorAudioProcessor::reloadPresetBank(const juce::File& bankFile)
 {
-    return true; // (change this to false if you choose to not supply an editor)
+    presetBank->loadAttempted = true;
+    presetBank->load(bankFile, [this](const juce::String& paramID)
+        {
+            if (auto* param = apvts.getParameter(paramID))
+                return param->getParameterIndex();
+            return -1;
+        });
+
+    updateHostDisplay(juce::AudioProcessor::ChangeDetails().withProgramChanged(true));
 }
 
-juce::AudioProcessorEditor* JUCE_MultiFX_ProcessorAudioProcessor::createEditor()
+bool JUCE_MultiFX_ProcessorAudioProcessor::loadPresetFromBank(int index)
 {
-    return new JUCE_MultiFX_ProcessorAudioProcessorEditor (*this);
-	//return new juce::GenericAudioProcessorEditor(*this);
-}
+    if (juce::isPositiveAndBelow(index, presetBank->getNumPresets()) == false)
+        return false;
 
-//==============================================================================
+    // Parameters the bank doesn't know about keep their current values
+    auto snapshot = captureSnapshot();
+    presetBank->readValues(index, snapshot.values.data(), MaxSnapshotParams);
 
-template<>
-struct juce::VariantConverter<JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order>
+    std::vector<int> order(static_cast<size_t>(presetBank->getOrderLength()));
+    if (order.empty() == false && presetBank->readOrder(index, order.data(), static_cast<int>(order.size())))
+        snapshot.order = decodeOrder(order);
+
+    applySnapshot(snapshot);
+    return true;
+}
+
+bool JUCE_MultiFX_ProcessorAudioProcessor::savePresetToBank(const juce::String& name, const juce::StringArray& tags)
 {
-    static JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order fromVar(const juce::var& v)
+    if (name.trim().isEmpty())
+        return false;
+
+    juce::StringArray columnIDs;
+    std::vector<int> columnParamIndices;
+    for (auto* param : getParameters())
     {
-		using T = JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order;
-		T dspOrder;
+        if (isSnapshotParameter(param) == false)
+            continue;
 
-		jassert(v.isBinaryData()); // Ensure the var is a binary data type
-        if (v.isBinaryData() == false)
+        if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(param))
         {
-			dspOrder.fill(JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option::END_OF_LIST);
+            columnIDs.add(withID->paramID);
+            columnParamIndices.push_back(param->getParameterIndex());
         }
-        else
+    }
+
+    const auto orderLength = static_cast<int>(MaxChainLength);
+
+    auto toEntry = [&](const juce::String& entryName, const juce::StringArray& entryTags, const Snapshot& snapshot)
         {
-			auto mb = *v.getBinaryData();
-			juce::MemoryInputStream mis(mb, false);
-			std::vector<int> arr;
-            while (!mis.isExhausted())
-            {
-				arr.push_back(mis.readInt());
-            }
+            PresetBank::Entry entry;
+            entry.name = entryName;
+            entry.tags = entryTags;
+            for (auto paramIndex : columnParamIndices)
+                entry.values.push_back(snapshot.values[static_cast<size_t>(paramIndex)]);
+            for (const auto& slot : snapshot.order)
+                entry.order.push_back(encodeChainSlot(slot));
+            entry.order.resize(MaxChainLength, -1);
+            return entry;
+        };
 
-			jassert(arr.size() == dspOrder.size()); // Ensure we don't overflow the dspOrder array
+    // Existing presets are re-keyed to the current parameter set, a preset with the same name is replaced
+    std::vector<PresetBank::Entry> entries;
+    Snapshot defaults = captureSnapshot();
+    for (auto* param : getParameters())
+        defaults.values[static_cast<size_t>(param->getParameterIndex())] = param->getDefaultValue();
 
-            for (size_t i = 0; i < dspOrder.size(); i++)
-            {
-                dspOrder[i] = static_cast<JUCE_MultiFX_ProcessorAudioProcessor::DSP_Option>(arr[i]);
-            }
-        }
-		return dspOrder;
-	}
-     
-    static juce::var toVar(const JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order& t)
+    for (int i = 0; i < presetBank->getNumPresets(); ++i)
     {
-        juce::MemoryBlock mb;
+        auto existingName = presetBank->getPresetName(i);
+        if (existingName == name)
+            continue;
 
-        //JUCE memory output stream uses scoping to complete writing to the MemoryBlock
+        auto existing = defaults;
+        presetBank->readValues(i, existing.values.data(), MaxSnapshotParams);
+
+        std::vector<int> order(static_cast<size_t>(presetBank->getOrderLength()));
+        if (order.empty() == false && presetBank->readOrder(i, order.data(), static_cast<int>(order.size())))
+            existing.order = decodeOrder(order);
+
+        entries.push_back(toEntry(existingName, presetBank->getPresetTags(i), existing));
+    }
+
+    entries.push_back(toEntry(name, tags, captureSnapshot()));
+
+    auto bankFile = presetBank->isLoaded() ? presetBank->getFile() : PresetBank::getDefaultBankFile();
+
+    // The mapping has to be released before the file can be replaced, every instance shares it
+    presetBank->unload();
+    auto written = PresetBank::write(bankFile, columnIDs, orderLength, entries);
+    reloadPresetBank(bankFile);
+
+    return written;
+}
+
+void JUCE_MultiFX_ProcessorAudioProcessor::restoreSnapshots(const juce::ValueTree& snapshotsTree)
+{
+    for (auto& snapshot : snapshots)
+        snapshot = Snapshot();
+
+    activeSnapshot = 0;
+    if (snapshotsTree.isValid() == false)
+    {
+        publishMorphStates();
+        return;
+    }
+
+    // Values missing from the session fall back to the state that was just restored
+    auto current = captureSnapshot();
+
+    for (int i = 0; i < snapshotsTree.getNumChildren(); ++i)
+    {
+        auto snapshotTree = snapshotsTree.getChild(i);
+        int slot = snapshotTree.getProperty("slot", -1);
+        if (juce::isPositiveAndBelow(slot, NumSnapshots) == false)
+            continue;
+
+        auto snapshot = current;
+        if (snapshotTree.hasProperty("dspOrder"))
+            snapshot.order = juce::VariantConverter<DSP_Order>::fromVar(snapshotTree.getProperty("dspOrder"));
+
+        for (int v = 0; v < snapshotTree.getNumChildren(); ++v)
         {
-            juce::MemoryOutputStream mos(mb, false);
+            auto valueTree = snapshotTree.getChild(v);
+            if (auto* param = apvts.getParameter(valueTree.getProperty("id").toString()))
+                snapshot.values[static_cast<size_t>(param->getParameterIndex())] = valueTree.getProperty("value");
+        }
 
-            for (const auto& v : t)
-            {
-				mos.writeInt(static_cast<int>(v));
-            }
-		}
-        return mb;
+        snapshots[static_cast<size_t>(slot)] = snapshot;
     }
-};
+
+    activeSnapshot = juce::jlimit(0, NumSnapshots - 1, static_cast<int>(snapshotsTree.getProperty("active", 0)));
+    publishMorphStates();
+}
 
 void JUCE_MultiFX_ProcessorAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
@@ -1063,7 +3137,37 @@ void JUCE_MultiFX_ProcessorAudioProcessor::getStateInformation (juce::MemoryBloc
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
 
-	apvts.state.setProperty("dspOrder", juce::VariantConverter<JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order>::toVar(dspOrder), nullptr);
+	apvts.state.setProperty("dspOrder", juce::VariantConverter<JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order>::toVar(requestedDspOrder), nullptr);
+
+    // Snapshots are stored per parameter ID, so they survive parameters being added or reordered
+    auto snapshotsTree = apvts.state.getOrCreateChildWithName("Snapshots", nullptr);
+    snapshotsTree.removeAllChildren(nullptr);
+    snapshotsTree.setProperty("active", activeSnapshot, nullptr);
+
+    for (int slot = 0; slot < NumSnapshots; ++slot)
+    {
+        const auto& snapshot = snapshots[static_cast<size_t>(slot)];
+        if (snapshot.isValid == false)
+            continue;
+
+        juce::ValueTree snapshotTree("Snapshot");
+        snapshotTree.setProperty("slot", slot, nullptr);
+        snapshotTree.setProperty("dspOrder", juce::VariantConverter<DSP_Order>::toVar(snapshot.order), nullptr);
+
+        for (auto* param : getParameters())
+        {
+            auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(param);
+            if (withID == nullptr || isSnapshotParameter(param) == false)
+                continue;
+
+            juce::ValueTree valueTree("Value");
+            valueTree.setProperty("id", withID->paramID, nullptr);
+            valueTree.setProperty("value", snapshot.values[static_cast<size_t>(param->getParameterIndex())], nullptr);
+            snapshotTree.appendChild(valueTree, nullptr);
+        }
+
+        snapshotsTree.appendChild(snapshotTree, nullptr);
+    }
 
 	juce::MemoryOutputStream mos(destData, false);
     apvts.state.writeToStream(mos);
@@ -1077,26 +3181,32 @@ void JUCE_MultiFX_ProcessorAudioProcessor::setStateInformation (const void* data
 	auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
     if (tree.isValid())
     {
+        // Everything the audio thread needs is worked out here, before any parameter changes
+        ChainChange change;
+        change.type = ChainChange::Type::StateRestore;
+        change.snapshot = makeRestoredState(tree);
+        requestedDspOrder = change.snapshot.order;
+        allocateDelayRings(change.snapshot.order);
+
+        // If it has to wait, the audio thread follows the parameters as replaceState() sets them until it arrives
+        ++pendingStateRestores;
+        publishChainChange(change);
+
         apvts.replaceState(tree);
+        --pendingStateRestores;
 
-        if (apvts.state.hasProperty("dspOrder"))
-        {
-            auto order = juce::VariantConverter<JUCE_MultiFX_ProcessorAudioProcessor::DSP_Order>::fromVar(
-                apvts.state.getProperty("dspOrder"));
-            dspOrderFifo.push(order);
-			restoreDspOrderFifo.push(order);
-        }
-        DBG(apvts.state.toXmlString());
+        restoreSnapshots(apvts.state.getChildWithName("Snapshots"));
+        requestImpulseResponses();
 
 #if VERIFY_BYPASS_FUNCTIONALITY 
         juce::Timer::callAfterDelay(1000, [this]()
             {
                 DSP_Order dspOrder;
-                dspOrder.fill(DSP_Option::LadderFilter);
-                dspOrder[0] = DSP_Option::Overdrive;
+                dspOrder.add({ DSP_Option::Overdrive, 0 });
+                dspOrder.add({ DSP_Option::LadderFilter, 0 });
 
-                overdriveBypass->setValueNotifyingHost(1.f);
-                dspOrderFifo.push(dspOrder);
+                moduleParams[0].getBypass(DSP_Option::Overdrive)->setValueNotifyingHost(1.f);
+                setDspOrder(dspOrder);
             });
 #endif
 
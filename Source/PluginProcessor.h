@@ -11,23 +11,33 @@
 #include <JuceHeader.h>
 #include <Fifo.h>
 #include <SingleChannelSampleFifo.h>
+#include "SharedResources.h"
+#include "SnapshotMorpher.h"
+#include "ModulationMatrix.h"
+#include "LatencyCompensationDelay.h"
+#include "RingDelay.h"
+#include "ParameterRegistry.h"
+#include "ParameterEventList.h"
+#include "SimdKernels.h"
+#include "FixedRateConverter.h"
+#include "LinkwitzRileyCrossover.h"
+#include "ParametricEq.h"
+#include "LinearPhaseConvolver.h"
+#include "ConvolutionWorker.h"
+#include "TruePeakLimiter.h"
+#include "AudioTrace.h"
 
 static constexpr int NEGATIVE_INFINITY = -72;
 static constexpr int MAX_DECIBELS = 12;
 
-enum class GeneralFilterMode
-{
-    Peak,
-    Bandpass,
-    Notch,
-    Allpass,
-    END_OF_LIST
-};
-
 //==============================================================================
 /**
 */
-class JUCE_MultiFX_ProcessorAudioProcessor : public juce::AudioProcessor
+class JUCE_MultiFX_ProcessorAudioProcessor : public juce::AudioProcessor,
+    private juce::AudioProcessorValueTreeState::Listener,
+    private juce::AudioProcessorParameter::Listener,
+    private juce::AsyncUpdater,
+    private juce::Timer
 #if JucePlugin_Enable_ARA
     , public juce::AudioProcessorARAExtension
 #endif
@@ -47,6 +57,14 @@ public:
 
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
 
+    /*
+    Queues a timestamped change to a smoothed parameter for the next processBlock(),
+    for wrappers that can see the host's per-sample automation. Call it from the
+    audio thread, before processBlock(). Parameters with nothing queued follow
+    their current value, as JUCE hands automation over.
+    */
+    bool addParameterEvent(const juce::AudioProcessorParameter& param, int sampleOffset, float normalisedValue);
+
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
@@ -77,99 +95,511 @@ public:
         Overdrive,
         LadderFilter,
         GeneralFilter,
+        Delay,
+        Convolution,
         END_OF_LIST
     };
 
-    std::vector< juce::RangedAudioParameter*> getParamsForOption(DSP_Option option);
+    static constexpr size_t NumOptions = static_cast<size_t>(DSP_Option::END_OF_LIST);
+
+    // Each module can appear in the chain this many times, every instance has its own parameters
+    static constexpr int NumModuleInstances = 2;
+    static constexpr size_t MaxChainLength = 8;
+
+    // How many bands the crossovers can split the signal into, see Band Count
+    static constexpr int MaxBands = LinkwitzRileyCrossover::MaxBands;
+
+    struct ChainSlot
+    {
+        DSP_Option option = DSP_Option::END_OF_LIST;
+        int instance = 0;
+
+        // The band the module runs on. With fewer bands than that it runs on the last one
+        int band = 0;
+
+        bool operator==(const ChainSlot& other) const { return option == other.option && instance == other.instance && band == other.band; }
+        bool operator!=(const ChainSlot& other) const { return !(*this == other); }
+
+        // The same module instance, whatever band it runs on
+        bool isSameModule(const ChainSlot& other) const { return option == other.option && instance == other.instance; }
+    };
+
+    /*
+    The processing chain, up to MaxChainLength slots long. A module instance can
+    only be in the chain once, on one band, so each band's chain is the slots
+    that name it, in order. Fixed size, so it can go through a Fifo as is.
+    */
+    struct DSP_Order
+    {
+        size_t size() const { return length; }
+        bool empty() const { return length == 0; }
+        bool isFull() const { return length == MaxChainLength; }
+
+        const ChainSlot* begin() const { return slots.data(); }
+        const ChainSlot* end() const { return slots.data() + length; }
+        const ChainSlot& operator[](size_t index) const { jassert(index < length); return slots[index]; }
+
+        bool contains(ChainSlot slot) const { return std::any_of(begin(), end(), [slot](const ChainSlot& s) { return s.isSameModule(slot); }); }
+
+        // Returns false if the chain is full or the instance is already in it, on any band
+        bool add(ChainSlot slot)
+        {
+            if (isFull() || contains(slot))
+                return false;
+
+            slots[length++] = slot;
+            return true;
+        }
+
+        void remove(size_t index)
+        {
+            if (index >= length)
+                return;
+
+            std::copy(slots.begin() + static_cast<std::ptrdiff_t>(index) + 1,
+                      slots.begin() + static_cast<std::ptrdiff_t>(length),
+                      slots.begin() + static_cast<std::ptrdiff_t>(index));
+            slots[--length] = ChainSlot();
+        }
+
+        bool operator==(const DSP_Order& other) const { return length == other.length && std::equal(begin(), end(), other.begin()); }
+        bool operator!=(const DSP_Order& other) const { return !(*this == other); }
+
+    private:
+        std::array<ChainSlot, MaxChainLength> slots {};
+        size_t length = 0;
+    };
+
+    // The module's controls, its bypass is reached through getBypassParam()
+    const std::vector< juce::RangedAudioParameter*>& getParamsForOption(DSP_Option option, int instance) const;
+    juce::AudioParameterBool* getBypassParam(DSP_Option option, int instance) const;
 
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterlayout();
     juce::AudioProcessorValueTreeState apvts{ *this, nullptr, "Settings", createParameterlayout() };
 
-    using DSP_Order = std::array<DSP_Option, static_cast<size_t>(DSP_Option::END_OF_LIST)>;
-    SimpleMBComp::Fifo<DSP_Order> dspOrderFifo, restoreDspOrderFifo;
+    /*
+    Only the audio thread pushes restoreDspOrderFifo, whenever the order it
+    plays changes under the GUI. Orders go the other way through setDspOrder().
+    */
+    SimpleMBComp::Fifo<DSP_Order> restoreDspOrderFifo;
+
+    // Message thread. The order is saved with the state straight away, the audio thread picks it up next block
+    void setDspOrder(const DSP_Order& newOrder);
+
+    // Every module once, in DSP_Option order
+    static DSP_Order makeDefaultOrder();
 
     /*
-    Phaser:
-    Rate: hz
-    Depth: 0 to 1
-    Center freq: hz
-    Feedback: -1 to 1
-    Mix: 0 to 1
+    Saved orders store one int per slot: the option in the low byte, the
+    instance in the next and the band above them, so orders saved before
+    instances or bands existed read as instance 0 on band 0. Unknown and
+    repeated slots are dropped.
     */
+    static int encodeChainSlot(ChainSlot slot);
+    static DSP_Order decodeOrder(const std::vector<int>& storedOrder);
+
+    static constexpr int NumSnapshots = 4;
+    static constexpr int MaxSnapshotParams = 512;
+
+    /*
+    A complete copy of the parameter and DSP_Order state.
+    Values are normalised and indexed by parameter index, so a snapshot can be
+    handed to the audio thread through a Fifo without allocating.
+    */
+    struct Snapshot
+    {
+        std::array<float, MaxSnapshotParams> values {};
+        DSP_Order order {};
+        bool isValid = false;
+    };
 
+    // Snapshots and bank presets are managed on the message thread.
+    void storeSnapshot(int slot);
+    void recallSnapshot(int slot);
+    bool hasSnapshot(int slot) const;
+    int getActiveSnapshot() const { return activeSnapshot; }
 
+    juce::SharedResourcePointer<SharedPresetBank> presetBank;
+    void reloadPresetBank(const juce::File& bankFile);
+    bool loadPresetFromBank(int index);
+    bool savePresetToBank(const juce::String& name, const juce::StringArray& tags);
 
-    juce::AudioParameterFloat* phaserRateHz = nullptr;
-    juce::AudioParameterFloat* phaserDepthPercent = nullptr;
-    juce::AudioParameterFloat* phaserCenterFreqHz = nullptr;
-    juce::AudioParameterFloat* phaserFeedbackPercent = nullptr;
-    juce::AudioParameterFloat* phaserMixPercent = nullptr;
-    juce::AudioParameterBool* phaserBypass = nullptr;
+    /*
+    The convolution module's impulse response, a WAV file loaded and resampled in
+    the background. Stored in the session by path, an empty file unloads it.
+    Message thread only.
+    */
+    void loadImpulseResponse(int instance, const juce::File& file);
+    juce::File getImpulseResponseFile(int instance) const;
+
+    // Until this is false the chain may still run with the responses from before
+    bool isLoadingImpulseResponses() const { return convolutionWorker.hasPendingLoads(); }
+
+    enum class ModuleParam
+    {
+#define X(param, module, kind, id, name) param,
+        MODULAR_FX_MODULE_PARAMETERS(X)
+#undef X
+        END_OF_LIST
+    };
 
-    juce::AudioParameterFloat* chorusRateHz = nullptr;
-    juce::AudioParameterFloat* chorusDepthPercent = nullptr;
-    juce::AudioParameterFloat* chorusCenterDelayMs = nullptr;
-    juce::AudioParameterFloat* chorusFeedbackPercent = nullptr;
-    juce::AudioParameterFloat* chorusMixPercent = nullptr;
-    juce::AudioParameterBool* chorusBypass = nullptr;
+    static constexpr size_t NumModuleParams = static_cast<size_t>(ModuleParam::END_OF_LIST);
 
-    juce::AudioParameterFloat* overdriveSaturation = nullptr;
-    juce::AudioParameterBool* overdriveBypass = nullptr;
+    // Generated from ParameterRegistry.h, indexed by ModuleParam
+    static constexpr std::array<DSP_Option, NumModuleParams> moduleParamOwners
+    {
+#define X(param, module, kind, id, name) DSP_Option::module,
+        MODULAR_FX_MODULE_PARAMETERS(X)
+#undef X
+    };
 
-    juce::AudioParameterChoice* ladderFilterMode = nullptr;
-    juce::AudioParameterFloat* ladderFilterCutoffHz = nullptr;
-    juce::AudioParameterFloat* ladderFilterResonance = nullptr;
-    juce::AudioParameterFloat* ladderFilterDrive = nullptr;
-    juce::AudioParameterBool* ladderFilterBypass = nullptr;
+    static constexpr std::array<ModuleParamKind, NumModuleParams> moduleParamKinds
+    {
+#define X(param, module, kind, id, name) ModuleParamKind::kind,
+        MODULAR_FX_MODULE_PARAMETERS(X)
+#undef X
+    };
 
-    juce::AudioParameterChoice* generalFilterMode = nullptr;
-    juce::AudioParameterFloat* generalFilterFreqHz = nullptr;
-    juce::AudioParameterFloat* generalFilterQuality = nullptr;
-    juce::AudioParameterFloat* generalFilterGain = nullptr;
-    juce::AudioParameterBool* generalFilterBypass = nullptr;
+    static constexpr std::array<const char*, NumModuleParams> moduleParamIDs
+    {
+#define X(param, module, kind, id, name) id,
+        MODULAR_FX_MODULE_PARAMETERS(X)
+#undef X
+    };
+
+    static constexpr std::array<const char*, NumModuleParams> moduleParamNames
+    {
+#define X(param, module, kind, id, name) name,
+        MODULAR_FX_MODULE_PARAMETERS(X)
+#undef X
+    };
+
+    // The bypass of each module, indexed by DSP_Option
+    static constexpr std::array<ModuleParam, NumOptions> moduleBypassParams = []
+        {
+            std::array<ModuleParam, NumOptions> bypasses {};
+            for (size_t i = 0; i < NumModuleParams; ++i)
+            {
+                if (moduleParamKinds[i] == ModuleParamKind::Bypass)
+                    bypasses[static_cast<size_t>(moduleParamOwners[i])] = static_cast<ModuleParam>(i);
+            }
+            return bypasses;
+        }();
+
+    // The general filter's bands after the first have four rows each, in band order from GeneralFilterBand2Mode
+    enum class EqBandField
+    {
+        Mode,
+        Frequency,
+        Quality,
+        Gain,
+        END_OF_LIST
+    };
+
+    static constexpr ModuleParam getEqBandParam(int band, EqBandField field)
+    {
+        constexpr auto numFields = static_cast<int>(EqBandField::END_OF_LIST);
+        return static_cast<ModuleParam>(static_cast<int>(ModuleParam::GeneralFilterBand2Mode) + (band - 1) * numFields + static_cast<int>(field));
+    }
+
+    // Instance 0 uses the registry strings as they are, later instances are numbered after the module: "Phaser 2 Rate (Hz)"
+    static juce::String getModuleParamID(ModuleParam param, int instance);
+    static juce::String getModuleParamName(ModuleParam param, int instance);
+
+    struct ParameterInfo
+    {
+        juce::RangedAudioParameter* param = nullptr;
+        juce::SmoothedValue<float>* smoother = nullptr; // Only Float parameters are smoothed
+        const juce::NormalisableRange<float>* range = nullptr;
+        DSP_Option module = DSP_Option::END_OF_LIST;
+        int instance = 0;
+    };
+
+    // The parameters of one instance of every module, resolved once when the processor is built
+    struct ModuleParameters
+    {
+        const ParameterInfo& operator[](ModuleParam param) const { return registry[static_cast<size_t>(param)]; }
+
+        juce::RangedAudioParameter* get(ModuleParam param) const { return (*this)[param].param; }
+        float getSmoothedValue(ModuleParam param) const { return smoothers[static_cast<size_t>(param)].getCurrentValue(); }
+
+        juce::AudioParameterBool* getBypass(DSP_Option option) const;
+
+        // The module's controls without its bypass, in layout order
+        const std::vector<juce::RangedAudioParameter*>& getParamsForOption(DSP_Option option) const;
+
+        static constexpr size_t NumSmoothed = 24;
+        static constexpr size_t NumDelaySmoothed = 5; // The delay's smoothers come after the global ones
+
+        // Modules added since, every instance's go after all of the older targets
+        static constexpr size_t NumAppendedSmoothed = 2;
+
+        // The order of getParamsNeedingSmoothing(), which is also the modulation target order
+        static constexpr std::array<ModuleParam, NumSmoothed> smoothedOrder
+        {
+            ModuleParam::PhaserRate,
+            ModuleParam::PhaserDepth,
+            ModuleParam::PhaserCenterFreq,
+            ModuleParam::PhaserFeedback,
+            ModuleParam::PhaserMix,
+            ModuleParam::ChorusRate,
+            ModuleParam::ChorusDepth,
+            ModuleParam::ChorusCenterDelay,
+            ModuleParam::ChorusFeedback,
+            ModuleParam::ChorusMix,
+            ModuleParam::OverdriveSaturation,
+            ModuleParam::LadderFilterCutoff,
+            ModuleParam::LadderFilterResonance,
+            ModuleParam::LadderFilterDrive,
+            ModuleParam::GeneralFilterFreq,
+            ModuleParam::GeneralFilterQuality,
+            ModuleParam::GeneralFilterGain,
+            ModuleParam::DelayTime,
+            ModuleParam::DelayFeedback,
+            ModuleParam::DelayMix,
+            ModuleParam::DelayLowCut,
+            ModuleParam::DelayHighCut,
+            ModuleParam::ConvolutionMix,
+            ModuleParam::ConvolutionGain,
+        };
+
+        static void addToLayout(juce::AudioProcessorValueTreeState::ParameterLayout& layout, int instance, int versionHint);
+        void attach(juce::AudioProcessorValueTreeState& apvts, int instance);
+
+        std::array<juce::AudioParameterFloat*, NumSmoothed> getParamsNeedingSmoothing() const;
+        std::array<juce::SmoothedValue<float>*, NumSmoothed> getSmoothers();
+
+    private:
+        std::array<ParameterInfo, NumModuleParams> registry {};
+
+        // Indexed by ModuleParam, only the Float entries are used
+        std::array<juce::SmoothedValue<float>, NumModuleParams> smoothers;
+
+        std::array<std::vector<juce::RangedAudioParameter*>, NumOptions> controlsByOption;
+    };
+
+    std::array<ModuleParameters, NumModuleInstances> moduleParams;
 
 	juce::AudioParameterInt* selectedTab = nullptr;
 
     juce::AudioParameterFloat* inputGain = nullptr;
     juce::AudioParameterFloat* outputGain = nullptr;
 
+    // Whole-chain wet/dry, 100% is the chain output only
+    juce::AudioParameterFloat* mixPercent = nullptr;
+
+    juce::AudioParameterFloat* snapshotMorphTimeMs = nullptr;
+
+    // Sweeps the chain through the stored snapshots, A at 0 to the last stored slot at 1
+    juce::AudioParameterFloat* snapshotMorphPosition = nullptr;
+    juce::AudioParameterBool* snapshotMorphEnabled = nullptr;
+
+    // The rate the chain runs at, Host or one of the fixed rates. Not automatable
+    juce::AudioParameterChoice* internalRate = nullptr;
+
+    // What the two channels of the chain carry, see StereoMode
+    juce::AudioParameterChoice* stereoMode = nullptr;
+
+    // 1 runs the whole chain on the whole signal, more splits it and runs each band's slots on that band
+    juce::AudioParameterInt* bandCount = nullptr;
+    std::array<juce::AudioParameterFloat*, LinkwitzRileyCrossover::MaxSplits> crossoverFrequencies {};
+    std::array<juce::AudioParameterBool*, MaxBands> bandBypasses {};
+
+    // The true peak limiter on the output. Switching it restarts processing, it adds latency
+    juce::AudioParameterBool* limiterEnabled = nullptr;
+    juce::AudioParameterFloat* limiterCeiling = nullptr;
+    juce::AudioParameterFloat* limiterRelease = nullptr;
+
 	juce::SmoothedValue<float> 
-		phaserRateHzSmoother,
-		phaserDepthPercentSmoother,
-		phaserCenterFreqHzSmoother,
-		phaserFeedbackPercentSmoother,
-		phaserMixPercentSmoother,
-		chorusRateHzSmoother,
-		chorusDepthPercentSmoother,
-		chorusCenterDelayMsSmoother,
-		chorusFeedbackPercentSmoother,
-		chorusMixPercentSmoother,
-		overdriveSaturationSmoother,
-		ladderFilterCutoffHzSmoother,
-		ladderFilterResonanceSmoother,
-		ladderFilterDriveSmoother,
-		generalFilterFreqHzSmoother,
-		generalFilterQualitySmoother,
-		generalFilterGainSmoother,
 		inputGainSmoother,
-		outputGainSmoother;
+		outputGainSmoother,
+		mixPercentSmoother;
+
+    ModulationMatrix modulationMatrix;
 
 	juce::Atomic<bool> guiNeedsLatestDspOrder { false };
     
 	juce::Atomic<float> leftPreRMS, rightPreRMS, leftPostRMS, rightPostRMS;
 
-	SimpleMBComp::SingleChannelSampleFifo<juce::AudioBuffer<float>> leftSCSF{ SimpleMBComp::Channel::Left }, rightSCSF{ SimpleMBComp::Channel::Right };
+    // The limiter's deepest gain reduction over the last block, in dB at or below 0
+    juce::Atomic<float> limiterGainReduction { 0.f };
 
-    
+    /*
+    Since the last prepareToPlay(): the slowest callback as a fraction of the
+    time its samples last, how many realtime callbacks took longer than that,
+    and how many blocks were bigger than prepareToPlay() promised.
+    */
+    juce::Atomic<float> worstCallbackLoad { 0.f };
+    juce::Atomic<int> numCallbackOverruns { 0 }, numOversizeBlocks { 0 };
 
+	SimpleMBComp::SingleChannelSampleFifo<juce::AudioBuffer<float>> leftSCSF{ SimpleMBComp::Channel::Left }, rightSCSF{ SimpleMBComp::Channel::Right };
 
 private:
-    DSP_Order dspOrder;
+    // Only the audio thread touches dspOrder. requestedDspOrder is the message thread's copy
+    DSP_Order dspOrder, requestedDspOrder;
+
+    // Everything is sized for this many host samples, bigger blocks are processed in pieces of it
+    int maximumHostBlockSize = 0;
+    double hostSampleRate = 44100.0;
+
+    // The whole of processBlock() for one piece. Events queued past a piece that isn't the last wait for the next
+    void processHostBlock(juce::AudioBuffer<float>& hostBuffer, bool lastPiece);
+    void recordCallbackTime(juce::int64 startTicks, int numSamples);
+
+    // Off unless MODULARFX_TRACE is set. The bypasses are traced when they differ from the last sub-block's
+    AudioTrace trace;
+    int tracedBypassMask = -1;
+    void traceBypassChanges();
+
+    // The chain is processed in sub-blocks of at most this many samples
+    static constexpr int SubBlockSize = 64;
+
+    // Parameter events closer than this to a sub-block's start, or to each other, are applied together
+    static constexpr int MinSubBlockSize = 16;
+
+    // Updated from the playhead every block, used by the tempo synced delay
+    double hostBpm = 120.0;
+
+    // The summed tails of the active chain, refreshed every block for getTailLengthSeconds()
+    std::atomic<double> tailLengthSeconds { 0.0 };
+
+    // Linear gains reached at the end of the previous block, each block ramps on from there
+    float inputGainLinear = 1.f, outputGainLinear = 1.f;
+
+    /*
+    Converts to and from the internal rate when one is chosen. Everything between
+    the input and output gains runs at processingSampleRate, which is the host's
+    rate otherwise. A new choice takes effect the next time the host prepares.
+    */
+    FixedRateConverter fixedRate;
+    double processingSampleRate = 44100.0;
+
+    double getInternalRateHz() const;
+
+    // Only linear phase general filters add latency, in samples at the processing rate
+    static int getChainLatencySamples(int numLinearPhase) { return numLinearPhase * LinearPhaseKernel::LatencySamples; }
+    int getTotalLatencySamples(const FixedRateConverter& converter, int numLinearPhase, bool limiter) const;
+
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    void handleAsyncUpdate() override;
+
+    // The internal rate and the linear phase switches change the latency, the host restarts for them
+    std::atomic<bool> latencyChanged { false }, eqBandParamsChanged { false };
+
+    // Looked up by parameterChanged(), which can't allocate
+    const juce::StringArray latencyParamIDs { getLatencyParamIDs() };
+
+    /*
+    The general filter's bands after the first, designed on the message thread
+    whenever one of their parameters changes and handed to the audio thread
+    whole. The first band follows its smoothed parameters on the audio thread,
+    its coefficients here are only used for the linear phase kernel.
+    */
+    struct EqBandSet
+    {
+        double sampleRate = 0.0; // Sets designed for another rate are dropped
+        std::array<int, NumModuleInstances> numBands {};
+        std::array<std::array<ParametricEq::Coefficients, ParametricEq::MaxBands>, NumModuleInstances> coefficients {};
+        std::array<double, NumModuleInstances> tailSeconds {};
+    };
+
+    static juce::StringArray getLatencyParamIDs();
+    static juce::StringArray getEqBandParamIDs();
+    EqBandSet designEqBands(double sampleRate) const;
+
+    SimpleMBComp::Fifo<EqBandSet> eqBandsFifo;
+    EqBandSet eqBands, pulledEqBands;
+    std::atomic<double> eqBandsSampleRate { 0.0 };
+
+    // Bumped on the audio thread whenever eqBands changes, the channels compare it with their own copy
+    int eqBandsVersion = 0;
+
+    /*
+    Linear phase general filters, one kernel source per instance. The switches
+    are read when the host prepares, like the internal rate: the chain's
+    latency stays put until the next restart. An engaged instance always adds
+    its latency, chains without it in a slot make up for it with a delay.
+    */
+    std::array<LinearPhaseKernelExchange, NumModuleInstances> linearPhaseKernels;
+    std::array<bool, NumModuleInstances> linearPhaseEngaged {};
+    int numLinearPhaseEngaged = 0;
+
+    bool isLinearPhaseSwitchedOn(int instance) const;
+    int countLinearPhaseSwitches() const;
+
+    // Message thread, for the instances switched on
+    void designLinearPhaseKernels(const EqBandSet& set);
+
+    /*
+    The convolution modules' impulse responses, one setup per instance shared by
+    every channel. The worker builds and frees them, the audio thread swaps a new
+    one in at the start of a block and retires the one it replaced.
+    */
+    ConvolutionWorker convolutionWorker { NumChains };
+    std::array<ConvolutionSetup*, NumModuleInstances> activeConvolutions {};
+
+    void requestImpulseResponses();
+    void updateConvolutions();
+
+    /*
+    The delay modules' rings, one block per instance split between the channels.
+    The message thread allocates an instance's block before handing over any
+    order with that instance in it, so delays that are never used cost nothing.
+    Blocks are only replaced in prepareToPlay(), when nothing reads them.
+    */
+    juce::CriticalSection delayRingLock;
+    std::array<bool, NumModuleInstances> delayRingsRequested {};
+    std::array<std::unique_ptr<float[]>, NumModuleInstances> delayRingMemory;
+    int delayRingSize = 0; // Per channel, set in prepareToPlay()
+
+    std::array<std::atomic<float*>, NumModuleInstances> delayRings {};
+    std::array<float*, NumModuleInstances> activeDelayRings {}; // The audio thread's copy
+
+    // Message thread, before the order reaches the audio thread
+    void allocateDelayRings(const DSP_Order& order);
+    void prepareDelayRings(double sampleRate);
+
+    float* getDelayRing(int instance, int chainIndex) const;
+    void updateDelayRings();
+
+    // Runs at the host's rate after the output gain. Read when the host prepares, like the linear phase switches
+    TruePeakLimiter outputLimiter;
+    bool limiterEngaged = false;
+
+    static void applyGainRamp(const juce::dsp::AudioBlock<float>& block, float& currentGain, float targetDecibels);
+
+    /*
+    The gain ramp with the first two channels replaced by their sum and difference,
+    times scale. 0.5 encodes L/R to M/S, 1 decodes it again.
+    */
+    static void applyGainRampSumDifference(const juce::dsp::AudioBlock<float>& block, float& currentGain, float targetDecibels, float scale);
+
+    /*
+    L/R runs the chain on each side, Mid/Side on the mid and side signals. Mid Only
+    and Side Only run one channel's chain and pass the other signal through, for
+    half the work.
+    */
+    enum class StereoMode
+    {
+        LeftRight,
+        MidSide,
+        MidOnly,
+        SideOnly,
+        END_OF_LIST
+    };
+
+    // The mode the channels were last set up for, a change resets them
+    StereoMode activeStereoMode = StereoMode::LeftRight;
 
-	juce::dsp::Gain<float> inputGainDSP, outputGainDSP;
+    void updateStereoMode();
+    static float getRMSLevel(const juce::AudioBuffer<float>& buffer, int channel, int numSamples);
 
+    /*
+    ProcessorBase is only used to prepare and reset the modules. The chain itself
+    calls the concrete modules through MonoChannelDSP::processModule().
+    */
     template<typename DSP>
-    struct DSP_Choice : juce::dsp::ProcessorBase
+    struct DSP_Choice final : juce::dsp::ProcessorBase
     {
         void prepare(const juce::dsp::ProcessSpec& spec) override
         {
@@ -190,35 +620,133 @@ private:
     struct MonoChannelDSP
     {
 		MonoChannelDSP(JUCE_MultiFX_ProcessorAudioProcessor& proc) : p(proc) {}
-        DSP_Choice<juce::dsp::DelayLine<float>> delay;
-        DSP_Choice<juce::dsp::Phaser<float>> phaser;
-        DSP_Choice<juce::dsp::Chorus<float>> chorus;
-        DSP_Choice<juce::dsp::LadderFilter<float>> overdrive, ladderFilter;
-        DSP_Choice<juce::dsp::IIR::Filter<float>> generalFilter;
+
+        // One instance of every module, with the state that belongs to it
+        struct alignas(64) ModuleSet
+        {
+            DSP_Choice<RingDelay> delay;
+            DSP_Choice<juce::dsp::Phaser<float>> phaser;
+            DSP_Choice<juce::dsp::Chorus<float>> chorus;
+            DSP_Choice<juce::dsp::LadderFilter<float>> overdrive, ladderFilter;
+            DSP_Choice<ParametricEq> generalFilter;
+
+            // Replaces generalFilter in the chain while linearPhase is set, only allocated then
+            DSP_Choice<LinearPhaseConvolver> linearPhaseFilter;
+            bool linearPhase = false;
+
+            DSP_Choice<PartitionedConvolver> convolution;
+
+            // The first band's parameters as last designed, and the eqBandsVersion the other bands came from
+            GeneralFilterMode filterMode = GeneralFilterMode::END_OF_LIST;
+            float filterFreq = 0.f, filterQ = 0.f, filterGain = -100.f;
+            int filterBandsVersion = -1;
+
+            // Bypass flips crossfade between the dry and processed signal over one sub-block
+            std::array<bool, NumOptions> wasBypassed {};
+
+            /*
+            How long each module keeps ringing after its input stops, estimated from
+            the current parameters. A module whose input has been silent for longer
+            than that is reset and skipped until sound arrives again.
+            */
+            std::array<int, NumOptions> tailSamples {};
+            std::array<int, NumOptions> silentSamples {};
+            std::array<bool, NumOptions> asleep {};
+        };
+
+        // Below this the input counts as silence, about -100 dBFS
+        static constexpr float SilenceThreshold = 1.0e-5f;
+
+        // Covers the parameter ramps inside the JUCE modules, which outlast a silent input too
+        static constexpr double MinTailSeconds = 0.05;
 
         void prepare(const juce::dsp::ProcessSpec& spec);
 
-        void updateDSPFromParams();
+        // Clears every module of every instance, for a channel that starts carrying a different signal
+        void reset();
+
+        // Clears only the modules the order uses, for a band that starts running again
+        void resetModules(const DSP_Order& order);
+
+        // Pairs the delays of two channels for ping-pong
+        void setPartner(MonoChannelDSP* newPartner) { partner = newPartner; }
+
+        // Where the channel sits in channels, picks its convolution tail state and response side
+        void setChainIndex(int newChainIndex) { chainIndex = newChainIndex; }
+        void setConvolution(int instance, ConvolutionSetup* setup) { getModules(instance).convolution.dsp.setSetup(setup, chainIndex); }
+        void updateDelayRing(int instance) { getModules(instance).delay.dsp.setRing(p.getDelayRing(instance, chainIndex)); }
+
+        // Only the instances dspOrder uses, the others are brought up to date when a slot brings them in
+        void updateDSPFromParams(const DSP_Order& dspOrder);
 
-		void process(juce::dsp::AudioBlock<float> block, const DSP_Order& dspOrder);
+        // Runs one band's chain, the band picks the linear phase pad
+		void process(juce::dsp::AudioBlock<float> block, const DSP_Order& dspOrder, int band);
+
+        // For a channel or band left out of processing, only delays it to line up with the ones that run
+        void processLatencyOnly(juce::dsp::AudioBlock<float> block, int band) { applyLinearPhasePad(block, band, 0); }
+
+        // Every module in the order bypassed and done fading out, so running it would only copy the input
+        bool isBypassedThroughout(const DSP_Order& dspOrder);
+
+        ModuleSet& getModules(int instance)
+        {
+            jassert(modulePool != nullptr && juce::isPositiveAndBelow(instance, NumModuleInstances));
+            return modulePool[static_cast<size_t>(instance)];
+        }
 
 	private:
         JUCE_MultiFX_ProcessorAudioProcessor& p;
+        MonoChannelDSP* partner = nullptr;
+        int chainIndex = 0;
 
-        GeneralFilterMode filterMode = GeneralFilterMode::END_OF_LIST;
-		float filterFreq = 0.f, filterQ = 0.f, filterGain = -100.f;
-    };
+        /*
+        Every instance a chain slot can refer to, allocated by the first prepare().
+        Adding or removing a slot only changes the DSP_Order, the modules stay put.
+        */
+        std::unique_ptr<ModuleSet[]> modulePool;
+        juce::AudioBuffer<float> crossfadeBuffer;
 
-	MonoChannelDSP leftChannel { *this };
-	MonoChannelDSP rightChannel { *this };
+        // Delays each band's chain for the engaged linear phase filters it has no slot for
+        std::array<LatencyCompensationDelay, MaxBands> linearPhasePads;
 
-    struct ProcessState
-    {
-		juce::dsp::ProcessorBase* processor = nullptr;
-		bool bypassed = false;
+        void applyLinearPhasePad(const juce::dsp::AudioBlock<float>& block, int band, int numLinearPhase);
+
+        void updateModules(ModuleSet& modules, const ModuleParameters& params, int instance);
+
+        // Returns true while the module sleeps, the input then passes through untouched
+        bool updateSleepState(ModuleSet& modules, ChainSlot slot, const juce::dsp::AudioBlock<float>& input);
+        static void resetModule(ModuleSet& modules, DSP_Option option);
+
+        void processWithBypassCrossfade(ModuleSet& modules,
+                                        DSP_Option option,
+                                        const juce::dsp::ProcessContextReplacing<float>& context,
+                                        bool fadeToBypassed);
+
+        // A switch over the concrete modules rather than a table of pointers, so each call can inline
+        static void processModule(DSP_Option option, ModuleSet& modules, const juce::dsp::ProcessContextReplacing<float>& context);
     };
 
-	using DSP_Pointers = std::array<ProcessState, static_cast<size_t>(DSP_Option::END_OF_LIST)>;
+    // Left and right, or mid and side. A module is on one band only, so the bands share the channels' modules
+    static constexpr int NumChains = 2;
+    std::array<MonoChannelDSP, NumChains> channels { *this, *this };
+
+    LinkwitzRileyCrossover crossover;
+    int activeNumBands = 0;
+
+    // dspOrder split by band, slots past the band count on the last one. Rebuilt every block
+    std::array<DSP_Order, MaxBands> bandOrders {};
+
+    // The slots of the bands that are processed, the only modules brought up to date
+    DSP_Order processedOrder {};
+
+    /*
+    bandRunning follows the band count and the band bypasses. A running band is
+    only processed if its chain would change the signal, when every band is
+    left out the split is skipped too. Both are decided once per block.
+    */
+    std::array<bool, MaxBands> bandRunning {}, bandProcessed {};
+
+    void updateBands();
 
 #define VERIFY_BYPASS_FUNCTIONALITY false
 
@@ -233,7 +761,10 @@ private:
         }
     }
 
-    std::vector<juce::SmoothedValue<float>*> getSmoothers();
+    static constexpr size_t NumSmoothedParams = 3 + ModuleParameters::NumSmoothed * NumModuleInstances;
+
+    std::array<juce::SmoothedValue<float>*, NumSmoothedParams> getSmoothers();
+    std::array<juce::AudioParameterFloat*, NumSmoothedParams> getParamsNeedingSmoothing() const;
 
     enum class SmootherUpdateMode
     {
@@ -243,6 +774,165 @@ private:
 
     void updateSmoothersFromParams(int numSamplesToSkip, SmootherUpdateMode init);
 
+    /*
+    The value each smoothed parameter heads for, in getParamsNeedingSmoothing()
+    order. A parameter follows its own value every sub-block, unless events are
+    queued for it this block, in which case it follows them.
+    */
+    std::array<float, NumSmoothedParams> automatedTargets {};
+    std::array<bool, NumSmoothedParams> hasQueuedEvents {};
+
+    ParameterEventList<1024> parameterEvents;
+
+    // offset is in samples at the processing rate, from the start of the current piece
+    bool queueParameterEvent(size_t target, int offset, float value);
+
+    /*
+    The shim for JUCE's wrappers, which only set parameters. A change that arrives
+    on the audio thread is queued at the point processing has reached: the start
+    of the block when the wrapper sets it before processBlock(), the end of the
+    current sub-block when it arrives while one runs. Changes from other threads
+    are picked up by the next sub-block, as before.
+    */
+    void parameterValueChanged(int parameterIndex, float newValue) override;
+    void parameterGestureChanged(int, bool) override {}
+
+    std::atomic<juce::Thread::ThreadID> audioThreadId { nullptr };
+    int liveEventOffset = 0;
+
+    // getParamsNeedingSmoothing() index of each parameter index, or -1
+    std::array<int, MaxSnapshotParams> smoothedParamIndices {};
+
+    // Normalised offsets from the modulation matrix, in getParamsNeedingSmoothing() order
+    std::array<float, NumSmoothedParams> modulationOffsets {};
+    bool isModulating = false;
+
+    // The dry side of the mix, delayed by the chain's latency so both sides line up
+    LatencyCompensationDelay dryDelay;
+    juce::AudioBuffer<float> dryBuffer;
+
+    void mixDrySignal(const juce::dsp::AudioBlock<float>& wet, float startMix, float endMix);
+
+    std::array<Snapshot, NumSnapshots> snapshots;
+    int activeSnapshot = 0;
+    int currentProgram = 0;
+
+    Snapshot captureSnapshot() const;
+    void applySnapshot(const Snapshot& snapshot);
+    bool isSnapshotParameter(const juce::AudioProcessorParameter* param) const;
+    void restoreSnapshots(const juce::ValueTree& snapshotsTree);
+
+    /*
+    Order changes, snapshot recalls and restored states reach the audio thread
+    through one queue, so it applies them in the order the message thread made
+    them. A change the queue has no room for waits in pendingChainChanges, and
+    goes ahead of the next change or when the timer retries it. A waiting
+    change that a later one overrides is dropped, so no more than three wait.
+    */
+    struct ChainChange
+    {
+        enum class Type
+        {
+            Order,
+            SnapshotRecall,
+            StateRestore
+        };
+
+        Type type = Type::Order;
+        Snapshot snapshot; // For an Order only snapshot.order is used
+    };
+
+    SimpleMBComp::Fifo<ChainChange> chainChangeFifo;
+    ChainChange pulledChainChange;
+    std::vector<ChainChange> pendingChainChanges;
+
+    // Message thread
+    void publishChainChange(const ChainChange& change);
+    bool flushChainChanges();
+    void timerCallback() override;
+
+    // Audio thread, returns true if a restored state arrived
+    bool applyChainChanges();
+
+    /*
+    Crossfades the smoother targets from where they were when a snapshot was
+    recalled to the snapshot's values, so the switch doesn't glitch. The
+    snapshot's order is not morphed: it takes over at the start of the next
+    block, the same as setDspOrder(), so a recall that reorders or swaps
+    modules can click. Modules it adds start from their reset state.
+    */
+    struct SnapshotMorph
+    {
+        std::array<float, NumSmoothedParams> from {}, to {};
+        int samplesRemaining = 0;
+        int totalSamples = 0;
+    };
+
+    SnapshotMorph snapshotMorph;
+
+    void beginSnapshotMorph(const Snapshot& snapshot);
+
+    /*
+    setStateInformation() builds the whole state as a Snapshot before it
+    touches a parameter, and hands it to the audio thread in one piece as a
+    ChainChange. The audio thread plays the restored values and order from
+    then on, rather than parameters replaceState() has only got halfway
+    through, until pendingStateRestores says the parameters have all caught up.
+    */
+    Snapshot restoredState;
+    std::atomic<int> pendingStateRestores { 0 };
+    bool holdingRestoredState = false;
+
+    Snapshot makeRestoredState(const juce::ValueTree& tree) const;
+    void adoptRestoredState();
+
+    /*
+    Choice and bool parameters can't be smoothed, so the audio thread reads them
+    from here. They follow the parameters, or the morph engine when it's active.
+    Every module instance has the whole set.
+    */
+    enum class DiscreteParam
+    {
+        LadderFilterMode,
+        GeneralFilterMode,
+        PhaserBypass,
+        ChorusBypass,
+        OverdriveBypass,
+        LadderFilterBypass,
+        GeneralFilterBypass,
+        DelaySync,
+        DelayNote,
+        DelayPingPong,
+        DelayBypass,
+        ConvolutionBypass,
+        END_OF_LIST
+    };
+
+    static constexpr size_t NumDiscreteParamsPerInstance = static_cast<size_t>(DiscreteParam::END_OF_LIST);
+    static constexpr size_t NumDiscreteParams = NumDiscreteParamsPerInstance * NumModuleInstances;
+
+    std::array<juce::RangedAudioParameter*, NumDiscreteParams> getDiscreteParams() const;
+    std::array<float, NumDiscreteParams> discreteValues {};
+
+    int getDiscreteIndex(DiscreteParam param, int instance) const
+    {
+        return juce::roundToInt(discreteValues[static_cast<size_t>(instance) * NumDiscreteParamsPerInstance + static_cast<size_t>(param)]);
+    }
+
+    bool isOptionBypassed(DSP_Option option, int instance) const;
+    void updateDiscreteValues();
+
+    using Morpher = SnapshotMorpher<NumSmoothedParams, NumDiscreteParams, static_cast<size_t>(NumSnapshots)>;
+    Morpher snapshotMorpher;
+    SimpleMBComp::Fifo<Morpher::States> morphStatesFifo;
+    Morpher::States pulledMorphStates;
+    std::array<float, NumSmoothedParams> morphTargets {};
+    std::array<float, NumDiscreteParams> morphDiscreteTargets {};
+    bool morphEngineDrivingParams = false;
+
+    bool isMorphEngineActive() const;
+    void publishMorphStates();
+
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (JUCE_MultiFX_ProcessorAudioProcessor)
 };
@@ -0,0 +1,288 @@
+/*
+  ==============================================================================
+
+    PresetBank.cpp
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+
+static juce::String readFixedString(const char* src, int maxLength)
+{
+    auto length = 0;
+    while (length < maxLength && src[length] != 0)
+        ++length;
+
+    return juce::String::fromUTF8(src, length);
+}
+
+static void writeFixedString(juce::OutputStream& out, const juce::String& s, int maxLength)
+{
+    std::vector<char> padded(static_cast<size_t>(maxLength), 0);
+    auto* utf8 = s.toRawUTF8();
+    // leave room for the terminator, the reader relies on it for full-length strings
+    std::strncpy(padded.data(), utf8, static_cast<size_t>(maxLength - 1));
+    out.write(padded.data(), padded.size());
+}
+
+static juce::String normaliseTag(const juce::String& tag)
+{
+    return tag.trim().toLowerCase();
+}
+
+//==============================================================================
+juce::uint32 PresetBank::computeRecordSize(juce::uint32 numColumns, juce::uint32 orderLength)
+{
+    return static_cast<juce::uint32>(MaxNameLength + MaxTagsLength)
+        + numColumns * static_cast<juce::uint32>(sizeof(float))
+        + orderLength * static_cast<juce::uint32>(sizeof(juce::int32));
+}
+
+bool PresetBank::load(const juce::File& file, const ParameterIndexLookup& lookup)
+{
+    unload();
+
+    if (file.existsAsFile() == false)
+        return false;
+
+    auto mapped = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+    auto* data = static_cast<const char*>(mapped->getData());
+    auto size = mapped->getSize();
+
+    if (data == nullptr || size < sizeof(Header))
+        return false;
+
+    Header h;
+    std::memcpy(&h, data, sizeof(Header));
+
+    if (std::memcmp(h.magic, Header().magic, sizeof(h.magic)) != 0 || h.version > CurrentVersion)
+    {
+        jassertfalse; // Not a bank file, or written by a newer build
+        return false;
+    }
+
+    auto expectedSize = sizeof(Header)
+        + static_cast<size_t>(h.numColumns) * MaxIdLength
+        + static_cast<size_t>(h.numPresets) * h.recordSize;
+
+    if (h.recordSize != computeRecordSize(h.numColumns, h.orderLength) || size < expectedSize)
+    {
+        jassertfalse; // Truncated or corrupt bank
+        return false;
+    }
+
+    bankFile = file;
+    header = h;
+    mappedFile = std::move(mapped);
+
+    auto* columns = getColumnTable();
+    columnToParamIndex.resize(header.numColumns);
+    for (juce::uint32 c = 0; c < header.numColumns; ++c)
+    {
+        auto id = readFixedString(columns + c * MaxIdLength, MaxIdLength);
+        columnToParamIndex[c] = lookup != nullptr ? lookup(id) : -1;
+    }
+
+    for (int i = 0; i < getNumPresets(); ++i)
+    {
+        nameIndex[getPresetName(i)] = i;
+        for (const auto& tag : getPresetTags(i))
+            tagIndex[normaliseTag(tag)].add(i);
+    }
+
+    return true;
+}
+
+void PresetBank::unload()
+{
+    mappedFile.reset();
+    header = Header();
+    bankFile = juce::File();
+    columnToParamIndex.clear();
+    nameIndex.clear();
+    tagIndex.clear();
+}
+
+const char* PresetBank::getColumnTable() const
+{
+    jassert(mappedFile != nullptr);
+    return static_cast<const char*>(mappedFile->getData()) + sizeof(Header);
+}
+
+const char* PresetBank::getRecord(int index) const
+{
+    if (mappedFile == nullptr || juce::isPositiveAndBelow(index, getNumPresets()) == false)
+        return nullptr;
+
+    return getColumnTable()
+        + static_cast<size_t>(header.numColumns) * MaxIdLength
+        + static_cast<size_t>(index) * header.recordSize;
+}
+
+juce::String PresetBank::getPresetName(int index) const
+{
+    if (auto* record = getRecord(index))
+        return readFixedString(record, MaxNameLength);
+
+    return {};
+}
+
+juce::StringArray PresetBank::getPresetTags(int index) const
+{
+    juce::StringArray tags;
+    if (auto* record = getRecord(index))
+    {
+        tags.addTokens(readFixedString(record + MaxNameLength, MaxTagsLength), ",", "");
+        tags.trim();
+        tags.removeEmptyStrings();
+    }
+    return tags;
+}
+
+int PresetBank::findPreset(const juce::String& name) const
+{
+    auto it = nameIndex.find(name);
+    return it != nameIndex.end() ? it->second : -1;
+}
+
+juce::Array<int> PresetBank::findPresetsWithTag(const juce::String& tag) const
+{
+    auto it = tagIndex.find(normaliseTag(tag));
+    return it != tagIndex.end() ? it->second : juce::Array<int>();
+}
+
+juce::StringArray PresetBank::getAllTags() const
+{
+    juce::StringArray tags;
+    for (const auto& [tag, presets] : tagIndex)
+        tags.add(tag);
+    return tags;
+}
+
+bool PresetBank::readValues(int index, float* destValuesByParamIndex, int numDestValues) const
+{
+    auto* record = getRecord(index);
+    if (record == nullptr)
+        return false;
+
+    auto* values = record + MaxNameLength + MaxTagsLength;
+    for (juce::uint32 c = 0; c < header.numColumns; ++c)
+    {
+        auto paramIndex = columnToParamIndex[c];
+        if (juce::isPositiveAndBelow(paramIndex, numDestValues))
+            std::memcpy(destValuesByParamIndex + paramIndex, values + c * sizeof(float), sizeof(float));
+    }
+
+    return true;
+}
+
+bool PresetBank::readOrder(int index, int* destOrder, int numDestOrder) const
+{
+    auto* record = getRecord(index);
+    if (record == nullptr)
+        return false;
+
+    auto* order = record + MaxNameLength + MaxTagsLength + header.numColumns * sizeof(float);
+    auto numToRead = juce::jmin(numDestOrder, getOrderLength());
+    for (int i = 0; i < numToRead; ++i)
+    {
+        juce::int32 v;
+        std::memcpy(&v, order + static_cast<size_t>(i) * sizeof(juce::int32), sizeof(v));
+        destOrder[i] = v;
+    }
+
+    return numToRead == numDestOrder;
+}
+
+juce::StringArray PresetBank::getColumnIDs() const
+{
+    juce::StringArray ids;
+    if (mappedFile != nullptr)
+    {
+        auto* columns = getColumnTable();
+        for (juce::uint32 c = 0; c < header.numColumns; ++c)
+            ids.add(readFixedString(columns + c * MaxIdLength, MaxIdLength));
+    }
+    return ids;
+}
+
+PresetBank::Entry PresetBank::readEntry(int index) const
+{
+    Entry entry;
+    auto* record = getRecord(index);
+    if (record == nullptr)
+        return entry;
+
+    entry.name = getPresetName(index);
+    entry.tags = getPresetTags(index);
+
+    entry.values.resize(header.numColumns);
+    std::memcpy(entry.values.data(), record + MaxNameLength + MaxTagsLength, header.numColumns * sizeof(float));
+
+    entry.order.resize(header.orderLength);
+    auto* order = record + MaxNameLength + MaxTagsLength + header.numColumns * sizeof(float);
+    for (juce::uint32 i = 0; i < header.orderLength; ++i)
+    {
+        juce::int32 v;
+        std::memcpy(&v, order + i * sizeof(juce::int32), sizeof(v));
+        entry.order[i] = v;
+    }
+
+    return entry;
+}
+
+bool PresetBank::write(const juce::File& file,
+                       const juce::StringArray& columnIDs,
+                       int orderLength,
+                       const std::vector<Entry>& entries)
+{
+    file.getParentDirectory().createDirectory();
+
+    // Write next to the destination and swap in, so a mapped reader never sees a half written bank
+    auto temp = file.getSiblingFile(file.getFileName() + ".tmp");
+    temp.deleteFile();
+
+    {
+        juce::FileOutputStream out(temp);
+        if (out.openedOk() == false)
+            return false;
+
+        Header h;
+        h.numPresets = static_cast<juce::uint32>(entries.size());
+        h.numColumns = static_cast<juce::uint32>(columnIDs.size());
+        h.orderLength = static_cast<juce::uint32>(orderLength);
+        h.recordSize = computeRecordSize(h.numColumns, h.orderLength);
+        out.write(&h, sizeof(Header));
+
+        for (const auto& id : columnIDs)
+            writeFixedString(out, id, MaxIdLength);
+
+        for (const auto& entry : entries)
+        {
+            jassert(entry.values.size() == static_cast<size_t>(columnIDs.size()));
+            jassert(entry.order.size() == static_cast<size_t>(orderLength));
+
+            writeFixedString(out, entry.name, MaxNameLength);
+            writeFixedString(out, entry.tags.joinIntoString(","), MaxTagsLength);
+
+            for (int c = 0; c < columnIDs.size(); ++c)
+                out.writeFloat(c < static_cast<int>(entry.values.size()) ? entry.values[static_cast<size_t>(c)] : 0.f);
+
+            for (int i = 0; i < orderLength; ++i)
+                out.writeInt(i < static_cast<int>(entry.order.size()) ? entry.order[static_cast<size_t>(i)] : 0);
+        }
+
+        out.flush();
+    }
+
+    return temp.moveFileTo(file);
+}
+
+juce::File PresetBank::getDefaultBankFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("R.L. Audio")
+        .getChildFile("ModularFX")
+        .getChildFile("Presets.mfxbank");
+}
@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+
+    On-disk preset bank. The bank file is memory-mapped read-only and indexed
+    by preset name and tag, so browsing and recalling presets never parses the
+    whole file.
+
+    Layout (little endian, all sections 4-byte aligned):
+        Header
+        Column table  : numColumns x char[MaxIdLength]     (parameter IDs)
+        Records       : numPresets x Record
+
+        Record        : char name[MaxNameLength]
+                        char tags[MaxTagsLength]           (comma separated)
+                        float values[numColumns]           (normalised 0..1)
+                        int32 order[orderLength]           (chain slots, -1 when unused)
+
+    Values are stored against parameter IDs rather than parameter indices so a
+    bank written by an older build still loads after parameters are added.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct PresetBank
+{
+    static constexpr int MaxIdLength = 64;
+    static constexpr int MaxNameLength = 64;
+    static constexpr int MaxTagsLength = 64;
+    static constexpr juce::uint32 CurrentVersion = 1;
+
+    struct Entry
+    {
+        juce::String name;
+        juce::StringArray tags;
+        std::vector<float> values;      // one per column, normalised
+        std::vector<int> order;
+    };
+
+    // Maps a stored parameter ID to the index of the parameter in the processor, or -1 if unknown.
+    using ParameterIndexLookup = std::function<int(const juce::String& paramID)>;
+
+    bool load(const juce::File& file, const ParameterIndexLookup& lookup);
+    void unload();
+
+    bool isLoaded() const { return mappedFile != nullptr; }
+    const juce::File& getFile() const { return bankFile; }
+
+    int getNumPresets() const { return static_cast<int>(header.numPresets); }
+    int getOrderLength() const { return static_cast<int>(header.orderLength); }
+
+    juce::String getPresetName(int index) const;
+    juce::StringArray getPresetTags(int index) const;
+
+    int findPreset(const juce::String& name) const;
+    juce::Array<int> findPresetsWithTag(const juce::String& tag) const;
+    juce::StringArray getAllTags() const;
+
+    /*
+    Copies the stored values of a preset into a flat array indexed by processor parameter index.
+    Parameters unknown to the bank are left untouched, so callers should pre-fill the array
+    with the current values. Returns false if the index is out of range.
+    */
+    bool readValues(int index, float* destValuesByParamIndex, int numDestValues) const;
+    bool readOrder(int index, int* destOrder, int numDestOrder) const;
+
+    Entry readEntry(int index) const;
+    juce::StringArray getColumnIDs() const;
+
+    static bool write(const juce::File& file,
+                      const juce::StringArray& columnIDs,
+                      int orderLength,
+                      const std::vector<Entry>& entries);
+
+    static juce::File getDefaultBankFile();
+
+private:
+    struct Header
+    {
+        char magic[4] { 'M', 'F', 'X', 'B' };
+        juce::uint32 version = CurrentVersion;
+        juce::uint32 numPresets = 0;
+        juce::uint32 numColumns = 0;
+        juce::uint32 orderLength = 0;
+        juce::uint32 recordSize = 0;
+    };
+
+    static juce::uint32 computeRecordSize(juce::uint32 numColumns, juce::uint32 orderLength);
+    const char* getRecord(int index) const;
+    const char* getColumnTable() const;
+
+    juce::File bankFile;
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    Header header;
+
+    std::vector<int> columnToParamIndex;
+    std::map<juce::String, int> nameIndex;
+    std::map<juce::String, juce::Array<int>> tagIndex;
+};
@@ -0,0 +1,143 @@
+/*
+  ==============================================================================
+
+    RingDelay.cpp
+
+  ==============================================================================
+*/
+
+#include "RingDelay.h"
+
+int RingDelay::getRingSize(double sampleRate)
+{
+    // Room for the longest delay plus the interpolation neighbour
+    return juce::nextPowerOfTwo(static_cast<int>(std::ceil(MaxDelaySeconds * sampleRate)) + 2);
+}
+
+void RingDelay::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.numChannels == 1); // One instance per channel, like the other modules
+
+    sampleRate = spec.sampleRate;
+    maxDelaySamples = static_cast<float>(MaxDelaySeconds * sampleRate);
+    mask = getRingSize(sampleRate) - 1;
+
+    delaySamples.reset(sampleRate, 0.05);
+    delaySamples.setCurrentAndTargetValue(juce::jlimit(minDelaySamples, maxDelaySamples, delaySamples.getTargetValue()));
+
+    reset();
+}
+
+void RingDelay::reset()
+{
+    writeIndex = 0;
+    samplesSinceReset = 0;
+    lowCutState = 0.f;
+    highCutState = 0.f;
+    delaySamples.setCurrentAndTargetValue(delaySamples.getTargetValue());
+}
+
+void RingDelay::setDelayMs(float newDelayMs)
+{
+    auto samples = static_cast<float>(newDelayMs * 0.001 * sampleRate);
+    delaySamples.setTargetValue(juce::jlimit(minDelaySamples, maxDelaySamples, samples));
+}
+
+void RingDelay::setFeedback(float newFeedback)
+{
+    feedback = juce::jlimit(0.f, 0.99f, newFeedback);
+}
+
+void RingDelay::setMix(float newMix)
+{
+    mix = juce::jlimit(0.f, 1.f, newMix);
+}
+
+void RingDelay::setLowCutHz(float newLowCutHz)
+{
+    lowCutCoefficient = getOnePoleCoefficient(newLowCutHz, sampleRate);
+}
+
+void RingDelay::setHighCutHz(float newHighCutHz)
+{
+    highCutCoefficient = getOnePoleCoefficient(newHighCutHz, sampleRate);
+}
+
+void RingDelay::setPingPongPartner(const RingDelay* newPartner, int minimumDelaySamples)
+{
+    jassert(newPartner != this);
+    jassert(newPartner == nullptr || newPartner->mask == mask); // Both sides must be prepared alike
+
+    partner = newPartner;
+
+    // One extra sample for the interpolation neighbour
+    minDelaySamples = partner != nullptr ? static_cast<float>(minimumDelaySamples + 1) : 1.f;
+    delaySamples.setTargetValue(juce::jlimit(minDelaySamples, maxDelaySamples, delaySamples.getTargetValue()));
+}
+
+void RingDelay::setRing(float* newRing)
+{
+    if (newRing == ring)
+        return;
+
+    ring = newRing;
+    writeIndex = 0;
+    samplesSinceReset = 0;
+    lowCutState = 0.f;
+    highCutState = 0.f;
+}
+
+float RingDelay::getOnePoleCoefficient(float cutoffHz, double sampleRate)
+{
+    auto nyquist = static_cast<float>(sampleRate * 0.5);
+    auto hz = juce::jlimit(1.f, nyquist * 0.99f, cutoffHz);
+    return 1.f - std::exp(-juce::MathConstants<float>::twoPi * hz / static_cast<float>(sampleRate));
+}
+
+float RingDelay::read(int index, float delayInSamples) const
+{
+    auto position = static_cast<float>(index) - delayInSamples;
+    auto whole = static_cast<int>(std::floor(position));
+    auto fraction = position - static_cast<float>(whole);
+
+    // How long before this ring's own write position the older neighbour is. For a partner's
+    // ring index runs up to a block ahead of it, so index can't stand in for it
+    auto age = (writeIndex - whole) & mask;
+    auto a = age <= samplesSinceReset ? ring[static_cast<size_t>(whole & mask)] : 0.f;
+    auto b = age - 1 <= samplesSinceReset ? ring[static_cast<size_t>((whole + 1) & mask)] : 0.f;
+    return a + fraction * (b - a);
+}
+
+void RingDelay::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    if (context.isBypassed || ring == nullptr)
+        return;
+
+    auto& block = context.getOutputBlock();
+    auto* samples = block.getChannelPointer(0);
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+
+    // The partner is the same instance on the other channel, it gets its ring at the same time
+    jassert(partner == nullptr || partner->ring != nullptr);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto delay = delaySamples.getNextValue();
+        auto input = samples[i];
+
+        auto delayed = read(writeIndex, delay);
+
+        // Both rings advance in lockstep, so the same index addresses the same moment in the partner
+        auto feedbackInput = partner != nullptr ? partner->read(writeIndex, delay) : delayed;
+
+        lowCutState += lowCutCoefficient * (feedbackInput - lowCutState);
+        auto lowCut = feedbackInput - lowCutState;
+        highCutState += highCutCoefficient * (lowCut - highCutState);
+
+        ring[static_cast<size_t>(writeIndex)] = input + feedback * highCutState;
+        writeIndex = (writeIndex + 1) & mask;
+        samplesSinceReset = juce::jmin(samplesSinceReset + 1, mask + 1);
+
+        samples[i] = input + mix * (delayed - input);
+    }
+}
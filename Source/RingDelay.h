@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    RingDelay.h
+
+    Mono feedback delay for the Delay module.
+
+    The delay memory is a power-of-two ring long enough for the longest
+    supported delay, so positions wrap with a mask and changing the delay time
+    never allocates. reset() doesn't clear it, which at high rates is megabytes
+    on the audio thread: reads of anything written before the reset return
+    silence until the ring has been written all the way round again. The ring isn't owned here: the processor only allocates
+    it for instances an order uses and hands it over through setRing(). Until
+    then the input passes through. The feedback path runs through a low cut
+    and a high cut filter.
+
+    For ping-pong, two instances are paired and each one feeds back the
+    other's delayed signal. The left and right channels are processed one after
+    the other, so a channel can only read samples its partner has already
+    written: the delay is kept at least one processing block long.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct RingDelay
+{
+    static constexpr double MaxDelaySeconds = 4.0;
+
+    // Samples the ring needs at sampleRate
+    static int getRingSize(double sampleRate);
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+    void process(const juce::dsp::ProcessContextReplacing<float>& context);
+
+    void setDelayMs(float newDelayMs);
+    void setFeedback(float newFeedback);     // 0 to 1
+    void setMix(float newMix);               // 0 to 1
+    void setLowCutHz(float newLowCutHz);
+    void setHighCutHz(float newHighCutHz);
+
+    /*
+    Pass nullptr to switch ping-pong off. minimumDelaySamples must be at least the
+    largest block the two channels are processed in.
+    */
+    void setPingPongPartner(const RingDelay* newPartner, int minimumDelaySamples);
+
+    // getRingSize() samples for the prepared rate, or nullptr. Read as silence until written
+    void setRing(float* newRing);
+
+private:
+    float* ring = nullptr;
+    int mask = 0;
+    int writeIndex = 0;
+
+    // Up to mask + 1, anything further back is from before the reset
+    int samplesSinceReset = 0;
+
+    double sampleRate = 44100.0;
+    float maxDelaySamples = 1.f;
+    float minDelaySamples = 1.f;
+
+    juce::SmoothedValue<float> delaySamples;
+    float feedback = 0.f;
+    float mix = 0.f;
+
+    // One-pole filters in the feedback path
+    float lowCutCoefficient = 0.f, highCutCoefficient = 1.f;
+    float lowCutState = 0.f, highCutState = 0.f;
+
+    const RingDelay* partner = nullptr;
+
+    float read(int index, float delayInSamples) const;
+    static float getOnePoleCoefficient(float cutoffHz, double sampleRate);
+};
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    SharedResources.h
+
+    Resources shared by every instance and editor in the process. They are
+    held through juce::SharedResourcePointer, so each is built when the first
+    one asks for it and freed with the last one, however many instances the
+    session has open. Message thread only.
+
+    The LookAndFeel, and with it the embedded IBM Plex Mono typefaces, is
+    shared the same way by the editor itself.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PresetBank.h"
+
+/*
+The preset bank file, mapped once for the whole process. The first processor
+loads it, the rest find it loaded. A save from any instance rewrites it for all.
+*/
+struct SharedPresetBank : PresetBank
+{
+    bool loadAttempted = false;
+};
+
+// The dB scales drawn over the level meters, rendered once per size and pixel scale
+struct MeterScaleCache
+{
+    struct Key
+    {
+        int width = 0, height = 0;
+        int leftMeterRightEdge = 0, rightMeterLeftEdge = 0;
+        float pixelScale = 1.f;
+
+        bool operator==(const Key& other) const = default;
+    };
+
+    /*
+    drawScale(g, area) paints the scale into an area of key.width by key.height at
+    the origin. It is only called when the key isn't cached yet.
+    */
+    template<typename DrawFn>
+    juce::Image get(const Key& key, DrawFn&& drawScale)
+    {
+        for (const auto& entry : entries)
+        {
+            if (entry.key == key)
+                return entry.image;
+        }
+
+        // Sizes only change while an editor is being resized, keep the latest few
+        if (entries.size() >= MaxEntries)
+            entries.erase(entries.begin());
+
+        juce::Image image(juce::Image::ARGB,
+                          juce::jmax(1, juce::roundToInt(static_cast<float>(key.width) * key.pixelScale)),
+                          juce::jmax(1, juce::roundToInt(static_cast<float>(key.height) * key.pixelScale)),
+                          true);
+        {
+            juce::Graphics g(image);
+            g.addTransform(juce::AffineTransform::scale(key.pixelScale));
+            drawScale(g, juce::Rectangle<int>(key.width, key.height));
+        }
+
+        entries.push_back({ key, image });
+        return image;
+    }
+
+private:
+    static constexpr size_t MaxEntries = 8;
+
+    struct Entry
+    {
+        Key key;
+        juce::Image image;
+    };
+
+    std::vector<Entry> entries;
+};
@@ -0,0 +1,746 @@
+/*
+  ==============================================================================
+
+    SimdKernels.cpp
+
+  ==============================================================================
+*/
+
+#include "SimdKernels.h"
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+ #if JUCE_GCC || JUCE_CLANG
+  #define MODULARFX_TARGET(isa) __attribute__((target(isa)))
+ #else
+  #define MODULARFX_TARGET(isa) // MSVC accepts every intrinsic without a flag
+ #endif
+#elif JUCE_ARM && defined(__ARM_NEON)
+ #include <arm_neon.h>
+ #define MODULARFX_HAS_NEON 1
+#endif
+
+/*
+Elementwise loops, one implementation for every CPU. The gain comes from the
+sample index rather than a running sum, so nothing carries from one sample to
+the next and the compiler vectorises them for the target it builds for. The
+sum keeps four partial sums, the compiler won't reorder a single one.
+*/
+float SimdKernels::sumOfSquares(const float* data, int numSamples)
+{
+    float sums[4] {};
+    int i = 0;
+    for (; i + 4 <= numSamples; i += 4)
+        for (int k = 0; k < 4; ++k)
+            sums[k] += data[i + k] * data[i + k];
+
+    for (; i < numSamples; ++i)
+        sums[0] += data[i] * data[i];
+
+    return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+}
+
+void SimdKernels::applyGainRamp(float* data, int numSamples, float startGain, float gainStep)
+{
+    for (int i = 0; i < numSamples; ++i)
+        data[i] *= startGain + gainStep * static_cast<float>(i + 1);
+}
+
+void SimdKernels::crossfade(float* wet, const float* dry, int numSamples, float startGain, float gainStep)
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto gain = startGain + gainStep * static_cast<float>(i + 1);
+        wet[i] = dry[i] + gain * (wet[i] - dry[i]);
+    }
+}
+
+void SimdKernels::sumAndDifference(float* a, float* b, int numSamples, float startGain, float gainStep)
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto gain = startGain + gainStep * static_cast<float>(i + 1);
+        auto sum = a[i] + b[i];
+        auto difference = a[i] - b[i];
+        a[i] = gain * sum;
+        b[i] = gain * difference;
+    }
+}
+
+// The tails the vector loops leave over, and the whole of the scalar variant
+static void decimatedPeaksFrom(const float* data, int start, int numSamples, float* peaks)
+{
+    for (int i = start; i < numSamples; ++i)
+    {
+        auto& peak = peaks[i / SimdKernels::PeakDecimation];
+        peak = juce::jmax(peak, std::abs(data[i]));
+    }
+}
+
+static void truePeaksFrom(const float* input, int start, int numSamples, const SimdKernels::TruePeakFilter& f, float* peaks)
+{
+    for (int i = start; i < numSamples; ++i)
+    {
+        auto peak = std::abs(input[i - SimdKernels::TruePeakDelay]);
+        for (int k = 0; k < SimdKernels::NumTruePeakPhases; ++k)
+        {
+            auto sum = 0.f;
+            for (int j = 0; j < SimdKernels::NumTruePeakTaps; ++j)
+                sum += f.coefficients[j][k] * input[i - j];
+            peak = juce::jmax(peak, std::abs(sum));
+        }
+        peaks[i] = peak;
+    }
+}
+
+static void biquadLanesScalar(float* data, int numSamples, SimdKernels::BiquadLanes& f)
+{
+    constexpr auto lanes = SimdKernels::NumBiquadLanes;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (int k = 0; k < lanes; ++k)
+        {
+            auto x = data[i * lanes + k];
+            auto y = f.b0[k] * x + f.z1[k];
+            f.z1[k] = f.b1[k] * x - f.a1[k] * y + f.z2[k];
+            f.z2[k] = f.b2[k] * x - f.a2[k] * y;
+            data[i * lanes + k] = y;
+        }
+    }
+}
+
+static void biquadCascadeScalar(float* data, int numSamples, SimdKernels::BiquadLanes& f)
+{
+    constexpr auto lanes = SimdKernels::NumBiquadLanes;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto x = data[i];
+        for (int k = 0; k < lanes; ++k)
+        {
+            auto y = f.b0[k] * x + f.z1[k];
+            f.z1[k] = f.b1[k] * x - f.a1[k] * y + f.z2[k];
+            f.z2[k] = f.b2[k] * x - f.a2[k] * y;
+            x = y;
+        }
+        data[i] = x;
+    }
+}
+
+/*
+The vector cascades stagger the lanes: on each step lane k works on sample
+step - k, taking lane k - 1's output from the step before. This is one of the
+steps at either end of the block, where some lanes have no sample to work on.
+*/
+static void biquadCascadeEdge(float* data, int numSamples, SimdKernels::BiquadLanes& f, float* outputs, int step)
+{
+    constexpr auto lanes = SimdKernels::NumBiquadLanes;
+
+    // Last lane first, so each lane still reads its predecessor's previous output
+    for (int k = lanes - 1; k >= 0; --k)
+    {
+        const auto i = step - k;
+        if (i < 0 || i >= numSamples)
+            continue;
+
+        auto x = k == 0 ? data[i] : outputs[k - 1];
+        auto y = f.b0[k] * x + f.z1[k];
+        f.z1[k] = f.b1[k] * x - f.a1[k] * y + f.z2[k];
+        f.z2[k] = f.b2[k] * x - f.a2[k] * y;
+        outputs[k] = y;
+
+        if (k == lanes - 1)
+            data[i] = y;
+    }
+}
+
+namespace ScalarKernels
+{
+    static void biquadLanes(float* data, int numSamples, SimdKernels::BiquadLanes& filters) { biquadLanesScalar(data, numSamples, filters); }
+    static void biquadCascade(float* data, int numSamples, SimdKernels::BiquadLanes& filters) { biquadCascadeScalar(data, numSamples, filters); }
+    static void decimatedPeaks(const float* data, int numSamples, float* peaks) { decimatedPeaksFrom(data, 0, numSamples, peaks); }
+    static void truePeaks(const float* input, int numSamples, const SimdKernels::TruePeakFilter& filter, float* peaks) { truePeaksFrom(input, 0, numSamples, filter, peaks); }
+}
+
+#if JUCE_INTEL
+namespace SSE2Kernels
+{
+    MODULARFX_TARGET("sse2") static void biquadLanes(float* data, int numSamples, SimdKernels::BiquadLanes& f)
+    {
+        const auto b0 = _mm_load_ps(f.b0), b1 = _mm_load_ps(f.b1), b2 = _mm_load_ps(f.b2);
+        const auto a1 = _mm_load_ps(f.a1), a2 = _mm_load_ps(f.a2);
+        auto z1 = _mm_load_ps(f.z1), z2 = _mm_load_ps(f.z2);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto* frame = data + i * SimdKernels::NumBiquadLanes;
+            auto x = _mm_loadu_ps(frame);
+            auto y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+            z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+            z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+            _mm_storeu_ps(frame, y);
+        }
+
+        _mm_store_ps(f.z1, z1);
+        _mm_store_ps(f.z2, z2);
+    }
+
+    MODULARFX_TARGET("sse2") static void biquadCascade(float* data, int numSamples, SimdKernels::BiquadLanes& f)
+    {
+        constexpr auto lanes = SimdKernels::NumBiquadLanes;
+        alignas(16) float outputs[lanes] {};
+
+        int step = 0;
+        for (; step < lanes - 1; ++step)
+            biquadCascadeEdge(data, numSamples, f, outputs, step);
+
+        const auto b0 = _mm_load_ps(f.b0), b1 = _mm_load_ps(f.b1), b2 = _mm_load_ps(f.b2);
+        const auto a1 = _mm_load_ps(f.a1), a2 = _mm_load_ps(f.a2);
+        auto z1 = _mm_load_ps(f.z1), z2 = _mm_load_ps(f.z2);
+        auto y = _mm_load_ps(outputs);
+
+        // Every lane is busy from here until the last input sample has entered lane 0
+        for (; step < numSamples; ++step)
+        {
+            auto x = _mm_move_ss(_mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(y), 4)), _mm_set_ss(data[step]));
+            y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+            z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+            z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+            data[step - (lanes - 1)] = _mm_cvtss_f32(_mm_shuffle_ps(y, y, _MM_SHUFFLE(3, 3, 3, 3)));
+        }
+
+        _mm_store_ps(f.z1, z1);
+        _mm_store_ps(f.z2, z2);
+        _mm_store_ps(outputs, y);
+
+        for (; step < numSamples + lanes - 1; ++step)
+            biquadCascadeEdge(data, numSamples, f, outputs, step);
+    }
+
+    MODULARFX_TARGET("sse2") static void decimatedPeaks(const float* data, int numSamples, float* peaks)
+    {
+        constexpr auto decimation = SimdKernels::PeakDecimation;
+        const auto magnitude = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+        int i = 0;
+        for (; i + decimation <= numSamples; i += decimation)
+        {
+            auto peak = _mm_setzero_ps();
+            for (int j = 0; j < decimation; j += 4)
+                peak = _mm_max_ps(peak, _mm_and_ps(_mm_loadu_ps(data + i + j), magnitude));
+
+            peak = _mm_max_ps(peak, _mm_shuffle_ps(peak, peak, _MM_SHUFFLE(1, 0, 3, 2)));
+            peak = _mm_max_ps(peak, _mm_shuffle_ps(peak, peak, _MM_SHUFFLE(2, 3, 0, 1)));
+
+            auto& out = peaks[i / decimation];
+            out = juce::jmax(out, _mm_cvtss_f32(peak));
+        }
+
+        decimatedPeaksFrom(data, i, numSamples, peaks);
+    }
+
+    MODULARFX_TARGET("sse2") static void truePeaks(const float* input, int numSamples, const SimdKernels::TruePeakFilter& f, float* peaks)
+    {
+        // The four phases of one sample side by side, one multiply-add per tap
+        const auto magnitude = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto sum = _mm_setzero_ps();
+            for (int j = 0; j < SimdKernels::NumTruePeakTaps; ++j)
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(f.coefficients[j]), _mm_set1_ps(input[i - j])));
+
+            auto peak = _mm_and_ps(sum, magnitude);
+            peak = _mm_max_ps(peak, _mm_shuffle_ps(peak, peak, _MM_SHUFFLE(1, 0, 3, 2)));
+            peak = _mm_max_ps(peak, _mm_shuffle_ps(peak, peak, _MM_SHUFFLE(2, 3, 0, 1)));
+
+            peaks[i] = juce::jmax(_mm_cvtss_f32(peak), std::abs(input[i - SimdKernels::TruePeakDelay]));
+        }
+    }
+}
+
+namespace AVX2Kernels
+{
+    // Four lanes fill an SSE register
+    MODULARFX_TARGET("avx2,fma") static void biquadLanes(float* data, int numSamples, SimdKernels::BiquadLanes& f)
+    {
+        const auto b0 = _mm_load_ps(f.b0), b1 = _mm_load_ps(f.b1), b2 = _mm_load_ps(f.b2);
+        const auto a1 = _mm_load_ps(f.a1), a2 = _mm_load_ps(f.a2);
+        auto z1 = _mm_load_ps(f.z1), z2 = _mm_load_ps(f.z2);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto* frame = data + i * SimdKernels::NumBiquadLanes;
+            auto x = _mm_loadu_ps(frame);
+            auto y = _mm_fmadd_ps(b0, x, z1);
+            z1 = _mm_fnmadd_ps(a1, y, _mm_fmadd_ps(b1, x, z2));
+            z2 = _mm_fnmadd_ps(a2, y, _mm_mul_ps(b2, x));
+            _mm_storeu_ps(frame, y);
+        }
+
+        _mm_store_ps(f.z1, z1);
+        _mm_store_ps(f.z2, z2);
+    }
+
+    MODULARFX_TARGET("avx2,fma") static void biquadCascade(float* data, int numSamples, SimdKernels::BiquadLanes& f)
+    {
+        constexpr auto lanes = SimdKernels::NumBiquadLanes;
+        alignas(16) float outputs[lanes] {};
+
+        int step = 0;
+        for (; step < lanes - 1; ++step)
+            biquadCascadeEdge(data, numSamples, f, outputs, step);
+
+        const auto b0 = _mm_load_ps(f.b0), b1 = _mm_load_ps(f.b1), b2 = _mm_load_ps(f.b2);
+        const auto a1 = _mm_load_ps(f.a1), a2 = _mm_load_ps(f.a2);
+        auto z1 = _mm_load_ps(f.z1), z2 = _mm_load_ps(f.z2);
+        auto y = _mm_load_ps(outputs);
+
+        for (; step < numSamples; ++step)
+        {
+            auto x = _mm_move_ss(_mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(y), 4)), _mm_set_ss(data[step]));
+            y = _mm_fmadd_ps(b0, x, z1);
+            z1 = _mm_fnmadd_ps(a1, y, _mm_fmadd_ps(b1, x, z2));
+            z2 = _mm_fnmadd_ps(a2, y, _mm_mul_ps(b2, x));
+            data[step - (lanes - 1)] = _mm_cvtss_f32(_mm_permute_ps(y, _MM_SHUFFLE(3, 3, 3, 3)));
+        }
+
+        _mm_store_ps(f.z1, z1);
+        _mm_store_ps(f.z2, z2);
+        _mm_store_ps(outputs, y);
+
+        for (; step < numSamples + lanes - 1; ++step)
+            biquadCascadeEdge(data, numSamples, f, outputs, step);
+    }
+
+    MODULARFX_TARGET("avx2,fma") static void decimatedPeaks(const float* data, int numSamples, float* peaks)
+    {
+        constexpr auto decimation = SimdKernels::PeakDecimation;
+        const auto magnitude = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+        int i = 0;
+        for (; i + decimation <= numSamples; i += decimation)
+        {
+            auto wide = _mm256_setzero_ps();
+            for (int j = 0; j < decimation; j += 8)
+                wide = _mm256_max_ps(wide, _mm256_and_ps(_mm256_loadu_ps(data + i + j), magnitude));
+
+            auto peak = _mm_max_ps(_mm256_castps256_ps128(wide), _mm256_extractf128_ps(wide, 1));
+            peak = _mm_max_ps(peak, _mm_shuffle_ps(peak, peak, _MM_SHUFFLE(1, 0, 3, 2)));
+            peak = _mm_max_ps(peak, _mm_shuffle_ps(peak, peak, _MM_SHUFFLE(2, 3, 0, 1)));
+
+            auto& out = peaks[i / decimation];
+            out = juce::jmax(out, _mm_cvtss_f32(peak));
+        }
+
+        decimatedPeaksFrom(data, i, numSamples, peaks);
+    }
+
+    MODULARFX_TARGET("avx2,fma") static void truePeaks(const float* input, int numSamples, const SimdKernels::TruePeakFilter& f, float* peaks)
+    {
+        // Two samples at once, each half of the register holding one sample's four phases
+        const auto magnitude = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+        int i = 0;
+        for (; i + 2 <= numSamples; i += 2)
+        {
+            auto sum = _mm256_setzero_ps();
+            for (int j = 0; j < SimdKernels::NumTruePeakTaps; ++j)
+            {
+                auto taps = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(f.coefficients[j]));
+                auto x = _mm256_setr_m128(_mm_set1_ps(input[i - j]), _mm_set1_ps(input[i + 1 - j]));
+                sum = _mm256_fmadd_ps(taps, x, sum);
+            }
+
+            auto peak = _mm256_and_ps(sum, magnitude);
+            peak = _mm256_max_ps(peak, _mm256_shuffle_ps(peak, peak, _MM_SHUFFLE(1, 0, 3, 2)));
+            peak = _mm256_max_ps(peak, _mm256_shuffle_ps(peak, peak, _MM_SHUFFLE(2, 3, 0, 1)));
+
+            peaks[i] = juce::jmax(_mm256_cvtss_f32(peak), std::abs(input[i - SimdKernels::TruePeakDelay]));
+            peaks[i + 1] = juce::jmax(_mm_cvtss_f32(_mm256_extractf128_ps(peak, 1)), std::abs(input[i + 1 - SimdKernels::TruePeakDelay]));
+        }
+
+        truePeaksFrom(input, i, numSamples, f, peaks);
+    }
+}
+
+namespace AVX512Kernels
+{
+    /*
+    The cascade is four lanes deep, so it stays in 128 bit registers. AVX-512VL
+    still saves the shift and blend that feed lane 0: the new sample is merged
+    into the shifted outputs under a mask.
+    */
+    MODULARFX_TARGET("avx512f,avx512vl,fma") static void biquadCascade(float* data, int numSamples, SimdKernels::BiquadLanes& f)
+    {
+        constexpr auto lanes = SimdKernels::NumBiquadLanes;
+        alignas(16) float outputs[lanes] {};
+
+        int step = 0;
+        for (; step < lanes - 1; ++step)
+            biquadCascadeEdge(data, numSamples, f, outputs, step);
+
+        const auto b0 = _mm_load_ps(f.b0), b1 = _mm_load_ps(f.b1), b2 = _mm_load_ps(f.b2);
+        const auto a1 = _mm_load_ps(f.a1), a2 = _mm_load_ps(f.a2);
+        auto z1 = _mm_load_ps(f.z1), z2 = _mm_load_ps(f.z2);
+        auto y = _mm_load_ps(outputs);
+
+        for (; step < numSamples; ++step)
+        {
+            auto shifted = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(y), 4));
+            auto x = _mm_mask_broadcastss_ps(shifted, 1, _mm_load_ss(data + step));
+            y = _mm_fmadd_ps(b0, x, z1);
+            z1 = _mm_fnmadd_ps(a1, y, _mm_fmadd_ps(b1, x, z2));
+            z2 = _mm_fnmadd_ps(a2, y, _mm_mul_ps(b2, x));
+            data[step - (lanes - 1)] = _mm_cvtss_f32(_mm_permute_ps(y, _MM_SHUFFLE(3, 3, 3, 3)));
+        }
+
+        _mm_store_ps(f.z1, z1);
+        _mm_store_ps(f.z2, z2);
+        _mm_store_ps(outputs, y);
+
+        for (; step < numSamples + lanes - 1; ++step)
+            biquadCascadeEdge(data, numSamples, f, outputs, step);
+    }
+
+    MODULARFX_TARGET("avx512f") static void decimatedPeaks(const float* data, int numSamples, float* peaks)
+    {
+        // One register is exactly one peak's worth of samples
+        static_assert(SimdKernels::PeakDecimation == 16);
+        constexpr auto decimation = SimdKernels::PeakDecimation;
+
+        int i = 0;
+        for (; i + decimation <= numSamples; i += decimation)
+        {
+            auto& out = peaks[i / decimation];
+            out = juce::jmax(out, _mm512_reduce_max_ps(_mm512_abs_ps(_mm512_loadu_ps(data + i))));
+        }
+
+        decimatedPeaksFrom(data, i, numSamples, peaks);
+    }
+
+    MODULARFX_TARGET("avx512f") static void truePeaks(const float* input, int numSamples, const SimdKernels::TruePeakFilter& f, float* peaks)
+    {
+        // Four samples at once, each quarter of the register holding one sample's four phases
+        const auto spread = _mm512_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3);
+
+        int i = 0;
+        for (; i + 4 <= numSamples; i += 4)
+        {
+            auto sum = _mm512_setzero_ps();
+            for (int j = 0; j < SimdKernels::NumTruePeakTaps; ++j)
+            {
+                auto taps = _mm512_broadcast_f32x4(_mm_load_ps(f.coefficients[j]));
+                auto x = _mm512_permutexvar_ps(spread, _mm512_castps128_ps512(_mm_loadu_ps(input + i - j)));
+                sum = _mm512_fmadd_ps(taps, x, sum);
+            }
+
+            auto peak = _mm512_abs_ps(sum);
+            peak = _mm512_max_ps(peak, _mm512_shuffle_ps(peak, peak, _MM_SHUFFLE(1, 0, 3, 2)));
+            peak = _mm512_max_ps(peak, _mm512_shuffle_ps(peak, peak, _MM_SHUFFLE(2, 3, 0, 1)));
+
+            alignas(64) float quarters[16];
+            _mm512_store_ps(quarters, peak);
+
+            for (int k = 0; k < 4; ++k)
+                peaks[i + k] = juce::jmax(quarters[k * 4], std::abs(input[i + k - SimdKernels::TruePeakDelay]));
+        }
+
+        truePeaksFrom(input, i, numSamples, f, peaks);
+    }
+}
+#endif
+
+#if MODULARFX_HAS_NEON
+namespace NEONKernels
+{
+    static void biquadLanes(float* data, int numSamples, SimdKernels::BiquadLanes& f)
+    {
+        const auto b0 = vld1q_f32(f.b0), b1 = vld1q_f32(f.b1), b2 = vld1q_f32(f.b2);
+        const auto a1 = vld1q_f32(f.a1), a2 = vld1q_f32(f.a2);
+        auto z1 = vld1q_f32(f.z1), z2 = vld1q_f32(f.z2);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto* frame = data + i * SimdKernels::NumBiquadLanes;
+            auto x = vld1q_f32(frame);
+            auto y = vmlaq_f32(z1, b0, x);
+            z1 = vmlsq_f32(vmlaq_f32(z2, b1, x), a1, y);
+            z2 = vmlsq_f32(vmulq_f32(b2, x), a2, y);
+            vst1q_f32(frame, y);
+        }
+
+        vst1q_f32(f.z1, z1);
+        vst1q_f32(f.z2, z2);
+    }
+
+    static void biquadCascade(float* data, int numSamples, SimdKernels::BiquadLanes& f)
+    {
+        constexpr auto lanes = SimdKernels::NumBiquadLanes;
+        alignas(16) float outputs[lanes] {};
+
+        int step = 0;
+        for (; step < lanes - 1; ++step)
+            biquadCascadeEdge(data, numSamples, f, outputs, step);
+
+        const auto b0 = vld1q_f32(f.b0), b1 = vld1q_f32(f.b1), b2 = vld1q_f32(f.b2);
+        const auto a1 = vld1q_f32(f.a1), a2 = vld1q_f32(f.a2);
+        auto z1 = vld1q_f32(f.z1), z2 = vld1q_f32(f.z2);
+        auto y = vld1q_f32(outputs);
+
+        for (; step < numSamples; ++step)
+        {
+            auto x = vextq_f32(vdupq_n_f32(data[step]), y, 3);
+            y = vmlaq_f32(z1, b0, x);
+            z1 = vmlsq_f32(vmlaq_f32(z2, b1, x), a1, y);
+            z2 = vmlsq_f32(vmulq_f32(b2, x), a2, y);
+            data[step - (lanes - 1)] = vgetq_lane_f32(y, 3);
+        }
+
+        vst1q_f32(f.z1, z1);
+        vst1q_f32(f.z2, z2);
+        vst1q_f32(outputs, y);
+
+        for (; step < numSamples + lanes - 1; ++step)
+            biquadCascadeEdge(data, numSamples, f, outputs, step);
+    }
+
+    static void decimatedPeaks(const float* data, int numSamples, float* peaks)
+    {
+        constexpr auto decimation = SimdKernels::PeakDecimation;
+
+        int i = 0;
+        for (; i + decimation <= numSamples; i += decimation)
+        {
+            auto peak = vdupq_n_f32(0.f);
+            for (int j = 0; j < decimation; j += 4)
+                peak = vmaxq_f32(peak, vabsq_f32(vld1q_f32(data + i + j)));
+
+            float lanes[4];
+            vst1q_f32(lanes, peak);
+
+            auto& out = peaks[i / decimation];
+            out = juce::jmax(out, lanes[0], lanes[1], juce::jmax(lanes[2], lanes[3]));
+        }
+
+        decimatedPeaksFrom(data, i, numSamples, peaks);
+    }
+
+    static void truePeaks(const float* input, int numSamples, const SimdKernels::TruePeakFilter& f, float* peaks)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto sum = vdupq_n_f32(0.f);
+            for (int j = 0; j < SimdKernels::NumTruePeakTaps; ++j)
+                sum = vmlaq_n_f32(sum, vld1q_f32(f.coefficients[j]), input[i - j]);
+
+            float lanes[4];
+            vst1q_f32(lanes, vabsq_f32(sum));
+
+            peaks[i] = juce::jmax(juce::jmax(lanes[0], lanes[1]), juce::jmax(lanes[2], lanes[3]),
+                                  std::abs(input[i - SimdKernels::TruePeakDelay]));
+        }
+    }
+}
+#endif
+
+const SimdKernels::Table* SimdKernels::getTable(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::Scalar:
+    {
+        static const Table table { &ScalarKernels::biquadLanes, &ScalarKernels::biquadCascade, &ScalarKernels::decimatedPeaks, &ScalarKernels::truePeaks };
+        return &table;
+    }
+#if JUCE_INTEL
+    case Isa::SSE2:
+    {
+        static const Table table { &SSE2Kernels::biquadLanes, &SSE2Kernels::biquadCascade, &SSE2Kernels::decimatedPeaks, &SSE2Kernels::truePeaks };
+        return juce::SystemStats::hasSSE2() ? &table : nullptr;
+    }
+    case Isa::AVX2:
+    {
+        static const Table table { &AVX2Kernels::biquadLanes, &AVX2Kernels::biquadCascade, &AVX2Kernels::decimatedPeaks, &AVX2Kernels::truePeaks };
+        return juce::SystemStats::hasAVX2() && juce::SystemStats::hasFMA3() ? &table : nullptr;
+    }
+    case Isa::AVX512:
+    {
+        // Four independent lanes are one 128 bit register whatever the ISA, so the FMA loop serves here too
+        static const Table table { &AVX2Kernels::biquadLanes, &AVX512Kernels::biquadCascade, &AVX512Kernels::decimatedPeaks, &AVX512Kernels::truePeaks };
+        return juce::SystemStats::hasAVX512F() && juce::SystemStats::hasAVX512VL() ? &table : nullptr;
+    }
+#endif
+#if MODULARFX_HAS_NEON
+    case Isa::NEON:
+    {
+        static const Table table { &NEONKernels::biquadLanes, &NEONKernels::biquadCascade, &NEONKernels::decimatedPeaks, &NEONKernels::truePeaks };
+        return &table;
+    }
+#endif
+    default:
+        break;
+    }
+
+    return nullptr;
+}
+
+juce::String SimdKernels::getIsaName(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::Scalar:   return "scalar";
+    case Isa::SSE2:     return "sse2";
+    case Isa::AVX2:     return "avx2";
+    case Isa::AVX512:   return "avx512";
+    case Isa::NEON:     return "neon";
+    case Isa::END_OF_LIST: break;
+    }
+    return {};
+}
+
+SimdKernels::Isa SimdKernels::chooseIsa()
+{
+    auto forced = juce::SystemStats::getEnvironmentVariable("MODULARFX_SIMD", {}).trim().toLowerCase();
+    if (forced.isNotEmpty())
+    {
+        for (int i = 0; i < static_cast<int>(Isa::END_OF_LIST); ++i)
+        {
+            auto isa = static_cast<Isa>(i);
+            if (forced == getIsaName(isa) && getTable(isa) != nullptr)
+                return isa;
+        }
+
+        DBG("MODULARFX_SIMD=" << forced << " isn't available here, picking automatically");
+    }
+
+    // Widest first
+    for (auto isa : { Isa::AVX512, Isa::AVX2, Isa::NEON, Isa::SSE2 })
+    {
+        if (getTable(isa) != nullptr)
+            return isa;
+    }
+
+    return Isa::Scalar;
+}
+
+SimdKernels::Isa SimdKernels::getActiveIsa()
+{
+    static const Isa active = chooseIsa();
+    return active;
+}
+
+const SimdKernels::Table& SimdKernels::get()
+{
+    static const Table& table = *getTable(getActiveIsa());
+    return table;
+}
+
+bool SimdKernels::verify(float tolerance)
+{
+    // Odd length, so every variant runs its vector loop and its scalar tail
+    constexpr int numSamples = 103;
+
+    juce::Random random(0x5eed);
+    std::array<float, numSamples> input {}, dry {};
+    for (int i = 0; i < numSamples; ++i)
+    {
+        input[static_cast<size_t>(i)] = random.nextFloat() * 2.f - 1.f;
+        dry[static_cast<size_t>(i)] = random.nextFloat() * 2.f - 1.f;
+    }
+
+    const auto& reference = *getTable(Isa::Scalar);
+
+    // A resonant lowpass per lane, each at its own frequency, over the input spread across the lanes
+    BiquadLanes filters;
+    for (int k = 0; k < NumBiquadLanes; ++k)
+    {
+        auto w = 0.05f * static_cast<float>(k + 1);
+        auto alpha = std::sin(w) / (2.f * 2.f);
+        auto a0 = 1.f + alpha;
+        filters.b0[k] = filters.b2[k] = (1.f - std::cos(w)) * 0.5f / a0;
+        filters.b1[k] = (1.f - std::cos(w)) / a0;
+        filters.a1[k] = -2.f * std::cos(w) / a0;
+        filters.a2[k] = (1.f - alpha) / a0;
+    }
+
+    std::array<float, numSamples * NumBiquadLanes> expectedLanes {};
+    for (size_t i = 0; i < expectedLanes.size(); ++i)
+        expectedLanes[i] = input[i % static_cast<size_t>(numSamples)];
+
+    auto lanesInput = expectedLanes;
+    auto referenceFilters = filters;
+    reference.biquadLanes(expectedLanes.data(), numSamples, referenceFilters);
+
+    // The same filters in series over the input
+    auto expectedCascade = input;
+    auto cascadeFilters = filters;
+    reference.biquadCascade(expectedCascade.data(), numSamples, cascadeFilters);
+
+    // Over both inputs, starting from peaks some of them already exceed
+    constexpr int numPeaks = (numSamples + PeakDecimation - 1) / PeakDecimation;
+    std::array<float, numPeaks> initialPeaks {};
+    for (size_t i = 0; i < initialPeaks.size(); i += 2)
+        initialPeaks[i] = 0.9f;
+
+    auto expectedPeaks = initialPeaks;
+    reference.decimatedPeaks(input.data(), numSamples, expectedPeaks.data());
+    reference.decimatedPeaks(dry.data(), numSamples, expectedPeaks.data());
+
+    // Any coefficients do, the start of the input is the history
+    TruePeakFilter truePeakFilter;
+    for (auto& taps : truePeakFilter.coefficients)
+        for (auto& c : taps)
+            c = random.nextFloat() - 0.5f;
+
+    constexpr int history = NumTruePeakTaps - 1;
+    std::array<float, numSamples - history> expectedTruePeaks {};
+    reference.truePeaks(input.data() + history, numSamples - history, truePeakFilter, expectedTruePeaks.data());
+
+    // Written so a NaN never matches
+    auto matches = [tolerance](const auto& a, const auto& b)
+        {
+            for (size_t i = 0; i < a.size(); ++i)
+            {
+                if ((std::abs(a[i] - b[i]) <= tolerance) == false)
+                    return false;
+            }
+            return true;
+        };
+
+    bool allMatch = true;
+    for (int i = 0; i < static_cast<int>(Isa::END_OF_LIST); ++i)
+    {
+        auto isa = static_cast<Isa>(i);
+        auto* table = getTable(isa);
+        if (table == nullptr)
+            continue;
+
+        auto lanes = lanesInput;
+        auto laneFilters = filters;
+        table->biquadLanes(lanes.data(), numSamples, laneFilters);
+
+        // Split so the cascade's state carries over, the first call too short to fill the lanes
+        auto cascade = input;
+        auto seriesFilters = filters;
+        table->biquadCascade(cascade.data(), 2, seriesFilters);
+        table->biquadCascade(cascade.data() + 2, numSamples - 2, seriesFilters);
+
+        auto peaks = initialPeaks;
+        table->decimatedPeaks(input.data(), numSamples, peaks.data());
+        table->decimatedPeaks(dry.data(), numSamples, peaks.data());
+
+        // Output only, so it starts as NaN and a slot the variant doesn't write fails
+        std::array<float, numSamples - history> truePeaks;
+        truePeaks.fill(std::numeric_limits<float>::quiet_NaN());
+        table->truePeaks(input.data() + history, numSamples - history, truePeakFilter, truePeaks.data());
+
+        if (matches(lanes, expectedLanes) == false || matches(cascade, expectedCascade) == false
+            || matches(peaks, expectedPeaks) == false || matches(truePeaks, expectedTruePeaks) == false)
+        {
+            DBG("SIMD kernels disagree with the scalar reference: " << getIsaName(isa));
+            allMatch = false;
+        }
+    }
+
+    return allMatch;
+}
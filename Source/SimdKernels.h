@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    SimdKernels.h
+
+    The plugin's own inner loops. The biquad and peak kernels are written out
+    once per instruction set, the best variant the CPU supports is picked the
+    first time get() is called and used from then on, so a single binary runs
+    the wide kernels where they exist and still loads on older machines. The
+    elementwise gain and crossfade loops vectorise well enough on their own and
+    are plain static functions.
+
+    Set MODULARFX_SIMD to scalar, sse2, avx2, avx512 or neon to force a variant,
+    for comparing them or chasing a bug in one. Unsupported choices fall back to
+    the automatic pick.
+
+    The recursive loops (biquads, the ladder, allpass chains and the delay's
+    interpolated feedback) depend on the previous sample, so they can't be
+    spread across lanes within a channel and stay with their modules. Where
+    several independent filters see the same samples, as in the crossover,
+    biquadLanes runs four of them at once instead. Filters in series on one
+    signal, as in the general filter's bands, go through biquadCascade, which
+    staggers them so each lane works on a different sample. The phaser, chorus
+    and ladder are JUCE's own classes and aren't covered here.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct SimdKernels
+{
+    static constexpr int NumBiquadLanes = 4;
+
+    // Samples per peak from decimatedPeaks
+    static constexpr int PeakDecimation = 16;
+
+    static constexpr int NumTruePeakPhases = 4;
+    static constexpr int NumTruePeakTaps = 12; // Per phase
+    static constexpr int TruePeakDelay = NumTruePeakTaps / 2;
+
+    // A 4x polyphase interpolator, the taps of each phase side by side
+    struct alignas(16) TruePeakFilter
+    {
+        float coefficients[NumTruePeakTaps][NumTruePeakPhases] {};
+    };
+
+    /*
+    Four independent biquads run side by side in transposed direct form II,
+    a1 and a2 with the sign they have in the difference equation's denominator.
+    Each lane has its own coefficients and state.
+    */
+    struct alignas(16) BiquadLanes
+    {
+        float b0[NumBiquadLanes] {}, b1[NumBiquadLanes] {}, b2[NumBiquadLanes] {};
+        float a1[NumBiquadLanes] {}, a2[NumBiquadLanes] {};
+        float z1[NumBiquadLanes] {}, z2[NumBiquadLanes] {};
+    };
+
+    enum class Isa
+    {
+        Scalar,
+        SSE2,
+        AVX2,
+        AVX512,
+        NEON,
+        END_OF_LIST
+    };
+
+    static float sumOfSquares(const float* data, int numSamples);
+
+    // data[i] *= startGain + gainStep * (i + 1)
+    static void applyGainRamp(float* data, int numSamples, float startGain, float gainStep);
+
+    // wet[i] = dry[i] + (startGain + gainStep * (i + 1)) * (wet[i] - dry[i])
+    static void crossfade(float* wet, const float* dry, int numSamples, float startGain, float gainStep);
+
+    // With g = startGain + gainStep * (i + 1): a[i], b[i] = g * (a[i] + b[i]), g * (a[i] - b[i])
+    static void sumAndDifference(float* a, float* b, int numSamples, float startGain, float gainStep);
+
+    struct Table
+    {
+        // Filters NumBiquadLanes interleaved signals in place, lane k of sample i at data[i * NumBiquadLanes + k]
+        void (*biquadLanes)(float* data, int numSamples, BiquadLanes& filters);
+
+        // Filters one signal in place through the NumBiquadLanes biquads in series, lane 0 first
+        void (*biquadCascade)(float* data, int numSamples, BiquadLanes& filters);
+
+        /*
+        Raises peaks[c] to the largest magnitude in samples c * PeakDecimation
+        onwards, the last peak over whatever is left. Called once per channel
+        on the same peaks, they end up as the peak across all of them.
+        */
+        void (*decimatedPeaks)(const float* data, int numSamples, float* peaks);
+
+        /*
+        peaks[i] is the largest magnitude of input[i - TruePeakDelay] and the
+        points the filter interpolates from input[i] back. The NumTruePeakTaps - 1
+        samples before input are read as history.
+        */
+        void (*truePeaks)(const float* input, int numSamples, const TruePeakFilter& filter, float* peaks);
+    };
+
+    static const Table& get();
+    static Isa getActiveIsa();
+
+    static juce::String getIsaName(Isa isa);
+
+    // nullptr when the variant isn't compiled for this platform or the CPU lacks it
+    static const Table* getTable(Isa isa);
+
+    // Runs every available variant on the same input and compares it with the scalar one
+    static bool verify(float tolerance = 1.0e-5f);
+
+private:
+    static Isa chooseIsa();
+};
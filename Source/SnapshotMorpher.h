@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    SnapshotMorpher.h
+
+    Interpolates between stored snapshots with a single morph position.
+    Continuous values are kept as flat, normalised arrays so a whole state is
+    blended with two vector operations. Discrete values (modes, bypasses)
+    can't be blended, they switch to whichever state is nearer.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+template<size_t NumContinuous, size_t NumDiscrete, size_t NumStates>
+struct SnapshotMorpher
+{
+    struct States
+    {
+        std::array<std::array<float, NumContinuous>, NumStates> continuous {};  // normalised
+        std::array<std::array<float, NumDiscrete>, NumStates> discrete {};      // plain (index or 0/1)
+        std::array<bool, NumStates> isValid {};
+    };
+
+    void setStates(const States& newStates)
+    {
+        states = newStates;
+
+        numValidStates = 0;
+        for (size_t i = 0; i < NumStates; ++i)
+        {
+            if (states.isValid[i])
+                validStates[static_cast<size_t>(numValidStates++)] = i;
+        }
+    }
+
+    bool canMorph() const { return numValidStates >= 2; }
+
+    /*
+    Position 0 is the first valid state and 1 is the last, the states in between
+    are spread evenly across the range.
+    */
+    void process(float position, float* continuousOut, float* discreteOut) const
+    {
+        jassert(canMorph());
+
+        auto scaled = juce::jlimit(0.f, 1.f, position) * static_cast<float>(numValidStates - 1);
+        auto segment = juce::jmin(static_cast<int>(scaled), numValidStates - 2);
+        auto fraction = scaled - static_cast<float>(segment);
+
+        const auto& from = states.continuous[validStates[static_cast<size_t>(segment)]];
+        const auto& to = states.continuous[validStates[static_cast<size_t>(segment + 1)]];
+
+        constexpr auto numValues = static_cast<int>(NumContinuous);
+        juce::FloatVectorOperations::copyWithMultiply(continuousOut, from.data(), 1.f - fraction, numValues);
+        juce::FloatVectorOperations::addWithMultiply(continuousOut, to.data(), fraction, numValues);
+
+        const auto& nearest = states.discrete[validStates[static_cast<size_t>(fraction < 0.5f ? segment : segment + 1)]];
+        std::copy(nearest.begin(), nearest.end(), discreteOut);
+    }
+
+private:
+    States states;
+    std::array<size_t, NumStates> validStates {};
+    int numValidStates = 0;
+};
@@ -0,0 +1,196 @@
+/*
+  ==============================================================================
+
+    TruePeakLimiter.cpp
+
+  ==============================================================================
+*/
+
+#include "TruePeakLimiter.h"
+
+static int getLookaheadSamples(double sampleRate)
+{
+    return juce::jmax(1, static_cast<int>(std::ceil(TruePeakLimiter::LookaheadSeconds * sampleRate)));
+}
+
+TruePeakLimiter::TruePeakLimiter()
+{
+    constexpr auto phases = SimdKernels::NumTruePeakPhases;
+    constexpr auto taps = SimdKernels::NumTruePeakTaps;
+    constexpr auto length = phases * taps;
+
+    // A Blackman windowed sinc at the original Nyquist, centred between the middle two taps
+    for (int k = 0; k < phases; ++k)
+    {
+        auto sum = 0.f;
+        for (int j = 0; j < taps; ++j)
+        {
+            const auto n = j * phases + k;
+            const auto x = (n - (length - 1) * 0.5) / phases;
+            const auto sinc = x == 0.0 ? 1.0 : std::sin(juce::MathConstants<double>::pi * x) / (juce::MathConstants<double>::pi * x);
+            const auto w = (n + 0.5) / length;
+            const auto window = 0.42 - 0.5 * std::cos(juce::MathConstants<double>::twoPi * w) + 0.08 * std::cos(2.0 * juce::MathConstants<double>::twoPi * w);
+
+            filter.coefficients[j][k] = static_cast<float>(sinc * window);
+            sum += filter.coefficients[j][k];
+        }
+
+        // Every phase passes DC at unity
+        for (int j = 0; j < taps; ++j)
+            filter.coefficients[j][k] /= sum;
+    }
+}
+
+int TruePeakLimiter::getLatencySamples(double sampleRate)
+{
+    return getLookaheadSamples(sampleRate) + SimdKernels::TruePeakDelay;
+}
+
+void TruePeakLimiter::prepare(double newSampleRate, int numChannels)
+{
+    sampleRate = newSampleRate;
+    lookahead = getLookaheadSamples(sampleRate);
+
+    /*
+    The detector reports a sample TruePeakDelay late, and the points either
+    side of it over the next sample. Holding for two more than the average's
+    length keeps all of them under every gain the average sums for it.
+    */
+    holdLength = lookahead + 2;
+
+    detectorInputs.assign(static_cast<size_t>(numChannels), std::vector<float>(History + ChunkSize));
+    channelPeaks.assign(ChunkSize, 0.f);
+    linkedPeaks.assign(ChunkSize, 0.f);
+
+    delayLines.assign(static_cast<size_t>(numChannels), std::vector<float>(static_cast<size_t>(getLatencySamples(sampleRate))));
+
+    deque.assign(static_cast<size_t>(holdLength + 1), {});
+    averageWindow.assign(static_cast<size_t>(lookahead), 1.f);
+
+    setReleaseMs(100.f);
+    reset();
+}
+
+void TruePeakLimiter::reset()
+{
+    for (auto& input : detectorInputs)
+        std::fill(input.begin(), input.end(), 0.f);
+
+    for (auto& line : delayLines)
+        std::fill(line.begin(), line.end(), 0.f);
+
+    delayPosition = 0;
+    dequeHead = dequeSize = 0;
+    time = 0;
+
+    std::fill(averageWindow.begin(), averageWindow.end(), 1.f);
+    averagePosition = 0;
+    averageSum = static_cast<double>(averageWindow.size());
+
+    heldGain = 1.f;
+    minimumGain = 1.f;
+}
+
+void TruePeakLimiter::setCeilingDecibels(float newCeilingDecibels)
+{
+    ceiling = juce::Decibels::decibelsToGain(newCeilingDecibels);
+}
+
+void TruePeakLimiter::setReleaseMs(float newReleaseMs)
+{
+    releaseCoefficient = static_cast<float>(std::exp(-1.0 / (juce::jmax(1.f, newReleaseMs) * 0.001 * sampleRate)));
+}
+
+float TruePeakLimiter::pushPeak(float peak)
+{
+    const auto capacity = static_cast<int>(deque.size());
+
+    // Anything no larger than the new peak can never be the maximum again
+    while (dequeSize > 0)
+    {
+        const auto& newest = deque[static_cast<size_t>((dequeHead + dequeSize - 1) % capacity)];
+        if (newest.value > peak)
+            break;
+        --dequeSize;
+    }
+
+    deque[static_cast<size_t>((dequeHead + dequeSize) % capacity)] = { time, peak };
+    ++dequeSize;
+
+    // The oldest drops out once the window has moved past it
+    if (deque[static_cast<size_t>(dequeHead)].time <= time - holdLength)
+    {
+        dequeHead = (dequeHead + 1) % capacity;
+        --dequeSize;
+    }
+
+    ++time;
+    return deque[static_cast<size_t>(dequeHead)].value;
+}
+
+void TruePeakLimiter::process(const juce::dsp::AudioBlock<float>& block)
+{
+    minimumGain = 1.f;
+
+    const auto numSamples = block.getNumSamples();
+    for (size_t start = 0; start < numSamples; start += ChunkSize)
+        processChunk(block.getSubBlock(start, juce::jmin(static_cast<size_t>(ChunkSize), numSamples - start)));
+}
+
+void TruePeakLimiter::processChunk(const juce::dsp::AudioBlock<float>& block)
+{
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+    const auto numChannels = juce::jmin(static_cast<int>(block.getNumChannels()), static_cast<int>(detectorInputs.size()));
+    const auto& kernels = SimdKernels::get();
+
+    std::fill_n(linkedPeaks.begin(), numSamples, 0.f);
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto& input = detectorInputs[static_cast<size_t>(ch)];
+        std::copy_n(block.getChannelPointer(static_cast<size_t>(ch)), numSamples, input.data() + History);
+
+        kernels.truePeaks(input.data() + History, numSamples, filter, channelPeaks.data());
+        juce::FloatVectorOperations::max(linkedPeaks.data(), linkedPeaks.data(), channelPeaks.data(), numSamples);
+
+        // The end of this chunk is the next one's history
+        std::copy_n(input.data() + numSamples, History, input.data());
+    }
+
+    const auto delayLength = delayLines.empty() ? 0 : static_cast<int>(delayLines.front().size());
+    const auto averageLength = static_cast<int>(averageWindow.size());
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto peak = pushPeak(linkedPeaks[static_cast<size_t>(i)]);
+        const auto target = peak > ceiling ? ceiling / peak : 1.f;
+
+        // Down at once, the average does the smoothing. Back up with the release
+        heldGain = target < heldGain ? target : target + releaseCoefficient * (heldGain - target);
+
+        auto& oldest = averageWindow[static_cast<size_t>(averagePosition)];
+        averageSum += heldGain - oldest;
+        oldest = heldGain;
+        averagePosition = (averagePosition + 1) % averageLength;
+
+        const auto gain = juce::jmin(1.f, static_cast<float>(averageSum / averageLength));
+        minimumGain = juce::jmin(minimumGain, gain);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            auto* data = block.getChannelPointer(static_cast<size_t>(ch));
+            auto& delayed = delayLines[static_cast<size_t>(ch)][static_cast<size_t>(delayPosition)];
+            const auto x = data[i];
+            data[i] = delayed * gain;
+            delayed = x;
+        }
+
+        delayPosition = (delayPosition + 1) % delayLength;
+    }
+
+    // Rounding in the average must not let a sample through
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* data = block.getChannelPointer(static_cast<size_t>(ch));
+        juce::FloatVectorOperations::clip(data, data, -ceiling, ceiling, numSamples);
+    }
+}
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    TruePeakLimiter.h
+
+    The brickwall limiter on the plugin's output. Peaks are detected between
+    the samples too, by 4x polyphase interpolation (SimdKernels::truePeaks),
+    and taken across the channels so they share one gain.
+
+    The gain each peak needs is held for the lookahead by a sliding maximum,
+    a monotonic deque of the peaks still in the window. A moving average over
+    the lookahead then ramps the gain down ahead of the peak, and it recovers
+    with the release. The audio is delayed to line up with the ramp, so no
+    sample goes over the ceiling, nor any point between them the detector
+    sees. Overs it misses between its points are a fraction of a dB.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SimdKernels.h"
+
+struct TruePeakLimiter
+{
+    static constexpr double LookaheadSeconds = 0.0015;
+
+    TruePeakLimiter();
+
+    // The delay the limiter adds at sampleRate
+    static int getLatencySamples(double sampleRate);
+
+    void prepare(double sampleRate, int numChannels);
+    void reset();
+
+    void setCeilingDecibels(float newCeilingDecibels);
+    void setReleaseMs(float newReleaseMs);
+
+    void process(const juce::dsp::AudioBlock<float>& block);
+
+    // The most the last block was turned down by, 0 dB or below
+    float getGainReductionDecibels() const { return juce::Decibels::gainToDecibels(minimumGain, -100.f); }
+
+private:
+    // Blocks are worked through in pieces of this size, whatever the host sends
+    static constexpr int ChunkSize = 256;
+    static constexpr int History = SimdKernels::NumTruePeakTaps - 1;
+
+    SimdKernels::TruePeakFilter filter;
+
+    double sampleRate = 44100.0;
+    int lookahead = 1;
+
+    // Each channel's input with the taps' history in front, and its peaks
+    std::vector<std::vector<float>> detectorInputs;
+    std::vector<float> channelPeaks, linkedPeaks;
+
+    std::vector<std::vector<float>> delayLines;
+    int delayPosition = 0;
+
+    // The sliding maximum, oldest at dequeHead
+    struct Peak
+    {
+        juce::int64 time = 0;
+        float value = 0.f;
+    };
+
+    std::vector<Peak> deque;
+    int dequeHead = 0, dequeSize = 0;
+    int holdLength = 1;
+    juce::int64 time = 0;
+
+    // The moving average's window of held gains
+    std::vector<float> averageWindow;
+    int averagePosition = 0;
+    double averageSum = 0.0;
+
+    float ceiling = 1.f;
+    float releaseCoefficient = 0.f;
+    float heldGain = 1.f;
+    float minimumGain = 1.f;
+
+    float pushPeak(float peak);
+    void processChunk(const juce::dsp::AudioBlock<float>& block);
+};
@@ -0,0 +1,254 @@
+/*
+  ==============================================================================
+
+    HostSimulationTest.cpp
+
+    Plays the processor the way awkward hosts do: blocks of odd sizes, blocks
+    of no samples at all, blocks bigger than prepareToPlay() promised, blocks
+    of seeded random sizes, a change of sample rate with a prepare in between,
+    and a switch between offline and realtime rendering part way through.
+    Each render has to null against the same input rendered on a fresh
+    processor in fixed blocks of the prepared size.
+
+    Every case runs twice. Once on a chain without the phaser and chorus,
+    which has to null as tightly as the null tests do, and once on the whole
+    default chain with a looser tolerance, see LfoToleranceDecibels.
+
+    Every processBlock() call is timed as well. None may take longer than
+    its samples last, and the processor's own worstCallbackLoad and
+    numCallbackOverruns have to agree with what the test measured.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "TestHelpers.h"
+
+using Processor = JUCE_MultiFX_ProcessorAudioProcessor;
+using DSP_Option = Processor::DSP_Option;
+
+struct HostSimulationTest : juce::UnitTest
+{
+    HostSimulationTest() : juce::UnitTest("Host simulation", "Host") {}
+
+    static constexpr int PreparedBlockSize = 512;
+    static constexpr double ImpulseResponseSampleRate = 48000.0;
+    static constexpr int NumSamples = 24000;
+
+    // The largest difference a render may have from the fixed block one
+    static constexpr float ToleranceDecibels = -80.f;
+
+    /*
+    The same, for chains with the phaser or chorus. juce::dsp::Phaser steps
+    its LFO once every few samples and rounds each block up to a whole step,
+    so where the blocks fall moves its sweep a little, and the chorus after it
+    carries that on. The difference stays far below the signal but well above
+    ToleranceDecibels, and it isn't the host's doing.
+    */
+    static constexpr float LfoToleranceDecibels = -40.f;
+
+    // Blocks of random sizes, from empty up to twice the prepared size
+    static constexpr int NumRandomBlockSizes = 64;
+    static constexpr juce::int64 RandomBlockSizeSeed = 0x486f7374;
+
+    /*
+    The longest a callback may take, as a fraction of the time its samples
+    last. Debug builds, the TSan one among them, run several times slower, so
+    they only have to keep within a bound that still catches a hang. Every
+    callback gets CallbackAllowanceSeconds on top, which covers calls of a
+    handful of samples or none, where the fixed cost is all there is.
+    */
+   #if JUCE_DEBUG
+    static constexpr double MaxCallbackLoad = 10.0;
+   #else
+    static constexpr double MaxCallbackLoad = 1.0;
+   #endif
+    static constexpr double CallbackAllowanceSeconds = 0.002;
+
+    void runTest() override
+    {
+        juce::TemporaryFile impulseResponseFile(".wav");
+        impulseResponse = impulseResponseFile.getFile();
+        expect(TestHelpers::writeWav(impulseResponse, TestHelpers::makeImpulseResponse(), ImpulseResponseSampleRate),
+               "Couldn't write the impulse response");
+
+        juce::Random random(RandomBlockSizeSeed);
+        std::vector<int> randomBlockSizes;
+        for (int i = 0; i < NumRandomBlockSizes; ++i)
+            randomBlockSizes.push_back(random.nextInt(2 * PreparedBlockSize + 1));
+
+        for (const auto& chain : { makeChain(false), makeChain(true) })
+        {
+            beginTest(chain.name + ": odd block sizes");
+            expectMatchesFixedBlocks(chain, { 48000.0 }, { 1, 7, 333, 64, 511, 13 });
+
+            beginTest(chain.name + ": zero-length blocks");
+            expectMatchesFixedBlocks(chain, { 48000.0 }, { 0, 512, 0, 0, 100, 0, 37 });
+
+            beginTest(chain.name + ": blocks bigger than prepared");
+            expectMatchesFixedBlocks(chain, { 48000.0 }, { 2048, 1500, 4096, 513 });
+
+            beginTest(chain.name + ": random block sizes");
+            expectMatchesFixedBlocks(chain, { 48000.0 }, randomBlockSizes);
+
+            // The same processor prepared again each time, which has to leave nothing behind from the rate before
+            beginTest(chain.name + ": sample rate changes");
+            expectMatchesFixedBlocks(chain, { 48000.0, 96000.0, 44100.0 }, { 333, 0, 1024, 7 });
+
+            // Offline for the first third, realtime for the second, offline again for the last
+            beginTest(chain.name + ": switching between offline and realtime");
+            expectMatchesFixedBlocks(chain, { 48000.0 }, randomBlockSizes, true);
+        }
+
+        impulseResponse = juce::File();
+    }
+
+private:
+    juce::File impulseResponse;
+
+    struct Chain
+    {
+        juce::String name;
+        Processor::DSP_Order order;
+        float toleranceDecibels;
+    };
+
+    static Chain makeChain(bool withLfoModules)
+    {
+        if (withLfoModules)
+            return { "Default chain", Processor::makeDefaultOrder(), LfoToleranceDecibels };
+
+        Processor::DSP_Order order;
+        for (auto option : { DSP_Option::GeneralFilter, DSP_Option::Overdrive, DSP_Option::LadderFilter, DSP_Option::Delay, DSP_Option::Convolution })
+            order.add({ option, 0 });
+
+        return { "Without LFOs", order, ToleranceDecibels };
+    }
+
+    // What the test measured of the calls since the last prepare
+    struct CallbackTimes
+    {
+        double worstLoad = 0.0;
+        int numRealtimeOverruns = 0;
+        int numOverBound = 0;
+    };
+
+    void setUp(Processor& processor, const Chain& chain)
+    {
+        processor.setNonRealtime(true);
+        processor.setDspOrder(chain.order);
+        processor.loadImpulseResponse(0, impulseResponse);
+    }
+
+    void prepare(Processor& processor, double sampleRate)
+    {
+        processor.prepareToPlay(sampleRate, PreparedBlockSize);
+        expect(TestHelpers::waitForImpulseResponses(processor), "The impulse response didn't load in time");
+    }
+
+    // Goes round the block sizes until the whole buffer has been through, realtime over the middle third if asked
+    static CallbackTimes render(Processor& processor, double sampleRate, juce::AudioBuffer<float>& buffer,
+                                const std::vector<int>& blockSizes, bool switchRealtime = false)
+    {
+        CallbackTimes times;
+        juce::MidiBuffer midi;
+        size_t next = 0;
+
+        for (int start = 0; start < buffer.getNumSamples();)
+        {
+            const auto numSamples = juce::jmin(blockSizes[next], buffer.getNumSamples() - start);
+            next = (next + 1) % blockSizes.size();
+
+            if (switchRealtime)
+            {
+                const auto third = start * 3 / buffer.getNumSamples();
+                processor.setNonRealtime(third != 1);
+            }
+
+            juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start, numSamples);
+
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+            processor.processBlock(block, midi);
+            const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+            const auto duration = numSamples / sampleRate;
+            if (seconds > duration * MaxCallbackLoad + CallbackAllowanceSeconds)
+                ++times.numOverBound;
+
+            if (numSamples > 0)
+            {
+                const auto load = seconds / duration;
+                times.worstLoad = juce::jmax(times.worstLoad, load);
+
+                if (load > 1.0 && processor.isNonRealtime() == false)
+                    ++times.numRealtimeOverruns;
+            }
+
+            start += numSamples;
+        }
+
+        processor.setNonRealtime(true);
+        return times;
+    }
+
+    juce::AudioBuffer<float> renderFixedBlocks(const Chain& chain, double sampleRate, const juce::AudioBuffer<float>& input)
+    {
+        Processor processor;
+        setUp(processor, chain);
+        prepare(processor, sampleRate);
+
+        auto output = input;
+        render(processor, sampleRate, output, { PreparedBlockSize });
+        processor.releaseResources();
+        return output;
+    }
+
+    void expectMatchesFixedBlocks(const Chain& chain, std::initializer_list<double> sampleRates, const std::vector<int>& blockSizes,
+                                  bool switchRealtime = false)
+    {
+        const auto input = TestHelpers::makeNoise(2, NumSamples);
+        const auto hasOversizeBlocks = std::any_of(blockSizes.begin(), blockSizes.end(), [](int size) { return size > PreparedBlockSize; });
+
+        Processor processor;
+        setUp(processor, chain);
+
+        for (auto sampleRate : sampleRates)
+        {
+            prepare(processor, sampleRate);
+
+            auto output = input;
+            const auto times = render(processor, sampleRate, output, blockSizes, switchRealtime);
+            const auto at = "At " + juce::String(sampleRate) + " Hz ";
+
+            const auto residualDecibels = TestHelpers::getResidualDecibels(output, renderFixedBlocks(chain, sampleRate, input));
+            expect(residualDecibels <= chain.toleranceDecibels,
+                   at + "the render is " + juce::String(residualDecibels, 1) + " dB off the fixed block one");
+
+            if (hasOversizeBlocks)
+                expect(processor.numOversizeBlocks.get() > 0, "The oversize blocks weren't counted");
+
+            expectCallbackTimes(processor, times, at);
+        }
+
+        processor.releaseResources();
+    }
+
+    // The processor times less of each call than the test does, so it can't have seen anything slower
+    void expectCallbackTimes(const Processor& processor, const CallbackTimes& times, const juce::String& at)
+    {
+        expect(times.numOverBound == 0,
+               at + juce::String(times.numOverBound) + " callbacks took longer than " + juce::String(MaxCallbackLoad, 1) + " times their length");
+
+        const auto worstLoad = processor.worstCallbackLoad.get();
+        expect(worstLoad > 0.f, at + "the processor didn't time its callbacks");
+        expect(worstLoad <= times.worstLoad * 1.001 + 1.0e-6,
+               at + "the processor's worst callback load " + juce::String(worstLoad, 3) + " is above the measured " + juce::String(times.worstLoad, 3));
+
+        // Offline calls can't overrun, whatever they take
+        const auto numOverruns = processor.numCallbackOverruns.get();
+        expect(numOverruns <= times.numRealtimeOverruns,
+               at + "the processor counted " + juce::String(numOverruns) + " overruns, the test measured " + juce::String(times.numRealtimeOverruns));
+    }
+};
+
+static HostSimulationTest hostSimulationTest;
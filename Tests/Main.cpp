@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Runs the processor's tests outside a host, returns 1 when any fail.
+
+        ModularFXTests [--category <name>] [--references <dir>] [--record]
+
+    --references defaults to Tests/References under the working directory.
+    --record writes the null test references from this build, run it on a
+    build whose output is known to be right. Without it a missing reference
+    fails like a render that doesn't null.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "TestOptions.h"
+
+TestOptions& TestOptions::get()
+{
+    static TestOptions options;
+    return options;
+}
+
+int main(int argc, char* argv[])
+{
+    // The processor's parameters and async updates want a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList args(argc, argv);
+
+    auto& options = TestOptions::get();
+    options.record = args.containsOption("--record");
+
+    auto references = args.getValueForOption("--references");
+    options.referenceDirectory = juce::File::getCurrentWorkingDirectory()
+                                     .getChildFile(references.isNotEmpty() ? references : "Tests/References");
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+
+    auto category = args.getValueForOption("--category");
+    if (category.isNotEmpty())
+        runner.runTestsInCategory(category);
+    else
+        runner.runAllTests();
+
+    int failures = 0;
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        failures += runner.getResult(i)->failures;
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,331 @@
+/*
+  ==============================================================================
+
+    NullTests.cpp
+
+    Golden output checks. Fixed signals (an impulse, a logarithmic sweep and
+    seeded noise) are rendered offline through processBlock() on a fresh
+    processor each time:
+    - with an empty chain and with each module bypassed, which must null
+      against the input itself
+    - through each module on its own
+    - through every ordered pair of modules, in every combination of bypasses
+    - through the default chain and the same chain reversed
+    - through a fixed, seeded sample of longer chains in random orders
+
+    Every permutation of every length would be close to 14,000 chains before
+    bypasses, so past the pairs only a sample is rendered. The seed is fixed
+    so the sample, and the reference names, are the same every run.
+
+    Renders are nulled against the reference WAV of the same name. With
+    --record the references are written instead, a missing one otherwise
+    fails. The references aren't in the repository yet: record them once on
+    a build whose output has been checked by ear and commit Tests/References. The Convolution module loads a fixed response written here, long
+    enough to reach its head, body and tail. SimdKernels::verify() runs too,
+    for the vector kernels against the scalar ones.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "TestHelpers.h"
+#include "TestOptions.h"
+
+using Processor = JUCE_MultiFX_ProcessorAudioProcessor;
+using DSP_Option = Processor::DSP_Option;
+
+// File names, so no spaces
+static juce::String getOptionName(DSP_Option option)
+{
+    switch (option)
+    {
+    case DSP_Option::Phase:         return "Phaser";
+    case DSP_Option::Chorus:        return "Chorus";
+    case DSP_Option::Overdrive:     return "Overdrive";
+    case DSP_Option::LadderFilter:  return "LadderFilter";
+    case DSP_Option::GeneralFilter: return "GeneralFilter";
+    case DSP_Option::Delay:         return "Delay";
+    case DSP_Option::Convolution:   return "Convolution";
+    case DSP_Option::END_OF_LIST:   break;
+    }
+    jassertfalse;
+    return {};
+}
+
+static juce::String getOrderName(const Processor::DSP_Order& order)
+{
+    juce::StringArray names;
+    for (const auto& slot : order)
+        names.add(getOptionName(slot.option));
+
+    return names.joinIntoString("-");
+}
+
+struct Signal
+{
+    juce::String name;
+    juce::AudioBuffer<float> buffer;
+};
+
+static std::vector<Signal> makeSignals(double sampleRate, int numSamples)
+{
+    std::vector<Signal> signals;
+
+    // Offset on the right, so swapped channels don't null
+    juce::AudioBuffer<float> impulse(2, numSamples);
+    impulse.clear();
+    impulse.setSample(0, 0, 1.f);
+    impulse.setSample(1, 100, 1.f);
+    signals.push_back({ "impulse", impulse });
+
+    // 20 Hz to 20 kHz, the right channel inverted and 6 dB down
+    juce::AudioBuffer<float> sweep(2, numSamples);
+    const auto ratio = std::log(20000.0 / 20.0);
+    const auto length = numSamples / sampleRate;
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const auto t = i / sampleRate;
+        const auto phase = juce::MathConstants<double>::twoPi * 20.0 * length / ratio * (std::exp(ratio * t / length) - 1.0);
+        const auto x = static_cast<float>(0.5 * std::sin(phase));
+        sweep.setSample(0, i, x);
+        sweep.setSample(1, i, -0.5f * x);
+    }
+    signals.push_back({ "sweep", sweep });
+
+    signals.push_back({ "noise", TestHelpers::makeNoise(2, numSamples) });
+
+    return signals;
+}
+
+static bool readReference(const juce::File& file, juce::AudioBuffer<float>& buffer)
+{
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatReader> reader(wav.createReaderFor(file.createInputStream().release(), true));
+    if (reader == nullptr)
+        return false;
+
+    const auto numSamples = static_cast<int>(reader->lengthInSamples);
+    buffer.setSize(static_cast<int>(reader->numChannels), numSamples);
+    return reader->read(&buffer, 0, numSamples, 0, true, true);
+}
+
+//==============================================================================
+struct NullTests : juce::UnitTest
+{
+    NullTests() : juce::UnitTest("Null tests", "Null") {}
+
+    static constexpr double SampleRate = 48000.0;
+    static constexpr int NumSamples = 48000;
+    static constexpr int BlockSize = 512;
+
+    // The pairs are many, so they get a shorter stretch of the noise
+    static constexpr int NumPairSamples = 12000;
+
+    // The largest difference a render may have from its reference
+    static constexpr float ToleranceDecibels = -80.f;
+
+    // Longer chains in random orders, from three modules up to all of them
+    static constexpr int NumRandomChains = 24;
+    static constexpr juce::int64 RandomChainSeed = 0x4e756c6c;
+
+    void runTest() override
+    {
+        beginTest("SIMD kernels");
+        expect(SimdKernels::verify(), "The vector kernels don't match the scalar ones");
+
+        juce::TemporaryFile impulseResponseFile(".wav");
+        impulseResponse = impulseResponseFile.getFile();
+        expect(TestHelpers::writeWav(impulseResponse, TestHelpers::makeImpulseResponse(), SampleRate), "Couldn't write the impulse response");
+
+        auto& options = TestOptions::get();
+        if (options.record)
+            options.referenceDirectory.createDirectory();
+
+        logMessage((options.record ? "Recording references in " : "References in ") + options.referenceDirectory.getFullPathName());
+
+        // Every render would fail on its own, one failure says why
+        if (options.record == false && options.referenceDirectory.isDirectory() == false)
+        {
+            beginTest("References");
+            expect(false, "There are no references in " + options.referenceDirectory.getFullPathName() + ", record them with --record");
+            return;
+        }
+
+        const auto signals = makeSignals(SampleRate, NumSamples);
+
+        beginTest("Empty chain and single modules");
+        for (const auto& signal : signals)
+        {
+            expectNulls("empty_" + signal.name, render({}, 0, signal.buffer), signal.buffer);
+
+            for (size_t i = 0; i < Processor::NumOptions; ++i)
+            {
+                Processor::DSP_Order order;
+                order.add({ static_cast<DSP_Option>(i), 0 });
+
+                const auto name = getOrderName(order);
+                const auto output = render(order, 0, signal.buffer);
+
+                // Bypassed is bit for bit the input, none of these modules add latency by default
+                expectNulls(name + "_bypassed_" + signal.name, render(order, 1, signal.buffer), signal.buffer);
+                expectMatchesReference(name + "_" + signal.name, output);
+
+                // Fully wet by default, so the same as the input means the response never arrived
+                if (order[0].option == DSP_Option::Convolution)
+                    expect(TestHelpers::getResidualDecibels(output, signal.buffer) > ToleranceDecibels, "The impulse response wasn't applied");
+            }
+        }
+
+        juce::AudioBuffer<float> noise(2, NumPairSamples);
+        for (int ch = 0; ch < noise.getNumChannels(); ++ch)
+            noise.copyFrom(ch, 0, signals.back().buffer, ch, 0, NumPairSamples);
+
+        beginTest("Module pairs");
+        for (size_t first = 0; first < Processor::NumOptions; ++first)
+        {
+            for (size_t second = 0; second < Processor::NumOptions; ++second)
+            {
+                if (first == second)
+                    continue;
+
+                Processor::DSP_Order order;
+                order.add({ static_cast<DSP_Option>(first), 0 });
+                order.add({ static_cast<DSP_Option>(second), 0 });
+
+                checkBypassCombinations(order, { 0, 1, 2, 3 }, noise);
+            }
+        }
+
+        beginTest("Default chain");
+        auto order = Processor::makeDefaultOrder();
+
+        Processor::DSP_Order reversed;
+        for (auto it = order.end(); it != order.begin();)
+            reversed.add(*--it);
+
+        // Everything on, every other module, and everything off
+        const auto allBypassed = (1 << order.size()) - 1;
+        checkBypassCombinations(order, { 0, 0x55 & allBypassed, allBypassed }, noise);
+        checkBypassCombinations(reversed, { 0, 0x55 & allBypassed, allBypassed }, noise);
+
+        beginTest("Random longer chains");
+        juce::Random random(RandomChainSeed);
+        for (int i = 0; i < NumRandomChains; ++i)
+        {
+            const auto chain = makeRandomOrder(random);
+
+            // Everything on and one random mix of bypasses, which leaves at least one module running
+            const auto chainBypassed = (1 << chain.size()) - 1;
+            checkBypassCombinations(chain, { 0, 1 + random.nextInt(chainBypassed - 1) }, noise);
+        }
+
+        impulseResponse = juce::File();
+    }
+
+private:
+    juce::File impulseResponse;
+
+    // A shuffle of the modules cut to a random length, each at instance 0
+    static Processor::DSP_Order makeRandomOrder(juce::Random& random)
+    {
+        std::array<size_t, Processor::NumOptions> options {};
+        std::iota(options.begin(), options.end(), size_t { 0 });
+
+        // Fisher-Yates on juce::Random, whose sequence is the same on every platform
+        for (auto i = options.size() - 1; i > 0; --i)
+            std::swap(options[i], options[static_cast<size_t>(random.nextInt(static_cast<int>(i) + 1))]);
+
+        const auto length = 3 + random.nextInt(static_cast<int>(Processor::NumOptions) - 2);
+
+        Processor::DSP_Order order;
+        for (int i = 0; i < length; ++i)
+            order.add({ static_cast<DSP_Option>(options[static_cast<size_t>(i)]), 0 });
+
+        return order;
+    }
+
+    // On a fresh processor, so nothing carries over from the render before. Bit i of bypassMask bypasses slot i
+    juce::AudioBuffer<float> render(const Processor::DSP_Order& order, int bypassMask, const juce::AudioBuffer<float>& input)
+    {
+        Processor processor;
+        processor.setNonRealtime(true);
+
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            const auto bypassed = ((bypassMask >> i) & 1) != 0;
+            processor.getBypassParam(order[i].option, order[i].instance)->setValueNotifyingHost(bypassed ? 1.f : 0.f);
+
+            if (order[i].option == DSP_Option::Convolution)
+                processor.loadImpulseResponse(order[i].instance, impulseResponse);
+        }
+
+        processor.setDspOrder(order);
+        processor.prepareToPlay(SampleRate, BlockSize);
+
+        expect(TestHelpers::waitForImpulseResponses(processor), "The impulse response didn't load in time");
+
+        auto output = input;
+        juce::MidiBuffer midi;
+        for (int start = 0; start < output.getNumSamples(); start += BlockSize)
+        {
+            const auto numSamples = juce::jmin(BlockSize, output.getNumSamples() - start);
+            juce::AudioBuffer<float> block(output.getArrayOfWritePointers(), output.getNumChannels(), start, numSamples);
+            processor.processBlock(block, midi);
+        }
+
+        processor.releaseResources();
+        return output;
+    }
+
+    // The mask with every slot bypassed nulls against the input, the others against references
+    void checkBypassCombinations(const Processor::DSP_Order& order, std::initializer_list<int> masks, const juce::AudioBuffer<float>& input)
+    {
+        const auto allBypassed = (1 << order.size()) - 1;
+
+        for (auto mask : masks)
+        {
+            const auto name = getOrderName(order) + "_bypass" + juce::String(mask) + "_noise";
+            const auto output = render(order, mask, input);
+
+            if (mask == allBypassed)
+                expectNulls(name, output, input);
+            else
+                expectMatchesReference(name, output);
+        }
+    }
+
+    void expectNulls(const juce::String& name, const juce::AudioBuffer<float>& output, const juce::AudioBuffer<float>& expected)
+    {
+        const auto residualDecibels = TestHelpers::getResidualDecibels(output, expected);
+        expect(residualDecibels <= ToleranceDecibels, name + " is " + juce::String(residualDecibels, 1) + " dB off");
+    }
+
+    void expectMatchesReference(const juce::String& name, const juce::AudioBuffer<float>& output)
+    {
+        const auto& options = TestOptions::get();
+        const auto file = options.referenceDirectory.getChildFile(name + ".wav");
+
+        if (options.record)
+        {
+            expect(TestHelpers::writeWav(file, output, SampleRate), "Couldn't record " + file.getFullPathName());
+            return;
+        }
+
+        if (file.existsAsFile() == false)
+        {
+            expect(false, "No reference for " + name + ", record them with --record");
+            return;
+        }
+
+        juce::AudioBuffer<float> reference;
+        if (readReference(file, reference) == false)
+        {
+            expect(false, "Couldn't read " + file.getFullPathName());
+            return;
+        }
+
+        expectNulls(name, output, reference);
+    }
+};
+
+static NullTests nullTests;
@@ -0,0 +1,188 @@
+/*
+  ==============================================================================
+
+    StressTest.cpp
+
+    Runs processBlock() on its own thread while the message thread restores
+    state, stores and recalls snapshots and changes the chain order as fast
+    as it can, without waiting for the audio thread to catch up. Two more
+    threads set parameters the way hosts do from their own threads: one any
+    parameter to any value, the other the module and band bypasses. On its
+    own this only catches crashes and output that goes non-finite. The TSan configuration of the Linux exporter builds with
+    -fsanitize=thread, so that any data race between the two threads fails
+    the run as well.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Source/PluginProcessor.h"
+
+using Processor = JUCE_MultiFX_ProcessorAudioProcessor;
+using DSP_Option = Processor::DSP_Option;
+
+struct StressTest : juce::UnitTest
+{
+    StressTest() : juce::UnitTest("Stress test", "Stress") {}
+
+    static constexpr double SampleRate = 48000.0;
+    static constexpr int BlockSize = 512;
+    static constexpr int DurationMs = 5000;
+
+    void runTest() override
+    {
+        beginTest("State, snapshot, order and parameter changes against processBlock");
+
+        Processor processor;
+        processor.prepareToPlay(SampleRate, BlockSize);
+
+        // One state as it comes up, one after a few changes, so restoring them changes something
+        juce::MemoryBlock initialState, changedState;
+        processor.getStateInformation(initialState);
+
+        auto random = getRandom();
+        processor.setDspOrder(makeRandomOrder(random));
+        processor.getBypassParam(DSP_Option::Delay, 0)->setValueNotifyingHost(1.f);
+        processor.getStateInformation(changedState);
+
+        AudioThread audioThread(processor);
+        audioThread.startThread(juce::Thread::Priority::high);
+
+        ParameterThread parameterThread(processor, false), bypassThread(processor, true);
+        parameterThread.startThread();
+        bypassThread.startThread();
+
+        int numChanges = 0;
+        const auto end = juce::Time::getMillisecondCounter() + static_cast<juce::uint32>(DurationMs);
+        while (juce::Time::getMillisecondCounter() < end)
+        {
+            switch (random.nextInt(4))
+            {
+            case 0:
+            {
+                const auto& state = random.nextBool() ? initialState : changedState;
+                processor.setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+                break;
+            }
+            case 1:
+                processor.storeSnapshot(random.nextInt(Processor::NumSnapshots));
+                break;
+            case 2:
+                processor.recallSnapshot(random.nextInt(Processor::NumSnapshots));
+                break;
+            default:
+                processor.setDspOrder(makeRandomOrder(random));
+                break;
+            }
+
+            ++numChanges;
+        }
+
+        parameterThread.stopThread(2000);
+        bypassThread.stopThread(2000);
+        audioThread.stopThread(2000);
+        processor.releaseResources();
+
+        logMessage(juce::String(numChanges) + " changes, " + juce::String(parameterThread.numChanges.load()) + " parameter and "
+                   + juce::String(bypassThread.numChanges.load()) + " bypass changes over " + juce::String(audioThread.numBlocks.load()) + " blocks");
+
+        expect(audioThread.numBlocks.load() > 0, "The audio thread never ran");
+        expect(audioThread.allFinite.load(), "The output went non-finite");
+    }
+
+private:
+    struct AudioThread : juce::Thread
+    {
+        explicit AudioThread(Processor& p) : juce::Thread("Stress Test Audio"), processor(p) {}
+
+        void run() override
+        {
+            juce::AudioBuffer<float> buffer(2, BlockSize);
+            juce::MidiBuffer midi;
+            juce::Random random(0x5eed);
+
+            while (threadShouldExit() == false)
+            {
+                for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                    for (int i = 0; i < buffer.getNumSamples(); ++i)
+                        buffer.setSample(ch, i, (random.nextFloat() * 2.f - 1.f) * 0.5f);
+
+                processor.processBlock(buffer, midi);
+
+                for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                    for (int i = 0; i < buffer.getNumSamples(); ++i)
+                        if (std::isfinite(buffer.getSample(ch, i)) == false)
+                            allFinite = false;
+
+                ++numBlocks;
+            }
+        }
+
+        Processor& processor;
+        std::atomic<int> numBlocks { 0 };
+        std::atomic<bool> allFinite { true };
+    };
+
+    // Sets random parameters, or only the bypasses, from a thread that is neither the message nor the audio thread
+    struct ParameterThread : juce::Thread
+    {
+        ParameterThread(Processor& p, bool onlyBypasses)
+            : juce::Thread(onlyBypasses ? "Stress Test Bypasses" : "Stress Test Parameters"),
+              processor(p),
+              random(onlyBypasses ? 0xb1a5 : 0x9a7a)
+        {
+            if (onlyBypasses)
+            {
+                for (size_t option = 0; option < Processor::NumOptions; ++option)
+                    for (int instance = 0; instance < Processor::NumModuleInstances; ++instance)
+                        parameters.push_back(processor.getBypassParam(static_cast<DSP_Option>(option), instance));
+
+                for (auto* bypass : processor.bandBypasses)
+                    parameters.push_back(bypass);
+            }
+            else
+            {
+                for (auto* parameter : processor.getParameters())
+                    parameters.push_back(parameter);
+            }
+        }
+
+        void run() override
+        {
+            while (threadShouldExit() == false)
+            {
+                auto* parameter = parameters[static_cast<size_t>(random.nextInt(static_cast<int>(parameters.size())))];
+                parameter->setValueNotifyingHost(random.nextFloat());
+                ++numChanges;
+            }
+        }
+
+        Processor& processor;
+        juce::Random random;
+        std::vector<juce::AudioProcessorParameter*> parameters;
+        std::atomic<int> numChanges { 0 };
+    };
+
+    // Any modules in any order, up to a full chain
+    static Processor::DSP_Order makeRandomOrder(juce::Random& random)
+    {
+        std::vector<Processor::ChainSlot> slots;
+        for (size_t option = 0; option < Processor::NumOptions; ++option)
+            for (int instance = 0; instance < Processor::NumModuleInstances; ++instance)
+                slots.push_back({ static_cast<DSP_Option>(option), instance });
+
+        Processor::DSP_Order order;
+        const auto length = random.nextInt(static_cast<int>(Processor::MaxChainLength) + 1);
+
+        while (order.size() < static_cast<size_t>(length))
+        {
+            const auto index = static_cast<size_t>(random.nextInt(static_cast<int>(slots.size())));
+            order.add(slots[index]);
+            slots.erase(slots.begin() + static_cast<std::ptrdiff_t>(index));
+        }
+
+        return order;
+    }
+};
+
+static StressTest stressTest;
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    TestHelpers.cpp
+
+  ==============================================================================
+*/
+
+#include "TestHelpers.h"
+
+juce::AudioBuffer<float> TestHelpers::makeNoise(int numChannels, int numSamples, juce::int64 seed)
+{
+    juce::AudioBuffer<float> noise(numChannels, numSamples);
+    juce::Random random(seed);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int i = 0; i < numSamples; ++i)
+            noise.setSample(ch, i, (random.nextFloat() * 2.f - 1.f) * 0.5f);
+
+    return noise;
+}
+
+juce::AudioBuffer<float> TestHelpers::makeImpulseResponse()
+{
+    auto buffer = makeNoise(1, ImpulseResponseSamples, 0x1f);
+
+    const auto decay = std::log(0.001) / ImpulseResponseSamples;
+    for (int i = 0; i < ImpulseResponseSamples; ++i)
+        buffer.setSample(0, i, static_cast<float>(std::exp(decay * i)) * buffer.getSample(0, i));
+
+    buffer.setSample(0, 0, 1.f);
+    return buffer;
+}
+
+bool TestHelpers::writeWav(const juce::File& file, const juce::AudioBuffer<float>& buffer, double sampleRate)
+{
+    file.deleteFile();
+    std::unique_ptr<juce::OutputStream> stream(file.createOutputStream());
+    if (stream == nullptr)
+        return false;
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate,
+                                                                        static_cast<unsigned int>(buffer.getNumChannels()),
+                                                                        32, {}, 0));
+    if (writer == nullptr)
+        return false;
+
+    stream.release(); // The writer owns it now
+    return writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+}
+
+float TestHelpers::getResidualDecibels(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+{
+    if (a.getNumChannels() != b.getNumChannels() || a.getNumSamples() != b.getNumSamples())
+        return 0.f;
+
+    auto peak = 0.f;
+    for (int ch = 0; ch < a.getNumChannels(); ++ch)
+    {
+        const auto* x = a.getReadPointer(ch);
+        const auto* y = b.getReadPointer(ch);
+        for (int i = 0; i < a.getNumSamples(); ++i)
+        {
+            const auto difference = std::abs(x[i] - y[i]);
+            if (std::isfinite(difference) == false)
+                return 0.f;
+
+            peak = juce::jmax(peak, difference);
+        }
+    }
+
+    return juce::Decibels::gainToDecibels(peak, -200.f);
+}
+
+bool TestHelpers::waitForImpulseResponses(const JUCE_MultiFX_ProcessorAudioProcessor& processor, int timeoutMs)
+{
+    // They load in the background once the processor knows its rate
+    const auto deadline = juce::Time::getMillisecondCounter() + static_cast<juce::uint32>(timeoutMs);
+    while (processor.isLoadingImpulseResponses() && juce::Time::getMillisecondCounter() < deadline)
+        juce::Thread::sleep(1);
+
+    return processor.isLoadingImpulseResponses() == false;
+}
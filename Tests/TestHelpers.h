@@ -0,0 +1,36 @@
+/*
+  ==============================================================================
+
+    TestHelpers.h
+
+    Signals, files and comparisons the tests share.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../Source/PluginProcessor.h"
+
+struct TestHelpers
+{
+    // Reaches past ConvolutionSetup::TailStart, so every stage of the convolver runs
+    static constexpr int ImpulseResponseSamples = 4096;
+    static constexpr int LoadTimeoutMs = 10000;
+
+    // Seeded, uniform and 6 dB below full scale, the channels one after the other from the same generator
+    static juce::AudioBuffer<float> makeNoise(int numChannels, int numSamples, juce::int64 seed = 0x5eed);
+
+    // Seeded noise decaying by 60 dB over its length, behind a unit first tap
+    static juce::AudioBuffer<float> makeImpulseResponse();
+
+    // 32 bit, which WavAudioFormat writes as float, so the file is exactly what was rendered
+    static bool writeWav(const juce::File& file, const juce::AudioBuffer<float>& buffer, double sampleRate);
+
+    // The peak of the difference, 0 dB when the shapes don't match or anything isn't finite
+    static float getResidualDecibels(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b);
+
+    // Returns false if the processor's impulse responses are still loading after the timeout
+    static bool waitForImpulseResponses(const JUCE_MultiFX_ProcessorAudioProcessor& processor, int timeoutMs = LoadTimeoutMs);
+};
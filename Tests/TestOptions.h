@@ -0,0 +1,24 @@
+/*
+  ==============================================================================
+
+    TestOptions.h
+
+    What the command line asked of the tests, set by main() before they run.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct TestOptions
+{
+    // Where the null tests keep their reference renders
+    juce::File referenceDirectory;
+
+    // Write every reference from this build instead of checking against it
+    bool record = false;
+
+    static TestOptions& get();
+};